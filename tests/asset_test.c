@@ -0,0 +1,284 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../wpgasset.h"
+#include "../wpgbuffer.h"
+#include "../wpglayout.h"
+#include "../wpglib.h"
+
+// XXH64 reference vectors, fingerprinted names, and rewriting of grid hrefs
+// and layout references to fingerprinted paths:
+//     ./asset_test
+
+struct HashCase {
+	const char *text;	// NULL hashes bytes 0, 1, 2, ... starting at offset instead
+	size_t offset;		// odd offsets read every lane unaligned
+	size_t length;
+	unsigned long long seed;
+	unsigned long long expected;
+};
+
+// Published XXH64 values, and lengths that reach every tail path (8, 4 and 1
+// byte steps) on either side of the 32 byte stripe.
+static const struct HashCase hash_cases[] = {
+	{ "", 0, 0, 0, 0xef46db3751d8e999ULL },
+	{ "a", 0, 1, 0, 0xd24ec4f1a98c6e5bULL },
+	{ "abc", 0, 3, 0, 0x44bc2cf5ad770999ULL },
+	{ "xxhash", 0, 6, 0, 0x32dd38952c4bc720ULL },
+	{ "xxhash", 0, 6, 20141025, 0xb559b98d844e0635ULL },
+	{ "Nobody inspects the spammish repetition", 0, 39, 0, 0xfbcea83c8a378bf1ULL },
+	{ NULL, 0, 31, 0, 0xc346d2b59b4d8ee1ULL },
+	{ NULL, 0, 32, 0, 0xcbf59c5116ff32b4ULL },
+	{ NULL, 0, 100, 0x9e3779b185ebca87ULL, 0x00278bda0ee3f586ULL },
+	{ NULL, 0, 512, 0, 0x7b3bfcaac0348ac0ULL },
+	{ NULL, 1, 64, 0, 0x9ab06ffb4eee2f86ULL },
+	{ NULL, 3, 47, 7, 0x745736d51155fa20ULL }
+};
+
+struct AssetFile {
+	const char *path;
+	const char *contents;
+};
+
+static const struct AssetFile asset_files[] = {
+	{ "css/site.css", "body { margin: 0; }\n" },
+	{ "img/logo.png", "\x89PNG not really" },
+	{ "js/app", "console.log(1);\n" },
+	{ "fonts/.hidden", "" }
+};
+
+#define ASSET_FILES (sizeof(asset_files) / sizeof(asset_files[0]))
+
+struct HrefCase {
+	const char *href;
+	const char *expected;	// with each "%s" replaced by that asset's fingerprinted path, in order
+	size_t assets[2];	// indexes into asset_files for each "%s"
+};
+
+// Hrefs on a grid page at "blog/index.html".
+static const struct HrefCase href_cases[] = {
+	{ "../css/site.css", "/%s", { 0 } },
+	{ "/img/logo.png?v=2#top", "/%s?v=2#top", { 1 } },
+	{ "../js/app", "/%s", { 2 } },
+	{ "post.html", "post.html", { 0 } },
+	{ "https://cdn.example.com/css/site.css", "https://cdn.example.com/css/site.css", { 0 } },
+	{ "//cdn.example.com/css/site.css", "//cdn.example.com/css/site.css", { 0 } }
+};
+
+// Only root relative href and src values are rewritten in the layout.
+static const struct HrefCase layout_cases[] = {
+	{ "<link rel=\"stylesheet\" href=\"/css/site.css\"><script src=\"/js/app?x=1\"></script>",
+	  "<link rel=\"stylesheet\" href=\"/%s\"><script src=\"/%s?x=1\"></script>", { 0, 2 } },
+	{ "<a href=\"//cdn.example.com/css/site.css\"><img src=\"/missing.png\"><a href=\"css/site.css\">",
+	  "<a href=\"//cdn.example.com/css/site.css\"><img src=\"/missing.png\"><a href=\"css/site.css\">", { 0 } },
+	{ "<img src=\"/img/logo.png#frag\" alt=\"\"><link href=\"/css/site.css\">",
+	  "<img src=\"/%s#frag\" alt=\"\"><link href=\"/%s\">", { 1, 0 } },
+	{ "<a href=\"/css/site.css", "<a href=\"/css/site.css", { 0 } }
+};
+
+static int test_remove_entry(const char *path, const struct stat *status, int type, struct FTW *walk) {
+	(void) status;
+	(void) type;
+	(void) walk;
+	return remove(path);
+}
+
+static bool test_write_file(const char *directory, const char *path, const char *contents) {
+	char file_path[4096];
+	snprintf(file_path, sizeof(file_path), "%s/%s", directory, path);
+	char *slash = strrchr(file_path, '/');
+	*slash = '\0';
+	mkdir(file_path, 0755);
+	*slash = '/';
+
+	FILE *output = fopen(file_path, "wb");
+	if (output == NULL)
+		return false;
+	bool written = fwrite(contents, 1, strlen(contents), output) == strlen(contents);
+	return fclose(output) == 0 && written;
+}
+
+static bool check_hash(const struct HashCase *test, const unsigned char *pattern) {
+	const void *data = test->text != NULL ? (const void*) test->text : (const void*) (pattern + test->offset);
+	unsigned long long hash = asset_hash(data, test->length, test->seed);
+	if (hash != test->expected) {
+		fprintf(stderr, "[check_hash] %zu bytes at offset %zu with seed %llu hashed to %016llx, expected %016llx.\n",
+			test->length, test->offset, test->seed, hash, test->expected);
+		return false;
+	}
+	return true;
+}
+
+// The name an asset should be given: its hash inserted before the extension.
+static void test_fingerprinted(const struct AssetFile *file, char *fingerprinted, size_t fingerprinted_size) {
+	unsigned long long hash = asset_hash(file->contents, strlen(file->contents), 0);
+	const char *name = strrchr(file->path, '/') + 1;
+	const char *extension = strrchr(name, '.');
+	if (extension == NULL || extension == name)
+		extension = name + strlen(name);
+	snprintf(fingerprinted, fingerprinted_size, "%.*s.%016llx%s", (int) (extension - file->path), file->path, hash, extension);
+}
+
+static void test_expand(const struct HrefCase *test, char fingerprinted[][256], char *expected, size_t expected_size) {
+	snprintf(expected, expected_size, test->expected, fingerprinted[test->assets[0]], fingerprinted[test->assets[1]]);
+}
+
+static bool check_fingerprints(struct AssetSet *set, const char *output_directory, char fingerprinted[][256]) {
+	bool passed = true;
+	for (size_t i = 0; i < ASSET_FILES; i++) {
+		test_fingerprinted(&asset_files[i], fingerprinted[i], 256);
+		char root_relative[512];
+		snprintf(root_relative, sizeof(root_relative), "/%s", asset_files[i].path);
+		const char *lookup = asset_set_lookup(set, root_relative);
+		if (lookup == NULL || strcmp(lookup, fingerprinted[i]) != 0 || !asset_set_contains(set, fingerprinted[i])) {
+			fprintf(stderr, "[check_fingerprints] \"%s\" was fingerprinted as \"%s\", expected \"%s\".\n",
+				asset_files[i].path, lookup != NULL ? lookup : "(NULL)", fingerprinted[i]);
+			passed = false;
+			continue;
+		}
+
+		// The copy holds the source bytes under the fingerprinted name
+		char copy_path[4096];
+		char copied[256] = { 0 };
+		snprintf(copy_path, sizeof(copy_path), "%s/%s", output_directory, fingerprinted[i]);
+		FILE *copy = fopen(copy_path, "rb");
+		if (copy != NULL) {
+			copied[fread(copied, 1, sizeof(copied) - 1, copy)] = '\0';
+			fclose(copy);
+		}
+		if (copy == NULL || strcmp(copied, asset_files[i].contents) != 0) {
+			fprintf(stderr, "[check_fingerprints] \"%s\" was not copied to \"%s\".\n", asset_files[i].path, copy_path);
+			passed = false;
+		}
+	}
+
+	if (asset_set_lookup(set, "css/missing.css") != NULL || asset_set_contains(set, "css/site.0000000000000000.css")) {
+		fprintf(stderr, "[check_fingerprints] A path that is not an asset was found in the set.\n");
+		passed = false;
+	}
+	return passed;
+}
+
+static bool check_rewrite_pages(struct AssetSet *set, char fingerprinted[][256]) {
+	size_t cases_length = sizeof(href_cases) / sizeof(href_cases[0]);
+	struct Page *pages[2] = {
+		page_create(PAGETYPE_GRID_LANDING, "Blog", "blog/index.html"),
+		page_create(PAGETYPE_ARTICLE, "Post", "blog/post.html")
+	};
+	bool passed = pages[0] != NULL && pages[1] != NULL &&
+		article_page_set_body(pages[1]->page_data, "<a href=\"../css/site.css\">", 26) == STRING_ERROR_NONE;
+	for (size_t i = 0; passed && i < cases_length; i++)
+		passed = grid_page_add(pages[0]->page_data, (char*) href_cases[i].href, "Item") == GRID_PAGE_ERROR_NONE;
+	passed = passed && asset_rewrite_pages(set, pages, 2) == ASSET_ERROR_NONE;
+
+	for (size_t i = 0; passed && i < cases_length; i++) {
+		char expected[512];
+		test_expand(&href_cases[i], fingerprinted, expected, sizeof(expected));
+		const char *href = ((struct GridPage*) pages[0]->page_data)->grid_items[i].href->data;
+		if (strcmp(href, expected) != 0) {
+			fprintf(stderr, "[check_rewrite_pages] \"%s\" was rewritten to \"%s\", expected \"%s\".\n", href_cases[i].href, href, expected);
+			passed = false;
+		}
+	}
+
+	// Article bodies are left as they are
+	if (passed && strcmp(((struct ArticlePage*) pages[1]->page_data)->body->data, "<a href=\"../css/site.css\">") != 0) {
+		fprintf(stderr, "[check_rewrite_pages] The article body was rewritten.\n");
+		passed = false;
+	}
+
+	for (size_t i = 0; i < 2; i++) {
+		if (pages[i] != NULL)
+			page_destroy(pages[i]);
+	}
+	return passed;
+}
+
+static bool check_rewrite_layout(struct AssetSet *set, char fingerprinted[][256], const struct HrefCase *test) {
+	struct Layout *layout = layout_create(NULL, NULL, NULL, NULL);
+	if (layout == NULL)
+		return false;
+
+	// The same markup in the head and the tail, which are rewritten alike
+	buffer_clear(&(layout->head));
+	buffer_clear(&(layout->tail));
+	bool passed = buffer_append_cstring(&(layout->head), test->href) == BUFFER_ERROR_NONE &&
+		buffer_append_cstring(&(layout->tail), test->href) == BUFFER_ERROR_NONE &&
+		asset_rewrite_layout(set, layout) == ASSET_ERROR_NONE;
+
+	char expected[1024];
+	test_expand(test, fingerprinted, expected, sizeof(expected));
+	struct Buffer *parts[2] = { &(layout->head), &(layout->tail) };
+	for (size_t i = 0; passed && i < 2; i++) {
+		if (parts[i]->length != strlen(expected) || memcmp(parts[i]->data, expected, parts[i]->length) != 0) {
+			fprintf(stderr, "[check_rewrite_layout] \"%s\" was rewritten to \"%.*s\", expected \"%s\".\n",
+				test->href, (int) parts[i]->length, parts[i]->data, expected);
+			passed = false;
+		}
+	}
+
+	layout_destroy(layout);
+	return passed;
+}
+
+int main() {
+	size_t hash_length = sizeof(hash_cases) / sizeof(hash_cases[0]);
+	size_t layout_length = sizeof(layout_cases) / sizeof(layout_cases[0]);
+	size_t total = hash_length + 2 + layout_length;
+	size_t failures = 0;
+
+	unsigned char pattern[520];
+	for (size_t i = 0; i < sizeof(pattern); i++)
+		pattern[i] = (unsigned char) i;
+	for (size_t i = 0; i < hash_length; i++) {
+		if (!check_hash(&hash_cases[i], pattern))
+			failures++;
+	}
+
+	char directory[] = "/tmp/wpg_asset_test_XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		fprintf(stderr, "[main] Failed to create a scratch directory.\n");
+		return 1;
+	}
+	char source_directory[4096];
+	char output_directory[4096];
+	snprintf(source_directory, sizeof(source_directory), "%s/source", directory);
+	snprintf(output_directory, sizeof(output_directory), "%s/output", directory);
+	mkdir(source_directory, 0755);
+	mkdir(output_directory, 0755);
+
+	struct AssetSet *set = asset_set_create(source_directory);
+	bool ready = set != NULL;
+	for (size_t i = 0; ready && i < ASSET_FILES; i++) {
+		ready = test_write_file(source_directory, asset_files[i].path, asset_files[i].contents) &&
+			asset_set_add(set, (char*) asset_files[i].path) == ASSET_ERROR_NONE;
+	}
+	ready = ready && asset_set_fingerprint(set, 2) == ASSET_ERROR_NONE &&
+		asset_set_copy(set, output_directory, 2) == ASSET_ERROR_NONE;
+
+	char fingerprinted[ASSET_FILES][256];
+	if (!ready) {
+		fprintf(stderr, "[main] Failed to fingerprint and copy the assets.\n");
+		failures += 2 + layout_length;
+	} else {
+		if (!check_fingerprints(set, output_directory, fingerprinted))
+			failures++;
+		if (!check_rewrite_pages(set, fingerprinted))
+			failures++;
+		for (size_t i = 0; i < layout_length; i++) {
+			if (!check_rewrite_layout(set, fingerprinted, &layout_cases[i]))
+				failures++;
+		}
+	}
+
+	if (set != NULL)
+		asset_set_destroy(set);
+	nftw(directory, test_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	printf("%zu/%zu asset cases passed\n", total - failures, total);
+	return failures == 0 ? 0 : 1;
+}
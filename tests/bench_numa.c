@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <dirent.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "../wpglib.h"
+#include "../wpgparallel.h"
+#include "../wpgsite.h"
+
+// Locality benchmark: builds a site of large articles the way a multi-socket
+// build host sees it, with every page allocated by the main thread and the
+// workers unpinned, then pinned, then with each page allocated by the pinned
+// worker that later renders it, and once more with hugepage-backed render
+// buffers on top. The pinned serial row separates the effect of pinning from
+// that of first touch. Each scenario runs in its own child process. Prints one
+// tab separated row per scenario:
+//     ./bench_numa [output_directory] [articles] [article_kilobytes] [threads]
+// On a single node machine the scenarios should come out about even; the
+// first touch rows are the ones expected to pull ahead as nodes are added.
+
+struct BenchScenario {
+	const char *name;
+	bool first_touch;	// pages allocated by their rendering worker rather than the main thread
+	bool pinned;		// workers pinned to processors for both allocation and render
+	bool hugepages;
+};
+
+struct BenchJob {
+	struct Page **pages;
+	const char *body;
+	size_t article_bytes;
+	bool failed;
+};
+
+struct BenchResult {
+	double generate_seconds;
+	double build_seconds;
+	size_t output_bytes;
+};
+
+static double bench_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static unsigned int bench_numa_nodes() {
+	DIR *directory = opendir("/sys/devices/system/node");
+	if (directory == NULL)
+		return 1;
+
+	unsigned int nodes = 0;
+	struct dirent *entry;
+	while ((entry = readdir(directory)) != NULL) {
+		if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9')
+			nodes++;
+	}
+	closedir(directory);
+	return nodes > 0 ? nodes : 1;
+}
+
+static void bench_create_range(size_t start, size_t end, unsigned int worker, void *context) {
+	(void) worker;
+	struct BenchJob *job = context;
+	for (size_t i = start; i < end; i++) {
+		char title[48], path[48];
+		snprintf(title, sizeof(title), "Article %zu", i);
+		snprintf(path, sizeof(path), "articles/%zu.html", i);
+		job->pages[i] = page_create(PAGETYPE_ARTICLE, title, path);
+		if (job->pages[i] == NULL || article_page_set_body(job->pages[i]->page_data, (char*) job->body, job->article_bytes) != STRING_ERROR_NONE)
+			job->failed = true;
+	}
+}
+
+static bool bench_build(const struct BenchScenario *scenario, const char *output_directory, size_t articles, size_t article_bytes, unsigned int threads, struct BenchResult *result) {
+	mkdir(output_directory, 0755);
+	struct Site *site = site_create((char*) output_directory, "https://bench.example.com");
+	if (site == NULL)
+		return false;
+	site->threads = threads;
+	site->hugepages = scenario->hugepages;
+	site->emit_sitemap = false;
+	site->emit_link_index = false;
+	parallel_pin_workers(scenario->pinned);
+
+	static const char paragraph[] = "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.</p>\n";
+	char *body = malloc(article_bytes + 1);
+	struct BenchJob job = { .pages = calloc(articles, sizeof(struct Page*)), .body = body, .article_bytes = article_bytes };
+	if (body == NULL || job.pages == NULL) {
+		free(body);
+		free(job.pages);
+		site_destroy(site);
+		return false;
+	}
+	for (size_t i = 0; i < article_bytes; i += sizeof(paragraph) - 1)
+		memcpy(body + i, paragraph, article_bytes - i < sizeof(paragraph) - 1 ? article_bytes - i : sizeof(paragraph) - 1);
+	body[article_bytes] = '\0';
+
+	// Same length and thread count as the render, so worker w creates exactly
+	// the pages it will render
+	double started = bench_now();
+	if (scenario->first_touch)
+		parallel_for(articles, threads, bench_create_range, &job);
+	else
+		bench_create_range(0, articles, 0, &job);
+	free(body);
+
+	bool success = !job.failed;
+	for (size_t i = 0; i < articles; i++) {
+		if (job.pages[i] == NULL)
+			continue;
+		if (success && site_add_page(site, job.pages[i]) == SITE_ERROR_NONE)
+			continue;
+		page_destroy(job.pages[i]);
+		success = false;
+	}
+	free(job.pages);
+	result->generate_seconds = bench_now() - started;
+
+	started = bench_now();
+	success = success && site_build(site) == SITE_ERROR_NONE;
+	result->build_seconds = bench_now() - started;
+
+	result->output_bytes = 0;
+	for (size_t a = 0; a < articles; a++) {
+		char path[4096];
+		struct stat status;
+		snprintf(path, sizeof(path), "%s/articles/%zu.html", output_directory, a);
+		if (stat(path, &status) == 0)
+			result->output_bytes += (size_t) status.st_size;
+	}
+
+	site_destroy(site);
+	return success;
+}
+
+// Runs one scenario in a child and prints its row.
+static bool bench_run(const struct BenchScenario *scenario, const char *output_directory, size_t articles, size_t article_bytes, unsigned int threads) {
+	int pipe_descriptors[2];
+	if (pipe(pipe_descriptors) != 0)
+		return false;
+
+	pid_t child = fork();
+	if (child < 0)
+		return false;
+	if (child == 0) {
+		close(pipe_descriptors[0]);
+		struct BenchResult result = { 0 };
+		bool success = bench_build(scenario, output_directory, articles, article_bytes, threads, &result);
+		if (write(pipe_descriptors[1], &result, sizeof(result)) != sizeof(result))
+			success = false;
+		_exit(success ? 0 : 1);
+	}
+
+	close(pipe_descriptors[1]);
+	struct BenchResult result = { 0 };
+	bool received = read(pipe_descriptors[0], &result, sizeof(result)) == sizeof(result);
+	close(pipe_descriptors[0]);
+
+	int status = 0;
+	struct rusage usage;
+	if (wait4(child, &status, 0, &usage) < 0)
+		return false;
+	bool success = received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+	double megabytes = result.output_bytes / (1024.0 * 1024.0);
+	printf("%s\t%zu\t%.3f\t%.3f\t%.1f\t%.1f\t%s\n", scenario->name, articles, result.generate_seconds, result.build_seconds,
+	       usage.ru_maxrss / 1024.0, result.build_seconds > 0 ? megabytes / result.build_seconds : 0.0, success ? "ok" : "FAILED");
+	fflush(stdout);
+	return success;
+}
+
+int main(int argc, char **argv) {
+	const char *output_directory = argc > 1 ? argv[1] : "bench_output";
+	size_t articles = argc > 2 ? strtoull(argv[2], NULL, 0) : 4096;
+	size_t article_kilobytes = argc > 3 ? strtoull(argv[3], NULL, 0) : 256;
+	unsigned int threads = argc > 4 ? (unsigned int) strtoul(argv[4], NULL, 0) : 0;
+	if (threads == 0)
+		threads = parallel_default_threads();
+
+	if (mkdir(output_directory, 0755) != 0 && access(output_directory, W_OK) != 0) {
+		fprintf(stderr, "[main] Cannot write to the output directory \"%s\".\n", output_directory);
+		return 1;
+	}
+
+	static const struct BenchScenario scenarios[] = {
+		{ "serial_alloc", false, false, false },
+		{ "serial_alloc_pinned", false, true, false },
+		{ "first_touch", true, true, false },
+		{ "first_touch_hugepages", true, true, true }
+	};
+
+	fprintf(stderr, "%u NUMA nodes, %u threads, %zu articles of %zu KiB\n", bench_numa_nodes(), threads, articles, article_kilobytes);
+	printf("scenario\tarticles\tgenerate_s\tbuild_s\tpeak_rss_mb\toutput_mb_per_s\tstatus\n");
+	bool passed = true;
+	for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+		char directory[4096];
+		snprintf(directory, sizeof(directory), "%s/%s", output_directory, scenarios[s].name);
+		passed = bench_run(&scenarios[s], directory, articles, article_kilobytes * 1024, threads) && passed;
+	}
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "../wpglib.h"
+#include "../wpgsite.h"
+
+// Scale benchmark: builds one GridPage with a million AnchorTags and a few
+// 100 MB articles, each scenario in its own child process so that peak RSS is
+// measured per scenario. Prints one tab separated row per scenario, suitable
+// for appending to a history file:
+//     ./bench_scale [output_directory] [grid_items] [article_megabytes] [articles] [threads]
+// Exits 1 if a scenario fails or its output does not hold every item, which
+// is how size limits in the page model show up.
+
+struct BenchResult {
+	double generate_seconds;
+	double build_seconds;
+	size_t items;		// grid items or article bytes actually held by the pages
+	size_t output_bytes;
+};
+
+static double bench_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static size_t bench_file_size(const char *directory, const char *name) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s", directory, name);
+	struct stat status;
+	return stat(path, &status) == 0 ? (size_t) status.st_size : 0;
+}
+
+static struct Site* bench_site_create(const char *output_directory, unsigned int threads) {
+	mkdir(output_directory, 0755);
+	struct Site *site = site_create((char*) output_directory, "https://bench.example.com");
+	if (site != NULL)
+		site->threads = threads;
+	return site;
+}
+
+static bool bench_grid(const char *output_directory, size_t grid_items, unsigned int threads, struct BenchResult *result) {
+	struct Site *site = bench_site_create(output_directory, threads);
+	if (site == NULL)
+		return false;
+
+	double started = bench_now();
+	struct Page *page = page_create(PAGETYPE_GRID_LANDING, "Every item", "index.html");
+	if (page == NULL || site_add_page(site, page) != SITE_ERROR_NONE) {
+		site_destroy(site);
+		return false;
+	}
+
+	struct GridPage *grid_page = page->page_data;
+	char href[64], text[96];
+	for (size_t i = 0; i < grid_items; i++) {
+		snprintf(href, sizeof(href), "/items/%zu.html", i);
+		snprintf(text, sizeof(text), "Item %zu & friends <%zu>", i, i % 97);
+		if (grid_page_add(grid_page, href, text) != GRID_PAGE_ERROR_NONE) {
+			fprintf(stderr, "[bench_grid] grid_page_add failed at item %zu of %zu.\n", i, grid_items);
+			break;
+		}
+	}
+	result->items = grid_page->grid_items_length;
+	result->generate_seconds = bench_now() - started;
+
+	started = bench_now();
+	bool success = site_build(site) == SITE_ERROR_NONE;
+	result->build_seconds = bench_now() - started;
+	result->output_bytes = bench_file_size(output_directory, "index.html");
+
+	site_destroy(site);
+	return success;
+}
+
+static bool bench_articles(const char *output_directory, size_t article_bytes, size_t articles, unsigned int threads, struct BenchResult *result) {
+	struct Site *site = bench_site_create(output_directory, threads);
+	if (site == NULL)
+		return false;
+
+	static const char paragraph[] = "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.</p>\n";
+	char *body = malloc(article_bytes + 1);
+	if (body == NULL) {
+		site_destroy(site);
+		return false;
+	}
+	for (size_t i = 0; i < article_bytes; i += sizeof(paragraph) - 1)
+		memcpy(body + i, paragraph, article_bytes - i < sizeof(paragraph) - 1 ? article_bytes - i : sizeof(paragraph) - 1);
+	body[article_bytes] = '\0';
+
+	double started = bench_now();
+	result->items = 0;
+	bool success = true;
+	for (size_t a = 0; a < articles && success; a++) {
+		char title[48], path[48];
+		snprintf(title, sizeof(title), "Article %zu", a);
+		snprintf(path, sizeof(path), "articles/%zu.html", a);
+		struct Page *page = page_create(PAGETYPE_ARTICLE, title, path);
+		success = page != NULL && site_add_page(site, page) == SITE_ERROR_NONE;
+		if (success && article_page_set_body(page->page_data, body, article_bytes) != STRING_ERROR_NONE)
+			fprintf(stderr, "[bench_articles] article_page_set_body rejected a body of %zu bytes.\n", article_bytes);
+		else if (success)
+			result->items += ((struct ArticlePage*) page->page_data)->body->length;
+	}
+	free(body);
+	result->generate_seconds = bench_now() - started;
+
+	started = bench_now();
+	success = success && site_build(site) == SITE_ERROR_NONE;
+	result->build_seconds = bench_now() - started;
+	result->output_bytes = 0;
+	for (size_t a = 0; a < articles; a++) {
+		char path[48];
+		snprintf(path, sizeof(path), "articles/%zu.html", a);
+		result->output_bytes += bench_file_size(output_directory, path);
+	}
+
+	site_destroy(site);
+	return success;
+}
+
+// Runs one scenario in a child and prints its row. Returns true if it built
+// and held everything it was asked to.
+static bool bench_run(const char *name, bool grid, const char *output_directory, size_t expected_items, size_t grid_items, size_t article_bytes, size_t articles, unsigned int threads) {
+	int pipe_descriptors[2];
+	if (pipe(pipe_descriptors) != 0)
+		return false;
+
+	pid_t child = fork();
+	if (child < 0)
+		return false;
+	if (child == 0) {
+		close(pipe_descriptors[0]);
+		struct BenchResult result = { 0 };
+		bool success = grid ? bench_grid(output_directory, grid_items, threads, &result) :
+			bench_articles(output_directory, article_bytes, articles, threads, &result);
+		if (write(pipe_descriptors[1], &result, sizeof(result)) != sizeof(result))
+			success = false;
+		_exit(success ? 0 : 1);
+	}
+
+	close(pipe_descriptors[1]);
+	struct BenchResult result = { 0 };
+	bool received = read(pipe_descriptors[0], &result, sizeof(result)) == sizeof(result);
+	close(pipe_descriptors[0]);
+
+	int status = 0;
+	struct rusage usage;
+	if (wait4(child, &status, 0, &usage) < 0)
+		return false;
+	bool success = received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	bool complete = result.items == expected_items;
+
+	double megabytes = result.output_bytes / (1024.0 * 1024.0);
+	printf("%s\t%zu\t%zu\t%.3f\t%.3f\t%.1f\t%.1f\t%s\n", name, expected_items, result.items, result.generate_seconds, result.build_seconds,
+	       usage.ru_maxrss / 1024.0, result.build_seconds > 0 ? megabytes / result.build_seconds : 0.0,
+	       !success ? "FAILED" : complete ? "ok" : "TRUNCATED");
+	fflush(stdout);
+	return success && complete;
+}
+
+int main(int argc, char **argv) {
+	const char *output_directory = argc > 1 ? argv[1] : "bench_output";
+	size_t grid_items = argc > 2 ? strtoull(argv[2], NULL, 0) : 1000000;
+	size_t article_megabytes = argc > 3 ? strtoull(argv[3], NULL, 0) : 100;
+	size_t articles = argc > 4 ? strtoull(argv[4], NULL, 0) : 2;
+	unsigned int threads = argc > 5 ? (unsigned int) strtoul(argv[5], NULL, 0) : 0;
+
+	if (mkdir(output_directory, 0755) != 0 && access(output_directory, W_OK) != 0) {
+		fprintf(stderr, "[main] Cannot write to the output directory \"%s\".\n", output_directory);
+		return 1;
+	}
+
+	char grid_directory[4096], article_directory[4096];
+	snprintf(grid_directory, sizeof(grid_directory), "%s/grid", output_directory);
+	snprintf(article_directory, sizeof(article_directory), "%s/articles", output_directory);
+
+	printf("scenario\trequested\theld\tgenerate_s\tbuild_s\tpeak_rss_mb\toutput_mb_per_s\tstatus\n");
+	bool passed = bench_run("grid", true, grid_directory, grid_items, grid_items, 0, 0, threads);
+	passed = bench_run("articles", false, article_directory, article_megabytes * 1024 * 1024 * articles, 0, article_megabytes * 1024 * 1024, articles, threads) && passed;
+	return passed ? 0 : 1;
+}
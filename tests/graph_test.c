@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../wpggraph.h"
+#include "../wpglib.h"
+
+// Builds the link graph of a small fixed site at several thread counts and
+// checks every page's links, backlinks and related pages:
+//     ./graph_test
+
+#define GRAPH_PAGES 8
+#define GRAPH_HREFS 7
+
+struct GraphTestPage {
+	enum PageType page_type;
+	const char *path;
+	const char *hrefs[GRAPH_HREFS];	// grid anchors, up to the first NULL
+};
+
+// External links, missing pages and the landing page's link to itself are left
+// out; tags/x.html lists b.html twice and resolves relative and root paths.
+static const struct GraphTestPage graph_pages[GRAPH_PAGES] = {
+	{ PAGETYPE_GRID_LANDING, "index.html", { "a.html", "b.html", "c.html", "d.html", "https://example.com/", "missing.html", "index.html" } },
+	{ PAGETYPE_ARTICLE, "a.html", { NULL } },
+	{ PAGETYPE_ARTICLE, "b.html", { NULL } },
+	{ PAGETYPE_ARTICLE, "c.html", { NULL } },
+	{ PAGETYPE_ARTICLE, "d.html", { NULL } },
+	{ PAGETYPE_GRID_LANDING, "tags/x.html", { "../d.html", "../b.html", "/e.html", "../b.html#comments", NULL } },
+	{ PAGETYPE_GRID_LANDING, "empty.html", { NULL } },
+	{ PAGETYPE_ARTICLE, "e.html", { NULL } }
+};
+
+// Expected graph. Backlinks are ordered by source page, each with the position
+// of the link within its source; related pages rank by summed closeness
+// (4 - distance) within the grids, then by distance, then by page.
+struct ExpectedPage {
+	unsigned int out_targets[4];
+	size_t out_length;
+	unsigned int in_sources[3];
+	unsigned int in_positions[3];
+	size_t in_length;
+	unsigned int related[LINK_GRAPH_RELATED_MAX];
+	size_t related_length;
+};
+
+static const struct ExpectedPage expected_pages[GRAPH_PAGES] = {
+	{ { 1, 2, 3, 4 }, 4, { 0 }, { 0 }, 0, { 0 }, 0 },
+	{ { 0 }, 0, { 0 }, { 0 }, 1, { 2, 3, 4 }, 3 },
+	{ { 0 }, 0, { 0, 5, 5 }, { 1, 1, 3 }, 3, { 4, 1, 3, 7 }, 4 },
+	{ { 0 }, 0, { 0 }, { 2 }, 1, { 2, 4, 1 }, 3 },
+	{ { 0 }, 0, { 0, 5 }, { 3, 0 }, 2, { 2, 3, 7, 1 }, 4 },
+	{ { 4, 2, 7, 2 }, 4, { 0 }, { 0 }, 0, { 0 }, 0 },
+	{ { 0 }, 0, { 0 }, { 0 }, 0, { 0 }, 0 },
+	{ { 0 }, 0, { 5 }, { 2 }, 1, { 2, 4 }, 2 }
+};
+
+static bool test_compare(const char *what, size_t page, const unsigned int *actual, size_t actual_length, const unsigned int *expected, size_t expected_length) {
+	bool equal = actual_length == expected_length && (expected_length == 0 || memcmp(actual, expected, sizeof(unsigned int) * expected_length) == 0);
+	if (!equal) {
+		fprintf(stderr, "[test_compare] The %s of page %zu are [", what, page);
+		for (size_t i = 0; i < actual_length; i++)
+			fprintf(stderr, "%s%u", i > 0 ? " " : "", actual[i]);
+		fprintf(stderr, "], expected [");
+		for (size_t i = 0; i < expected_length; i++)
+			fprintf(stderr, "%s%u", i > 0 ? " " : "", expected[i]);
+		fprintf(stderr, "].\n");
+	}
+	return equal;
+}
+
+static bool check_graph(struct Page **pages, unsigned int threads) {
+	struct LinkGraph *graph = link_graph_create(pages, GRAPH_PAGES, threads);
+	if (graph == NULL) {
+		fprintf(stderr, "[check_graph] The graph was not built with %u threads.\n", threads);
+		return false;
+	}
+
+	bool passed = graph->pages_length == GRAPH_PAGES && graph->out_offsets[0] == 0 && graph->in_offsets[0] == 0;
+	for (size_t i = 0; passed && i < GRAPH_PAGES; i++) {
+		const struct ExpectedPage *expected = &expected_pages[i];
+		size_t out_start = graph->out_offsets[i];
+		size_t in_start = graph->in_offsets[i];
+		passed = test_compare("links", i, graph->out_targets + out_start, graph->out_offsets[i + 1] - out_start, expected->out_targets, expected->out_length) &&
+			test_compare("backlinks", i, graph->in_sources + in_start, graph->in_offsets[i + 1] - in_start, expected->in_sources, expected->in_length) &&
+			test_compare("backlink positions", i, graph->in_positions + in_start, graph->in_offsets[i + 1] - in_start, expected->in_positions, expected->in_length) &&
+			test_compare("related pages", i, graph->related + i * LINK_GRAPH_RELATED_MAX, graph->related_length[i], expected->related, expected->related_length);
+	}
+	if (!passed)
+		fprintf(stderr, "[check_graph] The graph built with %u threads is not as expected.\n", threads);
+
+	link_graph_destroy(graph);
+	return passed;
+}
+
+// Related pages are capped at LINK_GRAPH_RELATED_MAX, keeping the closest.
+static bool check_related_limit() {
+	static const char *paths[] = { "grid.html", "p0.html", "p1.html", "p2.html", "p3.html", "p4.html", "p5.html", "p6.html", "p7.html" };
+	size_t pages_length = sizeof(paths) / sizeof(paths[0]);
+	struct Page *pages[sizeof(paths) / sizeof(paths[0])] = { 0 };
+
+	bool passed = true;
+	for (size_t i = 0; passed && i < pages_length; i++) {
+		pages[i] = page_create(i == 0 ? PAGETYPE_GRID_LANDING : PAGETYPE_ARTICLE, "Page", (char*) paths[i]);
+		passed = pages[i] != NULL && (i == 0 || grid_page_add(pages[0]->page_data, (char*) paths[i], "Page") == GRID_PAGE_ERROR_NONE);
+	}
+
+	// p3 is page 4 at position 3 of 8: p2 and p4 are at distance 1, p1 and p5 at
+	// 2, and p0 and p6 at 3, where p0 takes the last place on its lower page index
+	static const unsigned int expected[LINK_GRAPH_RELATED_MAX] = { 3, 5, 2, 6, 1 };
+	struct LinkGraph *graph = passed ? link_graph_create(pages, pages_length, 2) : NULL;
+	passed = graph != NULL && test_compare("related pages", 4, graph->related + 4 * LINK_GRAPH_RELATED_MAX, graph->related_length[4], expected, LINK_GRAPH_RELATED_MAX);
+
+	if (graph != NULL)
+		link_graph_destroy(graph);
+	for (size_t i = 0; i < pages_length; i++) {
+		if (pages[i] != NULL)
+			page_destroy(pages[i]);
+	}
+	return passed;
+}
+
+int main() {
+	struct Page *pages[GRAPH_PAGES] = { 0 };
+	for (size_t i = 0; i < GRAPH_PAGES; i++) {
+		pages[i] = page_create(graph_pages[i].page_type, "Page", (char*) graph_pages[i].path);
+		for (size_t j = 0; pages[i] != NULL && j < GRAPH_HREFS && graph_pages[i].hrefs[j] != NULL; j++) {
+			if (grid_page_add(pages[i]->page_data, (char*) graph_pages[i].hrefs[j], "Item") != GRID_PAGE_ERROR_NONE) {
+				fprintf(stderr, "[main] Failed to add \"%s\" to page \"%s\".\n", graph_pages[i].hrefs[j], graph_pages[i].path);
+				return 1;
+			}
+		}
+		if (pages[i] == NULL) {
+			fprintf(stderr, "[main] Failed to create page \"%s\".\n", graph_pages[i].path);
+			return 1;
+		}
+	}
+
+	// More threads than anchors leaves some workers with empty ranges
+	static const unsigned int thread_counts[] = { 1, 2, 3, 16 };
+	size_t builds = sizeof(thread_counts) / sizeof(thread_counts[0]);
+	size_t total = builds + 1;
+	size_t failures = 0;
+	for (size_t i = 0; i < builds; i++) {
+		if (!check_graph(pages, thread_counts[i]))
+			failures++;
+	}
+	if (!check_related_limit())
+		failures++;
+
+	for (size_t i = 0; i < GRAPH_PAGES; i++)
+		page_destroy(pages[i]);
+	printf("%zu/%zu graph cases passed\n", total - failures, total);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "../wpglib.h"
+#include "../wpglinks.h"
+
+// Path resolution and link validation cases:
+//     ./links_test
+
+struct ResolveCase {
+	const char *source;
+	const char *href;
+	const char *expected;	// NULL for an external link
+};
+
+static const struct ResolveCase resolve_cases[] = {
+	{ "index.html", "about.html", "about.html" },
+	{ "blog/post.html", "other.html", "blog/other.html" },
+	{ "blog/post.html", "./other.html", "blog/other.html" },
+	{ "blog/post.html", "/other.html", "other.html" },
+	{ "blog/post.html", "../other.html", "other.html" },
+	{ "blog/2024/post.html", "../../a/./b/../c.html", "a/c.html" },
+	{ "index.html", "../../../etc/passwd", "etc/passwd" },
+	{ "blog/post.html", "/../../x.html", "x.html" },
+	{ "blog/post.html", "page.html#section", "blog/page.html" },
+	{ "blog/post.html", "page.html?q=1#f", "blog/page.html" },
+	{ "blog/post.html", "#top", "blog/post.html" },
+	{ "blog/post.html", "?page=2", "blog/post.html" },
+	{ "blog/post.html", "./", "blog/index.html" },
+	{ "blog/post.html", "/", "index.html" },
+	{ "blog/post.html", "..", "index.html" },
+	{ "blog/post.html", "docs/", "blog/docs/index.html" },
+	{ "blog/post.html", "a//b.html", "blog/a/b.html" },
+	{ "index.html", "https://example.com/a.html", NULL },
+	{ "index.html", "HTTP://example.com/", NULL },
+	{ "index.html", "mailto:someone@example.com", NULL },
+	{ "index.html", "git+ssh://host/repo", NULL },
+	{ "index.html", "//cdn.example.com/a.js", NULL },
+	{ "index.html", "dir:name/a.html", NULL },
+	{ "index.html", "a/b:c.html", "a/b:c.html" },
+	{ "index.html", "1http:x.html", "1http:x.html" }
+};
+
+static bool check_resolve(const struct ResolveCase *test) {
+	char resolved[PATH_MAX];
+	bool internal = link_resolve(test->source, test->href, resolved, sizeof(resolved));
+	if (internal != (test->expected != NULL) || (internal && strcmp(resolved, test->expected) != 0)) {
+		fprintf(stderr, "[check_resolve] \"%s\" from \"%s\" gave %s \"%s\", expected %s \"%s\".\n", test->href, test->source,
+			internal ? "internal" : "external", internal ? resolved : "", test->expected != NULL ? "internal" : "external",
+			test->expected != NULL ? test->expected : "");
+		return false;
+	}
+	return true;
+}
+
+// A resolved path that does not fit is reported as an empty internal path,
+// never truncated.
+static bool check_small_buffer() {
+	bool passed = true;
+	for (size_t size = 1; size <= 16; size++) {
+		char resolved[16];
+		memset(resolved, 'x', sizeof(resolved));
+		bool internal = link_resolve("blog/post.html", "other.html", resolved, size);
+		bool fits = size > strlen("blog/other.html");
+		if (!internal || (fits ? strcmp(resolved, "blog/other.html") != 0 : resolved[0] != '\0')) {
+			fprintf(stderr, "[check_small_buffer] A %zu byte buffer gave \"%.*s\".\n", size, (int) size, resolved);
+			passed = false;
+		}
+
+		memset(resolved, 'x', sizeof(resolved));
+		internal = link_resolve("a/b.html", "./", resolved, size);
+		fits = size > strlen("a/index.html");
+		if (!internal || (fits ? strcmp(resolved, "a/index.html") != 0 : resolved[0] != '\0')) {
+			fprintf(stderr, "[check_small_buffer] A %zu byte buffer for a directory link gave \"%.*s\".\n", size, (int) size, resolved);
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+static bool check_validate() {
+	static const char *hrefs[] = { "/about.html", "missing.html", "https://example.com/", "blog/post.html#x", "blog/", "./index.html", "../gone.html" };
+	static const size_t dangling[] = { 1, 4, 6 };
+
+	struct Page *pages[4] = {
+		page_create(PAGETYPE_GRID_LANDING, "Home", "index.html"),
+		page_create(PAGETYPE_ARTICLE, "About", "about.html"),
+		page_create(PAGETYPE_ARTICLE, "Post", "blog/post.html"),
+		page_create(PAGETYPE_GRID_LANDING, "Empty", "empty.html")
+	};
+	bool passed = true;
+	for (size_t i = 0; i < 4; i++)
+		passed = passed && pages[i] != NULL;
+	for (size_t i = 0; passed && i < sizeof(hrefs) / sizeof(hrefs[0]); i++)
+		passed = grid_page_add(pages[0]->page_data, (char*) hrefs[i], "item") == GRID_PAGE_ERROR_NONE;
+
+	for (unsigned int threads = 1; passed && threads <= 8; threads *= 2) {
+		size_t problems_length = 0;
+		struct LinkProblem *problems = link_validate(pages, 4, threads, &problems_length);
+		if (problems == NULL) {
+			passed = false;
+			break;
+		}
+
+		bool matches = problems_length == sizeof(dangling) / sizeof(dangling[0]);
+		for (size_t i = 0; matches && i < problems_length; i++)
+			matches = problems[i].page_index == 0 && problems[i].anchor_index == dangling[i];
+		if (!matches) {
+			fprintf(stderr, "[check_validate] %u threads found %zu dangling links, expected anchors 1, 4 and 6.\n", threads, problems_length);
+			passed = false;
+		}
+		free(problems);
+	}
+
+	for (size_t i = 0; i < 4; i++) {
+		if (pages[i] != NULL)
+			page_destroy(pages[i]);
+	}
+	return passed;
+}
+
+int main() {
+	size_t cases_length = sizeof(resolve_cases) / sizeof(resolve_cases[0]);
+	size_t failures = 0;
+	for (size_t i = 0; i < cases_length; i++) {
+		if (!check_resolve(&resolve_cases[i]))
+			failures++;
+	}
+	if (!check_small_buffer())
+		failures++;
+	if (!check_validate())
+		failures++;
+
+	printf("%zu/%zu link cases passed\n", cases_length + 2 - failures, cases_length + 2);
+	return failures == 0 ? 0 : 1;
+}
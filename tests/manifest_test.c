@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "../wpgmanifest.h"
+
+// Manifest parsing cases: each manifest text either loads or is rejected, and
+// the values of loaded manifests and pages are checked field by field.
+//     ./manifest_test
+
+struct ManifestCase {
+	const char *name;
+	const char *text;
+	bool loads;
+};
+
+static const struct ManifestCase manifest_cases[] = {
+	{ "minimal", "output public\nbase_url https://example.com\n", true },
+	{ "long comment", "# This comment has a great many more words than any directive could ever take\n"
+			  "output public\nbase_url https://example.com\n", true },
+	{ "comment with a stray quote", "# the \"title argument is quoted\noutput public\nbase_url https://example.com\n", true },
+	{ "indented comment", "  \t# indented, with \"many\" words and one more \" quote\noutput public\nbase_url https://example.com\n", true },
+	{ "blank lines", "\n   \n\t\r\noutput public\r\nbase_url https://example.com\r\n", true },
+	{ "too many arguments", "output public one two three four five six\nbase_url https://example.com\n", false },
+	{ "unterminated quote", "output \"public\nbase_url https://example.com\n", false },
+	{ "unknown directive", "output public\nbase_url https://example.com\ncolour blue\n", false },
+	{ "missing base_url", "output public\n", false },
+	{ "budget with validate", "output public\nbase_url https://example.com\nbudget 64M\nvalidate yes\n", false },
+	{ "budget with navigation", "output public\nbase_url https://example.com\nbudget 64M\nnavigation yes\n", false },
+	{ "budget with search", "output public\nbase_url https://example.com\nbudget 64M\nsearch yes\n", false },
+	{ "budget with a sitemap", "output public\nbase_url https://example.com\nbudget 64M\nsitemap yes\n", true },
+	{ "nested page path", "output public\nbase_url https://example.com\npage article blog/2024/a.html A a.html\n", true },
+	{ "page path with dots in names", "output public\nbase_url https://example.com\npage article a..b/.c.html A a.html\n", true },
+	{ "page path leaving the output", "output public\nbase_url https://example.com\npage article ../../etc/x.html X x.html\n", false },
+	{ "page path with an inner ..", "output public\nbase_url https://example.com\npage article blog/../../x.html X x.html\n", false },
+	{ "absolute page path", "output public\nbase_url https://example.com\npage article /etc/x.html X x.html\n", false },
+	{ "page path with a . segment", "output public\nbase_url https://example.com\npage article ./x.html X x.html\n", false },
+	{ "page path with an empty segment", "output public\nbase_url https://example.com\npage article a//x.html X x.html\n", false },
+	{ "page path ending in a slash", "output public\nbase_url https://example.com\npage article blog/ X x.html\n", false }
+};
+
+static bool check_case(const char *directory, const struct ManifestCase *test) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/site.wpg", directory);
+	FILE *output = fopen(path, "wb");
+	if (output == NULL || fputs(test->text, output) == EOF || fclose(output) != 0) {
+		fprintf(stderr, "[check_case] Failed to write \"%s\".\n", path);
+		return false;
+	}
+
+	struct Manifest *manifest = manifest_load(path);
+	bool loaded = manifest != NULL;
+	if (manifest != NULL)
+		manifest_destroy(manifest);
+	unlink(path);
+	if (loaded != test->loads) {
+		fprintf(stderr, "[check_case] \"%s\" %s but should have %s.\n", test->name, loaded ? "loaded" : "was rejected", test->loads ? "loaded" : "been rejected");
+		return false;
+	}
+	return true;
+}
+
+static bool write_file(const char *directory, const char *name, const char *text) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s", directory, name);
+	FILE *output = fopen(path, "wb");
+	if (output == NULL || fputs(text, output) == EOF || fclose(output) != 0) {
+		fprintf(stderr, "[write_file] Failed to write \"%s\".\n", path);
+		return false;
+	}
+	return true;
+}
+
+// An empty article source is a mistake in the input, not a lack of memory.
+static bool check_empty_article(const char *directory) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/site.wpg", directory);
+	if (!write_file(directory, "site.wpg", "output public\nbase_url https://example.com\npage article a.html A empty.html\n") ||
+	    !write_file(directory, "empty.html", ""))
+		return false;
+
+	struct Manifest *manifest = manifest_load(path);
+	struct Page *page = NULL;
+	enum ManifestError error = manifest != NULL ? manifest_load_page(manifest, 0, &page) : MANIFEST_ERROR_NULL_POINTER;
+	if (manifest != NULL)
+		manifest_destroy(manifest);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/empty.html", directory);
+	unlink(path);
+
+	if (error != MANIFEST_ERROR_BAD_SYNTAX || page != NULL) {
+		fprintf(stderr, "[check_empty_article] An empty article returned %d, expected %d.\n", error, MANIFEST_ERROR_BAD_SYNTAX);
+		return false;
+	}
+	return true;
+}
+
+struct BudgetCase {
+	const char *value;
+	size_t expected;	// SIZE_MAX when the value is rejected
+};
+
+static const struct BudgetCase budget_cases[] = {
+	{ "512", 512 },
+	{ "4k", 4 * 1024 },
+	{ "4K", 4 * 1024 },
+	{ "3M", (size_t) 3 * 1024 * 1024 },
+	{ "2g", (size_t) 2 * 1024 * 1024 * 1024 },
+	{ "0", 0 },
+	{ "3X", SIZE_MAX },
+	{ "1MB", SIZE_MAX },
+	{ "-1", SIZE_MAX },
+	{ "M", SIZE_MAX }
+};
+
+static bool check_budgets(const char *directory) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/site.wpg", directory);
+
+	bool passed = true;
+	for (size_t i = 0; i < sizeof(budget_cases) / sizeof(budget_cases[0]); i++) {
+		char text[256];
+		snprintf(text, sizeof(text), "output public\nbase_url https://example.com\nbudget %s\n", budget_cases[i].value);
+		if (!write_file(directory, "site.wpg", text))
+			return false;
+
+		struct Manifest *manifest = manifest_load(path);
+		bool rejected = budget_cases[i].expected == SIZE_MAX;
+		if (rejected != (manifest == NULL) || (manifest != NULL && manifest->memory_budget != budget_cases[i].expected)) {
+			fprintf(stderr, "[check_budgets] budget %s gave %zu, expected %zu.\n", budget_cases[i].value,
+				manifest != NULL ? manifest->memory_budget : SIZE_MAX, budget_cases[i].expected);
+			passed = false;
+		}
+		if (manifest != NULL)
+			manifest_destroy(manifest);
+	}
+
+	unlink(path);
+	return passed;
+}
+
+static bool check_string(const char *field, const char *actual, const char *expected) {
+	if (actual == NULL || strcmp(actual, expected) != 0) {
+		fprintf(stderr, "[check_fields] %s is \"%s\", expected \"%s\".\n", field, actual != NULL ? actual : "(NULL)", expected);
+		return false;
+	}
+	return true;
+}
+
+static bool check_number(const char *field, size_t actual, size_t expected) {
+	if (actual != expected) {
+		fprintf(stderr, "[check_fields] %s is %zu, expected %zu.\n", field, actual, expected);
+		return false;
+	}
+	return true;
+}
+
+// Loads one manifest and its pages and checks every parsed value.
+static bool check_fields(const char *directory) {
+	static const char *manifest_text =
+		"output \"public site\"\n"
+		"base_url https://example.com/docs\n"
+		"threads 6\n"
+		"profile 7\n"
+		"reproducible yes\n"
+		"sitemap no\n"
+		"minify on\n"
+		"page\tarticle  \"blog/post one.html\"  \"A \\\"quoted\\\" title\"  post.html\n"
+		"page grid index.html \"Home page\" home.csv\n";
+	static const char *grid_text = "/a.html,First item\n# a comment\n\nhttps://x.com/b?c=1,Second, with a comma\r\n";
+	static const char *article_text = "<p>The post.</p>\n";
+
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/site.wpg", directory);
+	if (!write_file(directory, "site.wpg", manifest_text) || !write_file(directory, "home.csv", grid_text) || !write_file(directory, "post.html", article_text))
+		return false;
+
+	struct Manifest *manifest = manifest_load(path);
+	if (manifest == NULL) {
+		fprintf(stderr, "[check_fields] The manifest did not load.\n");
+		return false;
+	}
+
+	bool passed = check_string("output", manifest->output_directory, "public site") &
+		check_string("base_url", manifest->base_url, "https://example.com/docs") &
+		check_number("threads", manifest->threads, 6) &
+		check_number("profile", manifest->profile_pages, 7) &
+		check_number("reproducible", manifest->reproducible, true) &
+		check_number("sitemap", manifest->emit_sitemap, false) &
+		check_number("link_index", manifest->emit_link_index, true) &
+		check_number("minify", manifest->minify, true) &
+		check_number("budget", manifest->memory_budget, 0) &
+		check_number("pages", manifest->pages_length, 2);
+
+	if (manifest->pages_length == 2) {
+		struct ManifestPage *article = &(manifest->pages[0]);
+		struct ManifestPage *grid = &(manifest->pages[1]);
+		passed &= check_number("first page type", article->page_type, PAGETYPE_ARTICLE) &
+			check_string("first page path", manifest->text + article->path, "blog/post one.html") &
+			check_string("first page title", manifest->text + article->title, "A \"quoted\" title") &
+			check_string("first page source", manifest->text + article->source, "post.html") &
+			check_number("second page type", grid->page_type, PAGETYPE_GRID_LANDING) &
+			check_string("second page path", manifest->text + grid->path, "index.html") &
+			check_string("second page title", manifest->text + grid->title, "Home page") &
+			check_string("second page source", manifest->text + grid->source, "home.csv");
+
+		struct Page *page = NULL;
+		if (manifest_load_page(manifest, 0, &page) != MANIFEST_ERROR_NONE || page == NULL) {
+			fprintf(stderr, "[check_fields] The article did not load.\n");
+			passed = false;
+		} else {
+			struct String *body = ((struct ArticlePage*) page->page_data)->body;
+			passed &= check_string("article path", page->path, "blog/post one.html") &
+				check_string("article title", page->title, "A \"quoted\" title") &
+				check_string("article body", body->data, article_text);
+			page_destroy(page);
+		}
+
+		page = NULL;
+		if (manifest_load_page(manifest, 1, &page) != MANIFEST_ERROR_NONE || page == NULL) {
+			fprintf(stderr, "[check_fields] The grid did not load.\n");
+			passed = false;
+		} else {
+			struct GridPage *grid_page = page->page_data;
+			passed &= check_number("grid items", grid_page->grid_items_length, 2);
+			if (grid_page->grid_items_length == 2) {
+				passed &= check_string("first href", grid_page->grid_items[0].href->data, "/a.html") &
+					check_string("first text", grid_page->grid_items[0].text->data, "First item") &
+					check_string("second href", grid_page->grid_items[1].href->data, "https://x.com/b?c=1") &
+					check_string("second text", grid_page->grid_items[1].text->data, "Second, with a comma");
+			}
+			page_destroy(page);
+		}
+	}
+
+	manifest_destroy(manifest);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/home.csv", directory);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/post.html", directory);
+	unlink(path);
+	return passed;
+}
+
+int main() {
+	char directory[] = "/tmp/wpg_manifest_test_XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		fprintf(stderr, "[main] Failed to create a scratch directory.\n");
+		return 1;
+	}
+
+	size_t cases_length = sizeof(manifest_cases) / sizeof(manifest_cases[0]);
+	size_t failures = 0;
+	for (size_t i = 0; i < cases_length; i++) {
+		if (!check_case(directory, &manifest_cases[i]))
+			failures++;
+	}
+
+	if (!check_empty_article(directory))
+		failures++;
+	if (!check_budgets(directory))
+		failures++;
+	if (!check_fields(directory))
+		failures++;
+
+	rmdir(directory);
+	printf("%zu/%zu manifest cases passed\n", cases_length + 3 - failures, cases_length + 3);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../wpgbuffer.h"
+#include "../wpgminify.h"
+
+// Input and expected output cases for the streaming minifier. Every case is
+// fed in one append, in fixed size chunks and one byte at a time, and must
+// come out the same each way:
+//     ./minify_test
+
+struct MinifyCase {
+	const char *name;
+	const char *input;
+	const char *expected;
+};
+
+static const struct MinifyCase minify_cases[] = {
+	{ "text whitespace collapses", "a  \n\t b", "a b" },
+	{ "whitespace next to blocks is dropped", "<div>\n  <p> text </p>\n</div>\n", "<div><p>text</p></div>" },
+	{ "whitespace between inline elements is kept", "<p><a href=\"/\">one</a> <b>two</b>\n<i>three</i></p>", "<p><a href=\"/\">one</a> <b>two</b> <i>three</i></p>" },
+	{ "whitespace inside tags collapses", "<a   href=\"/\"\n   class=\"x\"  >link</a>", "<a href=\"/\" class=\"x\">link</a>" },
+	{ "comments are removed", "<p>one<!-- a comment --> two</p><!--\n--><p>three</p>", "<p>one two</p><p>three</p>" },
+	{ "comments with dashes inside", "a<!-- x - y -- z -->b", "ab" },
+	{ "double quoted attribute holding >", "<a title=\"a > b\"   href=\"/\">x</a>", "<a title=\"a > b\" href=\"/\">x</a>" },
+	{ "single quoted attribute holding > and spaces", "<a title='1  >  2'>x</a>", "<a title='1  >  2'>x</a>" },
+	{ "pre is untouched", "<pre>  keep\n    this  </pre>  <p> x </p>", "<pre>  keep\n    this  </pre><p>x</p>" },
+	{ "textarea is untouched", "<textarea>\n  a  <b>  </textarea>", "<textarea>\n  a  <b>  </textarea>" },
+	{ "script is untouched", "<script>\nif (a < b) {  x = \"</p>\";  }\n</script>", "<script>\nif (a < b) {  x = \"</p>\";  }\n</script>" },
+	{ "style is untouched", "<style>  p  >  a { color: red; }  </style>", "<style>  p  >  a { color: red; }  </style>" },
+	{ "raw element closes case insensitively", "<SCRIPT> a  b </Script>  <p> c </p>", "<SCRIPT> a  b </Script><p>c</p>" },
+	{ "comment inside pre is kept", "<pre><!--  x  --></pre>", "<pre><!--  x  --></pre>" },
+	{ "tag name longer than the name buffer", "<p>a <customelementwithaverylongname  x=\"1\">b</customelementwithaverylongname> c</p>",
+	  "<p>a <customelementwithaverylongname x=\"1\">b</customelementwithaverylongname> c</p>" },
+	{ "lone less than is text", "a < b", "a < b" },
+	{ "doctype", "<!DOCTYPE html>\n<html>\n<head>\n<title> T </title>\n</head>", "<!DOCTYPE html><html><head><title>T</title></head>" },
+	{ "tag cut off by the end", "text <span", "text <span" },
+	{ "trailing whitespace is dropped", "<p>x</p>   \n", "<p>x</p>" }
+};
+
+static bool check_case(const struct MinifyCase *test) {
+	static const size_t chunk_sizes[] = { 0, 7, 1 };	// 0 appends everything at once
+	size_t input_length = strlen(test->input);
+	bool passed = true;
+
+	for (size_t c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+		struct Buffer output;
+		struct Minifier minifier;
+		if (buffer_init(&output, 16) != BUFFER_ERROR_NONE)
+			return false;
+		minifier_init(&minifier);
+
+		size_t chunk = chunk_sizes[c] != 0 ? chunk_sizes[c] : input_length;
+		bool appended = true;
+		for (size_t i = 0; i < input_length && appended; i += chunk) {
+			size_t length = input_length - i < chunk ? input_length - i : chunk;
+			appended = minify_append(&minifier, &output, test->input + i, length) == BUFFER_ERROR_NONE;
+		}
+		appended = appended && minify_finish(&minifier, &output) == BUFFER_ERROR_NONE;
+
+		if (!appended || output.length != strlen(test->expected) || memcmp(output.data, test->expected, output.length) != 0) {
+			fprintf(stderr, "[check_case] \"%s\" in chunks of %zu gave \"%.*s\", expected \"%s\".\n", test->name, chunk_sizes[c],
+				(int) output.length, output.data, test->expected);
+			passed = false;
+		}
+		buffer_free(&output);
+	}
+
+	return passed;
+}
+
+int main() {
+	size_t cases_length = sizeof(minify_cases) / sizeof(minify_cases[0]);
+	size_t failures = 0;
+	for (size_t i = 0; i < cases_length; i++) {
+		if (!check_case(&minify_cases[i]))
+			failures++;
+	}
+
+	printf("%zu/%zu minify cases passed\n", cases_length - failures, cases_length);
+	return failures == 0 ? 0 : 1;
+}
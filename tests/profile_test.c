@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../wpgprofile.h"
+
+// Records known render times across several workers and checks the reported
+// totals, histogram percentiles and slowest pages:
+//     ./profile_test
+
+#define PROFILE_TEST_PAGES 100
+#define PROFILE_TEST_TOP 5
+
+// Page i takes the time of the first group it falls in. Percentiles report the
+// midpoint of a histogram bucket, eight of which split each power of two:
+//     1000 ns lands in [960, 1024), reported as 992 ns
+//     100000 ns lands in [98304, 106496), reported as 102.4 us
+//     5000000 + k * 10000 ns lands in [4718592, 5242880), reported as 4.98 ms
+//     2000000000 ns lands in [1879048192, 2013265920), reported as 1.95 s
+struct ProfileGroup {
+	size_t pages;
+	unsigned long long nanoseconds;
+	unsigned long long step;	// added per page within the group
+};
+
+static const struct ProfileGroup profile_groups[] = {
+	{ 50, 1000, 0 },
+	{ 40, 100000, 0 },
+	{ 9, 5000000, 10000 },
+	{ 1, 2000000000, 0 }
+};
+
+static unsigned long long test_page_nanoseconds(size_t page) {
+	for (size_t i = 0; i < sizeof(profile_groups) / sizeof(profile_groups[0]); i++) {
+		if (page < profile_groups[i].pages)
+			return profile_groups[i].nanoseconds + page * profile_groups[i].step;
+		page -= profile_groups[i].pages;
+	}
+	return 0;
+}
+
+// The slowest list holds exact times rather than bucket estimates: the 2 s
+// page, then the slowest of the 5 ms group.
+struct ExpectedSample {
+	const char *duration;
+	size_t output_bytes;
+	size_t buffer_growths;
+	const char *path;
+};
+
+static const struct ExpectedSample expected_slowest[PROFILE_TEST_TOP] = {
+	{ "2.00 s", 1099, 3, "page-99.html" },
+	{ "5.08 ms", 1098, 2, "page-98.html" },
+	{ "5.07 ms", 1097, 1, "page-97.html" },
+	{ "5.06 ms", 1096, 0, "page-96.html" },
+	{ "5.05 ms", 1095, 3, "page-95.html" }
+};
+
+static bool test_report(struct Profile *profile, char **text) {
+	size_t length = 0;
+	FILE *output = open_memstream(text, &length);
+	if (output == NULL)
+		return false;
+	profile_report(profile, output);
+	return fclose(output) == 0;
+}
+
+static bool check_line(const char *report, const char *expected) {
+	if (strstr(report, expected) == NULL) {
+		fprintf(stderr, "[check_line] The report has no line \"%s\":\n%s", expected, report);
+		return false;
+	}
+	return true;
+}
+
+// Records every page in a scattered order, round robin across workers, so the
+// slowest list of each worker is filled out of order and merged at the end.
+static bool check_profile(unsigned int threads) {
+	struct Profile *profile = profile_create(threads, PROFILE_TEST_TOP);
+	if (profile == NULL)
+		return false;
+
+	for (size_t i = 0; i < PROFILE_TEST_PAGES; i++) {
+		size_t page = (i * 37) % PROFILE_TEST_PAGES;
+		char path[32];
+		snprintf(path, sizeof(path), "page-%zu.html", page);
+		profile_record(profile, (unsigned int) (i % threads), path, test_page_nanoseconds(page), 1000 + page, page % 4);
+	}
+
+	char *report = NULL;
+	bool passed = test_report(profile, &report);
+	profile_destroy(profile);
+	if (!passed) {
+		fprintf(stderr, "[check_profile] Failed to write the report with %u threads.\n", threads);
+		free(report);
+		return false;
+	}
+
+	// 50 * 1000 + 40 * 100000 + (9 * 5000000 + 360000) + 2000000000 ns
+	passed = check_line(report, "Render profile: 100 pages, 2.05 s of render time, 104950 bytes written, 150 buffer growths\n") &&
+		check_line(report, "  p50 102.4 us, p90 4.98 ms, p99 1.95 s\n") &&
+		check_line(report, "  Slowest 5 pages:\n");
+
+	const char *slowest = strstr(report, "  Slowest 5 pages:\n");
+	for (size_t i = 0; passed && i < PROFILE_TEST_TOP; i++) {
+		const struct ExpectedSample *expected = &expected_slowest[i];
+		char expected_line[512];
+		snprintf(expected_line, sizeof(expected_line), "  %10s %10zu bytes %4zu buffer growths  %s",
+			expected->duration, expected->output_bytes, expected->buffer_growths, expected->path);
+		slowest = strchr(slowest, '\n') + 1;
+		size_t line_length = strcspn(slowest, "\n");
+		if (line_length != strlen(expected_line) || memcmp(slowest, expected_line, line_length) != 0) {
+			fprintf(stderr, "[check_profile] Slow page %zu is \"%.*s\", expected \"%s\".\n", i, (int) line_length, slowest, expected_line);
+			passed = false;
+		}
+	}
+	if (passed && strchr(slowest, '\n')[1] != '\0') {
+		fprintf(stderr, "[check_profile] The report lists more than %d slow pages.\n", PROFILE_TEST_TOP);
+		passed = false;
+	}
+
+	free(report);
+	return passed;
+}
+
+// An empty profile reports its totals and nothing more.
+static bool check_empty() {
+	struct Profile *profile = profile_create(2, PROFILE_TEST_TOP);
+	if (profile == NULL)
+		return false;
+
+	char *report = NULL;
+	bool passed = test_report(profile, &report) &&
+		strcmp(report, "Render profile: 0 pages, 0 ns of render time, 0 bytes written, 0 buffer growths\n") == 0;
+	if (!passed)
+		fprintf(stderr, "[check_empty] An empty profile reported \"%s\".\n", report != NULL ? report : "(nothing)");
+
+	profile_destroy(profile);
+	free(report);
+	return passed;
+}
+
+int main() {
+	static const unsigned int thread_counts[] = { 1, 3, 8 };
+	size_t profiles = sizeof(thread_counts) / sizeof(thread_counts[0]);
+	size_t total = profiles + 1;
+	size_t failures = 0;
+	for (size_t i = 0; i < profiles; i++) {
+		if (!check_profile(thread_counts[i]))
+			failures++;
+	}
+	if (!check_empty())
+		failures++;
+
+	printf("%zu/%zu profile cases passed\n", total - failures, total);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../wpglib.h"
+#include "../wpgsearch.h"
+#include "../wpgsite.h"
+
+// Builds a small site with a search index at several thread counts and decodes
+// every shard back into terms and document ids:
+//     ./search_test
+
+struct SearchTestPage {
+	enum PageType page_type;
+	const char *path;
+	const char *title;
+	const char *body;	// article body, or "href,text" grid items separated by '\n'
+};
+
+static const struct SearchTestPage search_pages[] = {
+	{ PAGETYPE_GRID_LANDING, "index.html", "Home Page", "a.html,Apple pie\nb.html,Banana 2024" },
+	{ PAGETYPE_ARTICLE, "a.html", "Apple", "<p class=\"attribute\">An apple &amp; a pear, apple-pie. \xc3\x89t\xc3\xa9</p>" },
+	{ PAGETYPE_ARTICLE, "b.html", "Banana", "<h1>Bananas</h1> x 2024 zz_top thisisaverylongwordthatislongerthanfortyeightcharacters" },
+	{ PAGETYPE_ARTICLE, "c.html", "Empty", "<p>q</p>" },
+	{ PAGETYPE_ARTICLE, "d.html", "Zebra", NULL }	// body is "word " many times over
+};
+
+// Every term the pages hold, in shard file order, with its documents.
+struct ExpectedTerm {
+	char shard;
+	const char *term;
+	unsigned int documents[4];
+	size_t documents_length;
+};
+
+static const struct ExpectedTerm expected_terms[] = {
+	{ 'a', "an", { 1 }, 1 },
+	{ 'a', "apple", { 0, 1 }, 2 },
+	{ 'b', "banana", { 0, 2 }, 2 },
+	{ 'b', "bananas", { 2 }, 1 },
+	{ 'e', "empty", { 3 }, 1 },
+	{ 'h', "home", { 0 }, 1 },
+	{ 'p', "page", { 0 }, 1 },
+	{ 'p', "pear", { 1 }, 1 },
+	{ 'p', "pie", { 0, 1 }, 2 },
+	{ 't', "top", { 2 }, 1 },
+	{ 'w', "word", { 4 }, 1 },
+	{ 'z', "zebra", { 4 }, 1 },
+	{ 'z', "zz", { 2 }, 1 },
+	{ '0', "2024", { 0, 2 }, 2 },
+	{ '_', "\xc3\x89t\xc3\xa9", { 1 }, 1 }
+};
+
+static const char shard_names[SEARCH_SHARDS] = "abcdefghijklmnopqrstuvwxyz0_";
+
+static int test_remove_entry(const char *path, const struct stat *status, int type, struct FTW *walk) {
+	(void) status;
+	(void) type;
+	(void) walk;
+	return remove(path);
+}
+
+static struct Page* test_page_create(const struct SearchTestPage *test_page) {
+	struct Page *page = page_create(test_page->page_type, (char*) test_page->title, (char*) test_page->path);
+	if (page == NULL)
+		return NULL;
+
+	bool success = true;
+	if (test_page->page_type == PAGETYPE_GRID_LANDING) {
+		char items[256];
+		snprintf(items, sizeof(items), "%s", test_page->body);
+		for (char *line = strtok(items, "\n"); line != NULL && success; line = strtok(NULL, "\n")) {
+			char *comma = strchr(line, ',');
+			*comma = '\0';
+			success = grid_page_add(page->page_data, line, comma + 1) == GRID_PAGE_ERROR_NONE;
+		}
+	} else if (test_page->body != NULL) {
+		success = article_page_set_body(page->page_data, (char*) test_page->body, strlen(test_page->body)) == STRING_ERROR_NONE;
+	} else {
+		// Enough repeats to fill and compact the posting list several times over
+		size_t repeats = 100000;
+		char *body = malloc(repeats * 5 + 1);
+		success = body != NULL;
+		for (size_t i = 0; success && i < repeats; i++)
+			memcpy(body + i * 5, "word ", 5);
+		success = success && article_page_set_body(page->page_data, body, repeats * 5) == STRING_ERROR_NONE;
+		free(body);
+	}
+
+	if (!success) {
+		page_destroy(page);
+		return NULL;
+	}
+	return page;
+}
+
+static char* test_read_file(const char *path, size_t *length) {
+	FILE *input = fopen(path, "rb");
+	if (input == NULL)
+		return NULL;
+
+	fseek(input, 0, SEEK_END);
+	long size = ftell(input);
+	rewind(input);
+	char *data = malloc((size_t) size + 1);
+	if (data != NULL && fread(data, 1, (size_t) size, input) != (size_t) size) {
+		free(data);
+		data = NULL;
+	}
+	fclose(input);
+	if (data != NULL) {
+		data[size] = '\0';
+		*length = (size_t) size;
+	}
+	return data;
+}
+
+static bool test_read_varint(const unsigned char **cursor, const unsigned char *end, unsigned long long *value) {
+	*value = 0;
+	for (int shift = 0; *cursor < end && shift < 64; shift += 7) {
+		unsigned char byte = *(*cursor)++;
+		*value |= (unsigned long long) (byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+// Decodes one shard and checks it holds exactly the expected terms of that
+// shard, in order, each with its document ids.
+static bool check_shard(const char *directory, unsigned int shard) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/search/%c.idx", directory, shard_names[shard]);
+
+	size_t expected_first = 0;
+	while (expected_first < sizeof(expected_terms) / sizeof(expected_terms[0]) && expected_terms[expected_first].shard != shard_names[shard])
+		expected_first++;
+	size_t expected_length = 0;
+	while (expected_first + expected_length < sizeof(expected_terms) / sizeof(expected_terms[0]) &&
+	       expected_terms[expected_first + expected_length].shard == shard_names[shard])
+		expected_length++;
+
+	size_t length = 0;
+	char *data = test_read_file(path, &length);
+	if (data == NULL) {
+		if (expected_length == 0)
+			return true;
+		fprintf(stderr, "[check_shard] Shard '%c' is missing.\n", shard_names[shard]);
+		return false;
+	}
+	if (expected_length == 0) {
+		fprintf(stderr, "[check_shard] Shard '%c' holds no terms but was written.\n", shard_names[shard]);
+		free(data);
+		return false;
+	}
+
+	const unsigned char *cursor = (const unsigned char*) data;
+	const unsigned char *end = cursor + length;
+	unsigned long long terms = 0;
+	bool passed = length > 5 && memcmp(data, "WPGS\x01", 5) == 0;
+	cursor += 5;
+	passed = passed && test_read_varint(&cursor, end, &terms) && terms == expected_length;
+
+	for (size_t i = 0; passed && i < expected_length; i++) {
+		const struct ExpectedTerm *expected = &expected_terms[expected_first + i];
+		unsigned long long term_length = 0;
+		unsigned long long postings = 0;
+		passed = test_read_varint(&cursor, end, &term_length) && term_length == strlen(expected->term) &&
+			(size_t) (end - cursor) >= term_length && memcmp(cursor, expected->term, term_length) == 0;
+		cursor += passed ? term_length : 0;
+		passed = passed && test_read_varint(&cursor, end, &postings) && postings == expected->documents_length;
+
+		unsigned long long document = 0;
+		for (size_t j = 0; passed && j < postings; j++) {
+			unsigned long long delta = 0;
+			passed = test_read_varint(&cursor, end, &delta) && (j == 0 || delta > 0);
+			document += delta;
+			passed = passed && document == expected->documents[j];
+		}
+		if (!passed)
+			fprintf(stderr, "[check_shard] Term \"%s\" of shard '%c' did not decode as expected.\n", expected->term, shard_names[shard]);
+	}
+
+	if (passed && cursor != end) {
+		fprintf(stderr, "[check_shard] Shard '%c' has %zu bytes after its last term.\n", shard_names[shard], (size_t) (end - cursor));
+		passed = false;
+	} else if (!passed) {
+		fprintf(stderr, "[check_shard] Shard '%c' does not match the expected terms.\n", shard_names[shard]);
+	}
+
+	free(data);
+	return passed;
+}
+
+static bool check_build(const char *directory, unsigned int threads, char **reference, size_t *reference_lengths) {
+	struct Site *site = site_create((char*) directory, "https://example.com");
+	if (site == NULL)
+		return false;
+	site->emit_sitemap = false;
+	site->emit_link_index = false;
+	site->emit_search_index = true;
+	site->threads = threads;
+
+	size_t pages_length = sizeof(search_pages) / sizeof(search_pages[0]);
+	bool passed = true;
+	for (size_t i = 0; i < pages_length && passed; i++) {
+		struct Page *page = test_page_create(&search_pages[i]);
+		passed = page != NULL && site_add_page(site, page) == SITE_ERROR_NONE;
+	}
+	passed = passed && site_build(site) == SITE_ERROR_NONE;
+	site_destroy(site);
+	if (!passed) {
+		fprintf(stderr, "[check_build] The site did not build with %u threads.\n", threads);
+		return false;
+	}
+
+	// Document ids are the line numbers of documents.tsv, in page order
+	char path[4096];
+	size_t length = 0;
+	snprintf(path, sizeof(path), "%s/search/documents.tsv", directory);
+	char *documents = test_read_file(path, &length);
+	const char *expected_documents = "index.html\tHome Page\na.html\tApple\nb.html\tBanana\nc.html\tEmpty\nd.html\tZebra\n";
+	if (documents == NULL || strcmp(documents, expected_documents) != 0) {
+		fprintf(stderr, "[check_build] documents.tsv with %u threads is \"%s\".\n", threads, documents != NULL ? documents : "(missing)");
+		passed = false;
+	}
+	free(documents);
+
+	for (unsigned int shard = 0; shard < SEARCH_SHARDS; shard++) {
+		if (!check_shard(directory, shard))
+			passed = false;
+
+		// Every thread count writes the same bytes as the first build
+		snprintf(path, sizeof(path), "%s/search/%c.idx", directory, shard_names[shard]);
+		char *data = test_read_file(path, &length);
+		if (reference[shard] == NULL && threads == 1) {
+			reference[shard] = data;
+			reference_lengths[shard] = data != NULL ? length : 0;
+			continue;
+		}
+		if ((data == NULL) != (reference[shard] == NULL) ||
+		    (data != NULL && (length != reference_lengths[shard] || memcmp(data, reference[shard], length) != 0))) {
+			fprintf(stderr, "[check_build] Shard '%c' with %u threads differs from the single threaded build.\n", shard_names[shard], threads);
+			passed = false;
+		}
+		free(data);
+	}
+	return passed;
+}
+
+int main() {
+	char directory[] = "/tmp/wpg_search_test_XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		fprintf(stderr, "[main] Failed to create a scratch directory.\n");
+		return 1;
+	}
+
+	static const unsigned int thread_counts[] = { 1, 2, 3, 5 };
+	size_t builds = sizeof(thread_counts) / sizeof(thread_counts[0]);
+	char *reference[SEARCH_SHARDS] = { 0 };
+	size_t reference_lengths[SEARCH_SHARDS] = { 0 };
+	size_t failures = 0;
+	for (size_t i = 0; i < builds; i++) {
+		if (!check_build(directory, thread_counts[i], reference, reference_lengths))
+			failures++;
+	}
+
+	for (unsigned int shard = 0; shard < SEARCH_SHARDS; shard++)
+		free(reference[shard]);
+	nftw(directory, test_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	printf("%zu/%zu search builds passed\n", builds - failures, builds);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,340 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../wpglib.h"
+#include "../wpgsite.h"
+
+// Whole site builds into a scratch directory:
+//     ./site_test
+
+// Hands out one article per path, in order, as a streaming build's page source.
+struct TestSource {
+	const char **paths;
+	size_t paths_length;
+	size_t next;
+};
+
+static enum SiteError test_source_next(void *context, struct Page **page) {
+	struct TestSource *source = context;
+	*page = NULL;
+	if (source->next >= source->paths_length)
+		return SITE_ERROR_NONE;
+
+	const char *path = source->paths[source->next++];
+	char body[256];
+	int body_length = snprintf(body, sizeof(body), "<p>The page written to %s.</p>", path);
+	*page = page_create(PAGETYPE_ARTICLE, "Test page", (char*) path);
+	if (*page == NULL || article_page_set_body((*page)->page_data, body, body_length) != STRING_ERROR_NONE)
+		return SITE_ERROR_FAILED_SOURCE;
+	return SITE_ERROR_NONE;
+}
+
+static int test_remove_entry(const char *path, const struct stat *status, int type, struct FTW *walk) {
+	(void) status;
+	(void) type;
+	(void) walk;
+	return remove(path);
+}
+
+static void test_remove_tree(const char *directory) {
+	nftw(directory, test_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static bool test_exists(const char *directory, const char *name) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s", directory, name);
+	return access(path, F_OK) == 0;
+}
+
+struct StreamingCase {
+	const char *name;
+	const char *paths[4];
+	size_t paths_length;
+	size_t memory_budget;	// 1 puts every page in a batch of its own
+	bool emit_sitemap;
+	bool reproducible;
+	enum SiteError expected;
+};
+
+static const struct StreamingCase streaming_cases[] = {
+	{ "distinct paths", { "index.html", "about.html", "blog/post.html" }, 3, 1, true, false, SITE_ERROR_NONE },
+	{ "duplicate within a batch", { "index.html", "about.html", "about.html" }, 3, 64 * 1024 * 1024, true, false, SITE_ERROR_DUPLICATE_PATH },
+	{ "duplicate across batches", { "about.html", "index.html", "about.html" }, 3, 1, true, false, SITE_ERROR_DUPLICATE_PATH },
+	{ "duplicate across batches without a sitemap", { "about.html", "index.html", "about.html" }, 3, 1, false, false, SITE_ERROR_DUPLICATE_PATH },
+	{ "duplicate across batches when reproducible", { "about.html", "index.html", "about.html" }, 3, 1, true, true, SITE_ERROR_DUPLICATE_PATH },
+	{ "leading slash duplicate", { "about.html", "/about.html" }, 2, 64 * 1024 * 1024, false, false, SITE_ERROR_DUPLICATE_PATH }
+};
+
+static bool check_streaming(const char *directory, const struct StreamingCase *test) {
+	char output_directory[4096];
+	snprintf(output_directory, sizeof(output_directory), "%s/streaming", directory);
+
+	struct Site *site = site_create(output_directory, "https://example.com");
+	if (site == NULL)
+		return false;
+	site->memory_budget = test->memory_budget;
+	site->emit_sitemap = test->emit_sitemap;
+	site->reproducible = test->reproducible;
+	site->threads = 2;
+
+	struct TestSource source_context = { .paths = (const char**) test->paths, .paths_length = test->paths_length };
+	struct PageSource source = { .next = test_source_next, .context = &source_context };
+	enum SiteError error = site_build_streaming(site, &source);
+	site_destroy(site);
+
+	bool passed = error == test->expected;
+	if (!passed)
+		fprintf(stderr, "[check_streaming] \"%s\" returned %d, expected %d.\n", test->name, error, test->expected);
+
+	// A duplicate within one batch is caught before anything in it is written
+	if (passed && test->memory_budget > 1 && test->expected == SITE_ERROR_DUPLICATE_PATH && test_exists(output_directory, "about.html")) {
+		fprintf(stderr, "[check_streaming] \"%s\" wrote its batch before rejecting it.\n", test->name);
+		passed = false;
+	}
+
+	test_remove_tree(output_directory);
+	return passed;
+}
+
+// Features that need every page in memory fail a streaming build up front
+// rather than being left out of a build that reports success.
+static bool check_streaming_needs_all_pages(const char *directory) {
+	static const char *paths[] = { "index.html", "about.html" };
+	char output_directory[4096];
+	snprintf(output_directory, sizeof(output_directory), "%s/streaming", directory);
+
+	bool passed = true;
+	for (int feature = 0; feature < 3; feature++) {
+		struct Site *site = site_create(output_directory, "https://example.com");
+		if (site == NULL)
+			return false;
+		site->memory_budget = 64 * 1024 * 1024;
+		site->validate_links = feature == 0;
+		site->navigation = feature == 1;
+		site->emit_search_index = feature == 2;
+
+		struct TestSource source_context = { .paths = paths, .paths_length = 2 };
+		struct PageSource source = { .next = test_source_next, .context = &source_context };
+		enum SiteError error = site_build_streaming(site, &source);
+		site_destroy(site);
+
+		if (error != SITE_ERROR_NEEDS_ALL_PAGES || test_exists(output_directory, "index.html")) {
+			fprintf(stderr, "[check_streaming_needs_all_pages] Feature %d returned %d, expected %d with nothing written.\n", feature, error, SITE_ERROR_NEEDS_ALL_PAGES);
+			passed = false;
+		}
+		test_remove_tree(output_directory);
+	}
+	return passed;
+}
+
+// Pages for the reproducible builds: a grid landing page and articles that
+// link to their neighbours, so navigation and the link index have content.
+#define REPRODUCIBLE_ARTICLES 24
+
+static bool test_write_file(const char *directory, const char *name, const char *text) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s", directory, name);
+	FILE *output = fopen(path, "wb");
+	if (output == NULL)
+		return false;
+	bool written = fputs(text, output) >= 0;
+	return fclose(output) == 0 && written;
+}
+
+static struct Page* test_reproducible_page(size_t index) {
+	char path[64];
+	char title[64];
+	if (index == REPRODUCIBLE_ARTICLES) {
+		struct Page *page = page_create(PAGETYPE_GRID_LANDING, "Home", "index.html");
+		for (size_t i = 0; page != NULL && i < REPRODUCIBLE_ARTICLES; i++) {
+			snprintf(path, sizeof(path), "posts/%zu.html", i);
+			snprintf(title, sizeof(title), "Post %zu", i);
+			if (grid_page_add(page->page_data, path, title) != GRID_PAGE_ERROR_NONE) {
+				page_destroy(page);
+				return NULL;
+			}
+		}
+		return page;
+	}
+
+	char body[512];
+	snprintf(path, sizeof(path), "posts/%zu.html", index);
+	snprintf(title, sizeof(title), "Post %zu", index);
+	int body_length = snprintf(body, sizeof(body),
+		"<!-- post %zu -->\n<p>Post %zu of the series on <a href=\"%zu.html\">the next</a> and <a href=\"/posts/%zu.html\">another</a> topic.</p>\n",
+		index, index, (index + 1) % REPRODUCIBLE_ARTICLES, (index * 7) % REPRODUCIBLE_ARTICLES);
+	struct Page *page = page_create(PAGETYPE_ARTICLE, title, path);
+	if (page != NULL && article_page_set_body(page->page_data, body, body_length) != STRING_ERROR_NONE) {
+		page_destroy(page);
+		return NULL;
+	}
+	return page;
+}
+
+// Builds every feature a whole-site build offers, adding pages in reverse when
+// asked so that the output cannot depend on the order they arrive in.
+static bool test_reproducible_build(const char *directory, const char *output_directory, unsigned int threads, bool reverse) {
+	char head_path[4096];
+	char asset_directory[4096];
+	snprintf(head_path, sizeof(head_path), "%s/head.html", directory);
+	snprintf(asset_directory, sizeof(asset_directory), "%s/assets", directory);
+
+	struct Site *site = site_create((char*) output_directory, "https://example.com");
+	if (site == NULL)
+		return false;
+	site->threads = threads;
+	site->reproducible = true;
+	site->emit_search_index = true;
+	site->navigation = true;
+	site->minify = true;
+	site->layout = layout_create(head_path, NULL, NULL, NULL);
+	site->assets = asset_set_create(asset_directory);
+
+	bool passed = site->layout != NULL && site->assets != NULL && asset_set_add(site->assets, "css/site.css") == ASSET_ERROR_NONE;
+	for (size_t i = 0; passed && i <= REPRODUCIBLE_ARTICLES; i++) {
+		struct Page *page = test_reproducible_page(reverse ? REPRODUCIBLE_ARTICLES - i : i);
+		passed = page != NULL && site_add_page(site, page) == SITE_ERROR_NONE;
+	}
+	passed = passed && site_build(site) == SITE_ERROR_NONE;
+	site_destroy(site);
+	return passed;
+}
+
+// nftw takes no context, so the trees being compared are held here.
+static const char *compare_root;
+static const char *compare_other_root;
+static size_t compare_files;
+static bool compare_equal;
+
+static int test_compare_entry(const char *path, const struct stat *status, int type, struct FTW *walk) {
+	(void) walk;
+	if (type != FTW_F)
+		return 0;
+
+	char other_path[4096];
+	snprintf(other_path, sizeof(other_path), "%s%s", compare_other_root, path + strlen(compare_root));
+	compare_files++;
+
+	FILE *input = fopen(path, "rb");
+	FILE *other_input = fopen(other_path, "rb");
+	bool equal = input != NULL && other_input != NULL;
+	char block[4096];
+	char other_block[4096];
+	while (equal) {
+		size_t read = fread(block, 1, sizeof(block), input);
+		size_t other_read = fread(other_block, 1, sizeof(other_block), other_input);
+		equal = read == other_read && memcmp(block, other_block, read) == 0;
+		if (read < sizeof(block))
+			break;
+	}
+	if (input != NULL)
+		fclose(input);
+	if (other_input != NULL)
+		fclose(other_input);
+
+	if (!equal) {
+		fprintf(stderr, "[test_compare_entry] \"%s\" (%lld bytes) differs from \"%s\".\n", path, (long long) status->st_size, other_path);
+		compare_equal = false;
+	}
+	return 0;
+}
+
+// True if both trees hold the same files with the same bytes.
+static bool test_compare_trees(const char *a, const char *b) {
+	size_t files[2] = { 0 };
+	compare_equal = true;
+	for (int pass = 0; pass < 2; pass++) {
+		compare_root = pass == 0 ? a : b;
+		compare_other_root = pass == 0 ? b : a;
+		compare_files = 0;
+		if (nftw(compare_root, test_compare_entry, 16, FTW_PHYS) != 0)
+			return false;
+		files[pass] = compare_files;
+	}
+	return compare_equal && files[0] == files[1] && files[0] > 0;
+}
+
+// A reproducible build with threads=1 and with several threads, fed its pages
+// in opposite orders, writes identical trees. The sitemap dates every URL from
+// SOURCE_DATE_EPOCH, and leaves lastmod out rather than use the clock without it.
+static bool check_reproducible(const char *directory) {
+	char single[4096];
+	char parallel[4096];
+	char assets[4096];
+	char stylesheets[4096];
+	snprintf(single, sizeof(single), "%s/single", directory);
+	snprintf(parallel, sizeof(parallel), "%s/parallel", directory);
+	snprintf(assets, sizeof(assets), "%s/assets", directory);
+	snprintf(stylesheets, sizeof(stylesheets), "%s/assets/css", directory);
+	if (mkdir(assets, 0755) != 0 || mkdir(stylesheets, 0755) != 0 ||
+	    !test_write_file(stylesheets, "site.css", "body { margin: 0; }\n") ||
+	    !test_write_file(directory, "head.html", "<link rel=\"stylesheet\" href=\"/css/site.css\">\n"))
+		return false;
+
+	static const char *epochs[] = { "1700000000", NULL };
+	static const char *expected_lastmod[] = { "<lastmod>2023-11-14</lastmod>", NULL };
+	bool passed = true;
+	for (size_t i = 0; i < sizeof(epochs) / sizeof(epochs[0]) && passed; i++) {
+		if (epochs[i] != NULL)
+			setenv("SOURCE_DATE_EPOCH", epochs[i], 1);
+		else
+			unsetenv("SOURCE_DATE_EPOCH");
+
+		if (!test_reproducible_build(directory, single, 1, false) || !test_reproducible_build(directory, parallel, 4, true)) {
+			fprintf(stderr, "[check_reproducible] The site did not build.\n");
+			passed = false;
+		} else if (!test_compare_trees(single, parallel)) {
+			fprintf(stderr, "[check_reproducible] Builds with 1 and 4 threads differ with SOURCE_DATE_EPOCH %s.\n", epochs[i] != NULL ? epochs[i] : "unset");
+			passed = false;
+		}
+
+		char shard_path[4096];
+		snprintf(shard_path, sizeof(shard_path), "%s/sitemap-1.xml", single);
+		FILE *shard = fopen(shard_path, "rb");
+		char text[8192] = { 0 };
+		if (shard != NULL) {
+			text[fread(text, 1, sizeof(text) - 1, shard)] = '\0';
+			fclose(shard);
+		}
+		bool dated = strstr(text, "<lastmod>") != NULL;
+		if (passed && (shard == NULL || (expected_lastmod[i] != NULL ? strstr(text, expected_lastmod[i]) == NULL : dated))) {
+			fprintf(stderr, "[check_reproducible] sitemap-1.xml with SOURCE_DATE_EPOCH %s is \"%s\".\n", epochs[i] != NULL ? epochs[i] : "unset", text);
+			passed = false;
+		}
+
+		test_remove_tree(single);
+		test_remove_tree(parallel);
+	}
+
+	unsetenv("SOURCE_DATE_EPOCH");
+	return passed;
+}
+
+int main() {
+	char directory[] = "/tmp/wpg_site_test_XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		fprintf(stderr, "[main] Failed to create a scratch directory.\n");
+		return 1;
+	}
+
+	size_t cases_length = sizeof(streaming_cases) / sizeof(streaming_cases[0]);
+	size_t failures = 0;
+	for (size_t i = 0; i < cases_length; i++) {
+		if (!check_streaming(directory, &streaming_cases[i]))
+			failures++;
+	}
+
+	if (!check_streaming_needs_all_pages(directory))
+		failures++;
+	if (!check_reproducible(directory))
+		failures++;
+
+	test_remove_tree(directory);
+	printf("%zu/%zu site cases passed\n", cases_length + 2 - failures, cases_length + 2);
+	return failures == 0 ? 0 : 1;
+}
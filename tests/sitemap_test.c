@@ -0,0 +1,193 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../wpgsitemap.h"
+
+// Sitemap shard rollover at the protocol's URL and byte limits, the sitemap
+// index and percent-encoding of paths:
+//     ./sitemap_test
+
+static const char urlset_header[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<urlset xmlns=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n";
+static const char urlset_footer[] = "</urlset>\n";
+
+static int test_remove_entry(const char *path, const struct stat *status, int type, struct FTW *walk) {
+	(void) status;
+	(void) type;
+	(void) walk;
+	return remove(path);
+}
+
+static char* test_read_file(const char *directory, const char *name, size_t *length) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s", directory, name);
+	FILE *input = fopen(path, "rb");
+	if (input == NULL)
+		return NULL;
+
+	fseek(input, 0, SEEK_END);
+	long size = ftell(input);
+	rewind(input);
+	char *data = malloc((size_t) size + 1);
+	if (data != NULL && fread(data, 1, (size_t) size, input) != (size_t) size) {
+		free(data);
+		data = NULL;
+	}
+	fclose(input);
+	if (data != NULL) {
+		data[size] = '\0';
+		*length = (size_t) size;
+	}
+	return data;
+}
+
+// Plain loop rather than strstr, which sanitizers rescan in full on every call.
+static size_t test_count(const char *text, size_t length, const char *needle) {
+	size_t needle_length = strlen(needle);
+	size_t count = 0;
+	for (size_t i = 0; i + needle_length <= length; i++) {
+		if (text[i] == needle[0] && memcmp(text + i, needle, needle_length) == 0)
+			count++;
+	}
+	return count;
+}
+
+// Checks that sitemap.xml lists shards 1 to shards_length, in order, and nothing else.
+static bool check_index(const char *directory, size_t shards_length) {
+	size_t length = 0;
+	char *index = test_read_file(directory, "sitemap.xml", &length);
+	if (index == NULL) {
+		fprintf(stderr, "[check_index] sitemap.xml is missing.\n");
+		return false;
+	}
+
+	char expected[4096];
+	size_t expected_length = (size_t) snprintf(expected, sizeof(expected),
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<sitemapindex xmlns=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n");
+	for (size_t i = 1; i <= shards_length; i++)
+		expected_length += (size_t) snprintf(expected + expected_length, sizeof(expected) - expected_length,
+			"<sitemap><loc>https://example.com/sitemap-%zu.xml</loc></sitemap>\n", i);
+	snprintf(expected + expected_length, sizeof(expected) - expected_length, "</sitemapindex>\n");
+
+	bool passed = strcmp(index, expected) == 0;
+	if (!passed)
+		fprintf(stderr, "[check_index] sitemap.xml is \"%s\", expected \"%s\".\n", index, expected);
+	free(index);
+	return passed;
+}
+
+// Adds urls_length paths of path_length bytes, then checks each shard is a
+// complete urlset within both limits holding the expected number of URLs.
+static bool check_rollover(const char *directory, const char *name, size_t urls_length, size_t path_length, const size_t *shard_urls, size_t shards_length) {
+	struct SitemapWriter *writer = sitemap_writer_create((char*) directory, "https://example.com/", NULL);
+	if (writer == NULL)
+		return false;
+
+	char *path = malloc(path_length + 1);
+	bool passed = path != NULL;
+	for (size_t i = 0; passed && i < urls_length; i++) {
+		int prefix = snprintf(path, path_length + 1, "p/%zu/", i);
+		memset(path + prefix, 'x', path_length - (size_t) prefix);
+		path[path_length] = '\0';
+		passed = sitemap_writer_add(writer, path) == SITEMAP_ERROR_NONE;
+	}
+	passed = passed && sitemap_writer_finish(writer) == SITEMAP_ERROR_NONE && writer->shards_length == shards_length;
+	sitemap_writer_destroy(writer);
+	free(path);
+	if (!passed) {
+		fprintf(stderr, "[check_rollover] \"%s\" did not write %zu shards.\n", name, shards_length);
+		return false;
+	}
+
+	size_t entry_length = strlen("<url><loc>https://example.com/</loc></url>\n") + path_length;
+	for (size_t i = 0; i < shards_length && passed; i++) {
+		char shard_name[64];
+		size_t length = 0;
+		snprintf(shard_name, sizeof(shard_name), "sitemap-%zu.xml", i + 1);
+		char *shard = test_read_file(directory, shard_name, &length);
+		size_t expected_length = sizeof(urlset_header) - 1 + shard_urls[i] * entry_length + sizeof(urlset_footer) - 1;
+		passed = shard != NULL && length == expected_length && length <= SITEMAP_MAX_BYTES &&
+			memcmp(shard, urlset_header, sizeof(urlset_header) - 1) == 0 &&
+			strcmp(shard + length - (sizeof(urlset_footer) - 1), urlset_footer) == 0 &&
+			test_count(shard, length, "<url>") == shard_urls[i] && shard_urls[i] <= SITEMAP_MAX_URLS;
+		if (!passed)
+			fprintf(stderr, "[check_rollover] \"%s\" shard %zu is %zu bytes, expected %zu URLs in %zu bytes.\n", name, i + 1, length, shard_urls[i], expected_length);
+
+		// A full shard could not have taken one more entry
+		if (passed && i + 1 < shards_length && shard_urls[i] < SITEMAP_MAX_URLS && length + entry_length <= SITEMAP_MAX_BYTES) {
+			fprintf(stderr, "[check_rollover] \"%s\" shard %zu was closed with room left.\n", name, i + 1);
+			passed = false;
+		}
+		free(shard);
+	}
+
+	return passed && check_index(directory, shards_length);
+}
+
+// Everything but unreserved characters and '/' is percent-encoded, and the
+// base URL is XML escaped.
+static bool check_encoding(const char *directory) {
+	struct SitemapWriter *writer = sitemap_writer_create((char*) directory, "https://example.com/a&b//", "2024-01-02");
+	if (writer == NULL)
+		return false;
+
+	bool passed = sitemap_writer_add(writer, "//a b/\xc3\xbc?x=1&y<z>\"'#.html") == SITEMAP_ERROR_NONE &&
+		sitemap_writer_add(writer, "docs/-._~AZaz09.html") == SITEMAP_ERROR_NONE &&
+		sitemap_writer_finish(writer) == SITEMAP_ERROR_NONE;
+	sitemap_writer_destroy(writer);
+
+	size_t length = 0;
+	char *shard = test_read_file(directory, "sitemap-1.xml", &length);
+	char expected[1024];
+	snprintf(expected, sizeof(expected), "%s%s%s%s", urlset_header,
+		"<url><loc>https://example.com/a&amp;b/a%20b/%C3%BC%3Fx%3D1%26y%3Cz%3E%22%27%23.html</loc><lastmod>2024-01-02</lastmod></url>\n",
+		"<url><loc>https://example.com/a&amp;b/docs/-._~AZaz09.html</loc><lastmod>2024-01-02</lastmod></url>\n", urlset_footer);
+	passed = passed && shard != NULL && strcmp(shard, expected) == 0;
+	if (!passed)
+		fprintf(stderr, "[check_encoding] sitemap-1.xml is \"%s\", expected \"%s\".\n", shard != NULL ? shard : "(missing)", expected);
+	free(shard);
+	return passed;
+}
+
+static void test_clear(const char *directory) {
+	nftw(directory, test_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	mkdir(directory, 0755);
+}
+
+int main() {
+	char directory[] = "/tmp/wpg_sitemap_test_XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		fprintf(stderr, "[main] Failed to create a scratch directory.\n");
+		return 1;
+	}
+
+	// 50,001 short URLs roll over on the URL limit; 2 KiB paths reach the byte
+	// limit first, after 50 MiB / ~2 KiB entries
+	static const size_t url_limit_shards[] = { SITEMAP_MAX_URLS, 1 };
+	size_t entry_length = strlen("<url><loc>https://example.com/</loc></url>\n") + 2048;
+	size_t per_shard = (SITEMAP_MAX_BYTES - (sizeof(urlset_header) - 1) - (sizeof(urlset_footer) - 1)) / entry_length;
+	size_t byte_limit_shards[] = { per_shard, 100 };
+
+	size_t failures = 0;
+	if (!check_rollover(directory, "URL limit", SITEMAP_MAX_URLS + 1, 16, url_limit_shards, 2))
+		failures++;
+	test_clear(directory);
+	if (!check_rollover(directory, "byte limit", per_shard + 100, 2048, byte_limit_shards, 2))
+		failures++;
+	test_clear(directory);
+	if (!check_rollover(directory, "no URLs", 0, 16, NULL, 0))
+		failures++;
+	test_clear(directory);
+	if (!check_encoding(directory))
+		failures++;
+
+	nftw(directory, test_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	printf("%zu/4 sitemap cases passed\n", 4 - failures);
+	return failures == 0 ? 0 : 1;
+}
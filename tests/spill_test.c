@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "../wpgspill.h"
+
+// Spill round trip: random records, many of them repeated, are added under
+// budgets small enough to write thousands of runs, and must merge back out as
+// exactly the sorted input, duplicates included. The descriptor limit is
+// lowered first so that opening every run at once would fail:
+//     ./spill_test [seed] [records]
+
+struct SpillRecord {
+	char key[16];
+	char value[16];
+};
+
+struct SpillCheck {
+	struct SpillRecord *expected;
+	size_t expected_length;
+	size_t emitted;
+	bool matches;
+};
+
+static unsigned long long rng_state;
+
+static unsigned long long rng_next() {
+	// xorshift64*
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 2685821657736338717ULL;
+}
+
+static int record_compare(const void *a, const void *b) {
+	const struct SpillRecord *left = a;
+	const struct SpillRecord *right = b;
+	int order = strcmp(left->key, right->key);
+	if (order != 0)
+		return order;
+	return strcmp(left->value, right->value);
+}
+
+static bool check_emit(const char *key, const char *value, void *context) {
+	struct SpillCheck *check = context;
+	if (check->emitted >= check->expected_length || strcmp(key, check->expected[check->emitted].key) != 0 ||
+	    strcmp(value, check->expected[check->emitted].value) != 0) {
+		if (check->matches)
+			fprintf(stderr, "[check_emit] Record %zu came out as (\"%s\", \"%s\").\n", check->emitted, key, value);
+		check->matches = false;
+	}
+	check->emitted++;
+	return true;
+}
+
+static bool check_budget(const char *directory, struct SpillRecord *records, struct SpillRecord *sorted, size_t records_length, size_t budget) {
+	struct Spill *spill = spill_create((char*) directory, "test", budget);
+	if (spill == NULL)
+		return false;
+
+	bool passed = true;
+	for (size_t i = 0; i < records_length && passed; i++)
+		passed = spill_add(spill, records[i].key, records[i].value) == SPILL_ERROR_NONE;
+
+	struct SpillCheck check = { .expected = sorted, .expected_length = records_length, .matches = true };
+	size_t runs = spill->runs_length;
+	passed = passed && spill_merge(spill, check_emit, &check) == SPILL_ERROR_NONE;
+	if (!passed || !check.matches || check.emitted != records_length) {
+		fprintf(stderr, "[check_budget] A %zu byte budget over %zu runs emitted %zu of %zu records%s.\n", budget, runs, check.emitted,
+			records_length, check.matches ? "" : " out of order");
+		passed = false;
+	}
+
+	spill_destroy(spill);
+	return passed;
+}
+
+int main(int argc, char **argv) {
+	unsigned long long seed = argc > 1 ? strtoull(argv[1], NULL, 0) : 0x5EED;
+	size_t records_length = argc > 2 ? strtoull(argv[2], NULL, 0) : 20000;
+	rng_state = seed ? seed : 1;
+
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur > 128) {
+		limit.rlim_cur = 128;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+
+	char directory[] = "/tmp/wpg_spill_test_XXXXXX";
+	struct SpillRecord *records = malloc(sizeof(struct SpillRecord) * (records_length ? records_length : 1));
+	struct SpillRecord *sorted = malloc(sizeof(struct SpillRecord) * (records_length ? records_length : 1));
+	if (records == NULL || sorted == NULL || mkdtemp(directory) == NULL) {
+		fprintf(stderr, "[main] Failed to set up the records and scratch directory.\n");
+		return 1;
+	}
+
+	// Few distinct keys and values, so exact duplicates are common
+	for (size_t i = 0; i < records_length; i++) {
+		snprintf(records[i].key, sizeof(records[i].key), "k%llu", rng_next() % 500);
+		snprintf(records[i].value, sizeof(records[i].value), "v%llu", rng_next() % 8);
+	}
+	memcpy(sorted, records, sizeof(struct SpillRecord) * records_length);
+	qsort(sorted, records_length, sizeof(struct SpillRecord), record_compare);
+
+	static const size_t budgets[] = { 1, 256, 4096, 64 * 1024 * 1024 };
+	size_t budgets_length = sizeof(budgets) / sizeof(budgets[0]);
+	size_t failures = 0;
+	for (size_t i = 0; i < budgets_length; i++) {
+		if (!check_budget(directory, records, sorted, records_length, budgets[i]))
+			failures++;
+	}
+
+	free(records);
+	free(sorted);
+	if (rmdir(directory) != 0) {
+		fprintf(stderr, "[main] Run files were left behind in \"%s\".\n", directory);
+		failures++;
+	}
+	printf("%zu/%zu spill budgets passed (seed 0x%llx)\n", budgets_length - failures, budgets_length, seed);
+	return failures == 0 ? 0 : 1;
+}
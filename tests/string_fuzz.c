@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../wpgstring.h"
+#include "../wpgbuffer.h"
+#include "../wpgutf8.h"
+
+// Fuzz target for the String and Buffer layers. Built with clang as a
+// libFuzzer target (-DWPG_LIBFUZZER -fsanitize=fuzzer), or with gcc as a
+// driver that replays the inputs named on the command line.
+//
+// Input layout: 2 bytes start, 2 bytes end, 1 byte step, 1 byte set length
+// divisor, then the text. Any mismatch against the expected result aborts.
+
+static void fuzz_check(int condition, const char *message) {
+	if (!condition) {
+		fprintf(stderr, "[fuzz_check] %s\n", message);
+		abort();
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	if (size < 6)
+		return 0;
+
+	size_t start = data[0] | (data[1] << 8);
+	size_t end = data[2] | (data[3] << 8);
+	size_t step = data[4];
+	size_t divisor = data[5] + 1;
+
+	// The String API takes NUL terminated text, so stop at the first NUL
+	const char *input = (const char*) data + 6;
+	size_t input_length = strnlen(input, size - 6);
+	char *text = malloc(input_length + 1);
+	if (text == NULL)
+		return 0;
+	memcpy(text, input, input_length);
+	text[input_length] = '\0';
+
+	struct String *string = string_create(text);
+	fuzz_check((string != NULL) == (input_length > 0), "string_create accepted or rejected the wrong length");
+
+	if (string != NULL) {
+		fuzz_check(string->length == input_length && memcmp(string->data, text, input_length + 1) == 0, "string_create copied the wrong bytes");
+
+		struct String *spliced = string_splice(string, start, end, step);
+		size_t clamped_end = end > input_length ? input_length : end;
+		fuzz_check((spliced != NULL) == (step > 0 && start < clamped_end), "string_splice accepted or rejected the wrong range");
+		if (spliced != NULL) {
+			size_t expected_length = 0;
+			for (size_t i = start; i < clamped_end; i += step) {
+				fuzz_check(spliced->data[expected_length] == text[i], "string_splice produced the wrong character");
+				expected_length++;
+			}
+			fuzz_check(spliced->length == expected_length && spliced->data[expected_length] == '\0', "string_splice produced the wrong length");
+			string_destroy(spliced);
+		}
+
+		// Shrink then grow the same String
+		size_t set_length = input_length / divisor;
+		enum StringError error = string_set(string, text, set_length);
+		fuzz_check((error == STRING_ERROR_NONE) == (set_length > 0), "string_set accepted or rejected the wrong length");
+		if (error == STRING_ERROR_NONE)
+			fuzz_check(string->length == set_length && memcmp(string->data, text, set_length) == 0 && string->data[set_length] == '\0', "string_set copied the wrong bytes");
+
+		error = string_set(string, text, input_length);
+		fuzz_check(error == STRING_ERROR_NONE && memcmp(string->data, text, input_length + 1) == 0, "string_set failed to grow the String");
+
+		string_destroy(string);
+	}
+
+	// Escaping never shrinks the text and leaves no raw markup characters
+	struct Buffer buffer;
+	if (buffer_init(&buffer, 0) == BUFFER_ERROR_NONE) {
+		fuzz_check(buffer_append_escaped(&buffer, input, size - 6) == BUFFER_ERROR_NONE, "buffer_append_escaped failed");
+		fuzz_check(buffer.length >= size - 6 && buffer.length <= buffer.capacity, "buffer_append_escaped produced the wrong length");
+		for (size_t i = 0; i < buffer.length; i++)
+			fuzz_check(buffer.data[i] != '<' && buffer.data[i] != '>' && buffer.data[i] != '"' && buffer.data[i] != '\'', "buffer_append_escaped left a markup character");
+		buffer_free(&buffer);
+	}
+
+	// Sanitized text is always valid UTF-8, and valid text passes through untouched
+	if (buffer_init(&buffer, 0) == BUFFER_ERROR_NONE) {
+		size_t replacements = utf8_sanitize(input, size - 6, &buffer);
+		fuzz_check(utf8_validate(buffer.data, buffer.length) == buffer.length, "utf8_sanitize produced invalid UTF-8");
+		if (utf8_validate(input, size - 6) == size - 6)
+			fuzz_check(replacements == 0 && buffer.length == size - 6 && memcmp(buffer.data, input, size - 6) == 0, "utf8_sanitize changed valid UTF-8");
+		buffer_free(&buffer);
+	}
+
+	free(text);
+	return 0;
+}
+
+#ifndef WPG_LIBFUZZER
+int main(int argc, char **argv) {
+	for (int i = 1; i < argc; i++) {
+		FILE *input = fopen(argv[i], "rb");
+		if (input == NULL) {
+			fprintf(stderr, "[main] Failed to open fuzz input \"%s\".\n", argv[i]);
+			return 1;
+		}
+
+		uint8_t *data = malloc(1 << 20);
+		if (data == NULL) {
+			fclose(input);
+			return 1;
+		}
+		size_t size = fread(data, 1, 1 << 20, input);
+		fclose(input);
+
+		LLVMFuzzerTestOneInput(data, size);
+		free(data);
+	}
+
+	return 0;
+}
+#endif
@@ -0,0 +1,409 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "../wpgstring.h"
+#include "../wpgbuffer.h"
+#include "../wpgutf8.h"
+
+// Randomized property tests for the String, Buffer and UTF-8 layers. Every
+// operation is checked against a straightforward reference model; run the binary built
+// by ./build (ASan + UBSan) with an optional seed and iteration count:
+//     ./string_property [seed] [iterations]
+
+static unsigned long long rng_state;
+
+static unsigned long long rng_next() {
+	// xorshift64*
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 2685821657736338717ULL;
+}
+
+static size_t rng_range(size_t low, size_t high) {
+	return low + (size_t) (rng_next() % (high - low + 1));
+}
+
+// Fills text with length random non-NUL bytes, mostly printable ASCII.
+static void random_text(char *text, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		if (rng_next() % 8 == 0)
+			text[i] = (char) rng_range(1, 255);
+		else
+			text[i] = (char) rng_range(' ', '~');
+	}
+	text[length] = '\0';
+}
+
+// Longest text random_length returns, well past the old 64 KiB String limit.
+#define RANDOM_LENGTH_MAX (256 * 1024)
+
+// Mostly short texts, with some on either side of a power of two from 32 to
+// 4096, where String's initial capacity and Buffer's doubling end, and some
+// longer than 64 KiB.
+static size_t random_length() {
+	switch (rng_next() % 16) {
+		case 0:
+		case 1:  return ((size_t) 32 << rng_range(0, 7)) + rng_range(0, 4) - 2;
+		case 2:  return rng_range(USHRT_MAX + 1, RANDOM_LENGTH_MAX);
+		case 3:  return rng_range(1000, 5000);
+		default: return rng_range(0, 300);
+	}
+}
+
+// Reference model of string_splice: Python's text[start:end:step] with the
+// library's rule that an empty slice is rejected.
+static size_t model_splice(const char *text, size_t length, size_t start, size_t end, size_t step, char *output) {
+	if (end > length)
+		end = length;
+
+	size_t output_length = 0;
+	for (size_t i = start; i < end; i += step)
+		output[output_length++] = text[i];
+	output[output_length] = '\0';
+	return output_length;
+}
+
+static size_t model_escape(const char *text, size_t length, char *output) {
+	size_t output_length = 0;
+	for (size_t i = 0; i < length; i++) {
+		const char *entity = NULL;
+		if (text[i] == '&')       entity = "&amp;";
+		else if (text[i] == '<')  entity = "&lt;";
+		else if (text[i] == '>')  entity = "&gt;";
+		else if (text[i] == '"')  entity = "&quot;";
+		else if (text[i] == '\'') entity = "&#39;";
+
+		if (entity == NULL) {
+			output[output_length++] = text[i];
+		} else {
+			memcpy(output + output_length, entity, strlen(entity));
+			output_length += strlen(entity);
+		}
+	}
+	return output_length;
+}
+
+// Reference UTF-8 decoder, written from the definition rather than from the
+// byte ranges wpgutf8 uses: the lead byte gives the length, the code point is
+// assembled from the payload bits and then checked for overlong forms,
+// surrogates and values past U+10FFFF. Returns the sequence length at text, or
+// 0 if the sequence there is invalid or cut off.
+static size_t model_utf8_decode(const unsigned char *text, size_t length) {
+	size_t sequence_length;
+	unsigned long code_point;
+	if (text[0] < 0x80)
+		return 1;
+	else if ((text[0] & 0xE0) == 0xC0)
+		sequence_length = 2, code_point = text[0] & 0x1F;
+	else if ((text[0] & 0xF0) == 0xE0)
+		sequence_length = 3, code_point = text[0] & 0x0F;
+	else if ((text[0] & 0xF8) == 0xF0)
+		sequence_length = 4, code_point = text[0] & 0x07;
+	else
+		return 0;
+
+	if (sequence_length > length)
+		return 0;
+	for (size_t i = 1; i < sequence_length; i++) {
+		if ((text[i] & 0xC0) != 0x80)
+			return 0;
+		code_point = (code_point << 6) | (text[i] & 0x3F);
+	}
+
+	static const unsigned long smallest[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+	if (code_point < smallest[sequence_length] || (code_point >= 0xD800 && code_point <= 0xDFFF) || code_point > 0x10FFFF)
+		return 0;
+	return sequence_length;
+}
+
+// True if the first length bytes of text could still begin a valid sequence.
+// Code point limits are intervals, so trying the smallest and the largest
+// continuation bytes covers every completion that matters.
+static bool model_utf8_prefix(const unsigned char *text, size_t length, size_t sequence_length) {
+	for (int fill = 0; fill < 2; fill++) {
+		unsigned char sequence[4];
+		memcpy(sequence, text, length);
+		for (size_t i = length; i < sequence_length; i++)
+			sequence[i] = fill == 0 ? 0x80 : 0xBF;
+		if (model_utf8_decode(sequence, sequence_length) == sequence_length)
+			return true;
+	}
+	return false;
+}
+
+// Reference utf8_sanitize: each maximal subpart of an invalid sequence becomes
+// one U+FFFD, as the Unicode standard recommends.
+static size_t model_utf8_sanitize(const unsigned char *text, size_t length, char *output, size_t *replacements) {
+	size_t output_length = 0;
+	*replacements = 0;
+	for (size_t i = 0; i < length; ) {
+		size_t valid_length = model_utf8_decode(text + i, length - i);
+		if (valid_length > 0) {
+			memcpy(output + output_length, text + i, valid_length);
+			output_length += valid_length;
+			i += valid_length;
+			continue;
+		}
+
+		size_t sequence_length = (text[i] & 0xE0) == 0xC0 ? 2 : (text[i] & 0xF0) == 0xE0 ? 3 : (text[i] & 0xF8) == 0xF0 ? 4 : 1;
+		size_t skip = 1;
+		while (skip < sequence_length && i + skip < length && (text[i + skip] & 0xC0) == 0x80 && model_utf8_prefix(text + i, skip + 1, sequence_length))
+			skip++;
+		if (!model_utf8_prefix(text + i, 1, sequence_length))
+			skip = 1;
+
+		memcpy(output + output_length, "\xEF\xBF\xBD", 3);
+		output_length += 3;
+		(*replacements)++;
+		i += skip;
+	}
+	return output_length;
+}
+
+// Fills text with length bytes of mostly valid UTF-8: encoded code points from
+// every length class, with the occasional stray, truncated or corrupted byte.
+static void random_utf8(char *text, size_t length) {
+	size_t i = 0;
+	while (i < length) {
+		unsigned long code_point;
+		switch (rng_next() % 6) {
+			case 0:  code_point = rng_range(0x01, 0x7F); break;
+			case 1:  code_point = rng_range(0x80, 0x7FF); break;
+			case 2:  code_point = rng_range(0x800, 0xFFFF); break;
+			case 3:  code_point = rng_range(0xD7F0, 0xE010); break;
+			case 4:  code_point = rng_range(0x10000, 0x10FFFF); break;
+			default: code_point = rng_range(0x10FFF0, 0x110010); break;
+		}
+
+		unsigned char sequence[4];
+		size_t sequence_length;
+		if (code_point < 0x80) {
+			sequence[0] = (unsigned char) code_point, sequence_length = 1;
+		} else if (code_point < 0x800) {
+			sequence[0] = 0xC0 | (code_point >> 6), sequence_length = 2;
+		} else if (code_point < 0x10000) {
+			sequence[0] = 0xE0 | (code_point >> 12), sequence_length = 3;
+		} else {
+			sequence[0] = 0xF0 | ((code_point >> 18) & 0x07), sequence_length = 4;
+		}
+		for (size_t j = 1; j < sequence_length; j++)
+			sequence[j] = 0x80 | ((code_point >> (6 * (sequence_length - 1 - j))) & 0x3F);
+
+		switch (rng_next() % 16) {
+			case 0:  sequence_length = rng_range(1, sequence_length); break;	// cut off
+			case 1:  sequence[rng_range(0, sequence_length - 1)] = (unsigned char) rng_range(0x80, 0xFF); break;
+			case 2:  sequence[0] = (unsigned char) rng_range(0xC0, 0xC1); break;	// overlong lead
+			default: break;
+		}
+
+		for (size_t j = 0; j < sequence_length && i < length; j++)
+			text[i++] = (char) sequence[j];
+	}
+	text[length] = '\0';
+}
+
+static bool check_utf8(const char *text, size_t length) {
+	const unsigned char *bytes = (const unsigned char*) text;
+	size_t expected_invalid = 0;
+	while (expected_invalid < length) {
+		size_t sequence_length = model_utf8_decode(bytes + expected_invalid, length - expected_invalid);
+		if (sequence_length == 0)
+			break;
+		expected_invalid += sequence_length;
+	}
+
+	size_t invalid = utf8_validate(text, length);
+	if (invalid != expected_invalid) {
+		fprintf(stderr, "[check_utf8] utf8_validate stopped at %zu of a length %zu text, the model at %zu.\n", invalid, length, expected_invalid);
+		return false;
+	}
+
+	char *expected = malloc(length * 3 + 1);
+	struct Buffer buffer;
+	if (expected == NULL || buffer_init(&buffer, rng_range(0, 16)) != BUFFER_ERROR_NONE) {
+		free(expected);
+		return false;
+	}
+
+	size_t expected_replacements = 0;
+	size_t expected_length = model_utf8_sanitize(bytes, length, expected, &expected_replacements);
+	size_t replacements = utf8_sanitize(text, length, &buffer);
+	bool passed = replacements == expected_replacements && buffer.length == expected_length && memcmp(buffer.data, expected, expected_length) == 0;
+	if (!passed)
+		fprintf(stderr, "[check_utf8] utf8_sanitize made %zu replacements in %zu bytes, the model %zu in %zu bytes.\n", replacements, buffer.length,
+			expected_replacements, expected_length);
+
+	free(expected);
+	buffer_free(&buffer);
+	return passed;
+}
+
+static bool check_string_create(const char *text, size_t length) {
+	struct String *string = string_create((char*) text);
+	bool expect_string = length > 0;
+
+	if (!expect_string) {
+		if (string != NULL) {
+			fprintf(stderr, "[check_string_create] Expected NULL for a text of length %zu.\n", length);
+			string_destroy(string);
+			return false;
+		}
+		return true;
+	}
+
+	if (string == NULL) {
+		fprintf(stderr, "[check_string_create] Unexpected NULL for a text of length %zu.\n", length);
+		return false;
+	}
+
+	bool passed = string->length == length && string->capacity > string->length &&
+		memcmp(string->data, text, length) == 0 && string->data[length] == '\0';
+	if (!passed)
+		fprintf(stderr, "[check_string_create] String of length %zu does not match the text of length %zu.\n", string->length, length);
+
+	string_destroy(string);
+	return passed;
+}
+
+static bool check_string_set(const char *text, size_t length) {
+	struct String *string = string_init();
+	if (string == NULL)
+		return false;
+
+	// Set a few prefixes of varying size to exercise both growing and reuse
+	bool passed = true;
+	for (int round = 0; round < 3 && passed; round++) {
+		size_t set_length = length == 0 ? 0 : rng_range(0, length);
+		enum StringError error = string_set(string, (char*) text, set_length);
+		bool expect_success = set_length > 0;
+
+		if (!expect_success) {
+			passed = error != STRING_ERROR_NONE;
+			if (!passed)
+				fprintf(stderr, "[check_string_set] Expected an error for a length of %zu.\n", set_length);
+			continue;
+		}
+
+		passed = error == STRING_ERROR_NONE && string->length == set_length && string->capacity > string->length &&
+			memcmp(string->data, text, set_length) == 0 && string->data[set_length] == '\0';
+		if (!passed)
+			fprintf(stderr, "[check_string_set] String does not match a text prefix of length %zu.\n", set_length);
+	}
+
+	string_destroy(string);
+	return passed;
+}
+
+static bool check_string_splice(const char *text, size_t length) {
+	if (length == 0)
+		return true;
+
+	struct String *string = string_create((char*) text);
+	if (string == NULL)
+		return false;
+
+	char *expected = malloc(length + 1);
+	if (expected == NULL) {
+		string_destroy(string);
+		return false;
+	}
+
+	bool passed = true;
+	for (int round = 0; round < 8 && passed; round++) {
+		size_t start = rng_range(0, length + 2);
+		size_t end = rng_range(0, length + 2);
+		size_t step = rng_range(0, 6);
+		if (rng_next() % 4 == 0)
+			step = rng_range(1, USHRT_MAX);
+
+		struct String *spliced = string_splice(string, start, end, step);
+		size_t clamped_end = end > length ? length : end;
+		bool expect_string = step > 0 && start < clamped_end;
+
+		if (!expect_string) {
+			passed = spliced == NULL;
+			if (!passed)
+				fprintf(stderr, "[check_string_splice] Expected NULL for [%zu:%zu:%zu] of a length %zu text.\n", start, end, step, length);
+		} else {
+			size_t expected_length = model_splice(text, length, start, end, step, expected);
+			passed = spliced != NULL && spliced->length == expected_length && spliced->capacity > spliced->length &&
+				memcmp(spliced->data, expected, expected_length + 1) == 0;
+			if (!passed)
+				fprintf(stderr, "[check_string_splice] Splice [%zu:%zu:%zu] of a length %zu text does not match the model.\n", start, end, step, length);
+		}
+
+		if (spliced != NULL)
+			string_destroy(spliced);
+	}
+
+	free(expected);
+	string_destroy(string);
+	return passed;
+}
+
+static bool check_buffer(const char *text, size_t length) {
+	struct Buffer buffer;
+	if (buffer_init(&buffer, rng_range(0, 16)) != BUFFER_ERROR_NONE)
+		return false;
+
+	char *expected = malloc(length * 6 * 2 + 1);
+	if (expected == NULL) {
+		buffer_free(&buffer);
+		return false;
+	}
+
+	// Build the same output in pieces with both appends
+	size_t expected_length = 0;
+	size_t split = rng_range(0, length);
+	bool passed = buffer_append(&buffer, text, split) == BUFFER_ERROR_NONE &&
+		buffer_append_escaped(&buffer, text + split, length - split) == BUFFER_ERROR_NONE &&
+		buffer_append_escaped(&buffer, text, split) == BUFFER_ERROR_NONE;
+
+	memcpy(expected, text, split);
+	expected_length += split;
+	expected_length += model_escape(text + split, length - split, expected + expected_length);
+	expected_length += model_escape(text, split, expected + expected_length);
+
+	passed = passed && buffer.length == expected_length && buffer.length <= buffer.capacity &&
+		memcmp(buffer.data, expected, expected_length) == 0;
+	if (!passed)
+		fprintf(stderr, "[check_buffer] Buffer of length %zu does not match the model of length %zu.\n", buffer.length, expected_length);
+
+	free(expected);
+	buffer_free(&buffer);
+	return passed;
+}
+
+int main(int argc, char **argv) {
+	unsigned long long seed = argc > 1 ? strtoull(argv[1], NULL, 0) : 0x5EED;
+	size_t iterations = argc > 2 ? strtoull(argv[2], NULL, 0) : 2000;
+	rng_state = seed ? seed : 1;
+
+	char *text = malloc(RANDOM_LENGTH_MAX + 1);
+	if (text == NULL) {
+		fprintf(stderr, "[main] Failed to allocate the text buffer.\n");
+		return 1;
+	}
+
+	size_t failures = 0;
+	for (size_t i = 0; i < iterations; i++) {
+		size_t length = random_length();
+		random_text(text, length);
+
+		bool passed = check_string_create(text, length) && check_string_set(text, length) &&
+			check_string_splice(text, length) && check_buffer(text, length) && check_utf8(text, length);
+		random_utf8(text, length);
+		passed = check_utf8(text, length) && passed;
+		if (!passed) {
+			fprintf(stderr, "[main] Property check failed at iteration %zu (seed 0x%llx).\n", i, seed);
+			failures++;
+		}
+	}
+
+	free(text);
+	printf("%zu/%zu property iterations passed (seed 0x%llx)\n", iterations - failures, iterations, seed);
+	return failures == 0 ? 0 : 1;
+}
@@ -1,686 +1,149 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include "../wpgstring.h"
 
-enum ParameterSetType { 
-	TYPE_NONE,
-	TYPE_STRING_CREATE,
-	TYPE_STRING_SPLICE
-};
+// Example based cases for the String functions:
+//     ./string_test
 
-enum ParameterSetField { 
-	FIELD_NONE,
-	FIELD_TEXT,
-	FIELD_LENGTH,
-	FIELD_BASE_DATA,
-	FIELD_EXPECTED_OUTPUT_DATA, 
-	FIELD_START,
-	FIELD_END,
-	FIELD_STEP
+struct SetCase {
+	const char *data;
+	size_t length;		// bytes of data to set, which may stop short of its end
+	const char *expected;
+	enum StringError error;
 };
 
-struct StringCreateTestParameters { 
-	char *text;
-	size_t length;
-}; 
-
-struct StringSpliceTestParameters {
-	unsigned short start;
-	unsigned short end;
-	unsigned short step;
-	struct String base;
-	struct String expected_output;
+static const struct SetCase set_cases[] = {
+	{ "dave", 4, "dave", STRING_ERROR_NONE },
+	{ "This is some text that I believe will be longer than the default 32 characters that a string is initially given.", 112,
+	  "This is some text that I believe will be longer than the default 32 characters that a string is initially given.", STRING_ERROR_NONE },
+	{ "prefix only", 6, "prefix", STRING_ERROR_NONE },
+	{ "anything", 0, NULL, STRING_ERROR_BAD_LENGTH }
 };
 
-void* test_parameter_create(enum ParameterSetType type) { 
-	switch (type) {
-		case TYPE_NONE:
-			fprintf(stderr, "[test_parameter_create] TYPE_NONE (%d) is invalid.\n", type);
-			return NULL;
-			break;
-
-		case TYPE_STRING_CREATE:
-			struct StringCreateTestParameters *parameter = malloc(sizeof(struct StringCreateTestParameters));
-			if (parameter == NULL) {
-				fprintf(stderr, "[test_parameter_create] Failed to allocate memory for a StringCreateTestParameters struct on the heap.\n");
-				return NULL;
-			}
-			break;
-
-		case TYPE_STRING_SPLICE:
-			struct StringSpliceTestParameters *parameter = malloc(sizeof(struct StringSpliceTestParameters));
-			if (parameter == NULL) {
-				fprintf(stderr, "[test_parameter_create] Failed to allocate memory for a StringSpliceCreateTestParameters  struct on the heap.\n");
-				return NULL;
-			}
-			break;
-
-		default:  
-			fprintf(stderr, "[test_parameter_create] ParameterSetType code %d is invalid or unimplemented.\n", type);
-			return NULL;
-			break;
-	}
-
-	return ((void*) parameter);
-}
-
-void* test_parameter_array_create(enum ParameterSetType type, size_t length) {
-	if (length == 0) {
-		fprintf(stderr, "[test_parameter_array_create] Length cannot be 0.\n"); 
-		return NULL;
-	}
-
-	switch (type) {
-		case TYPE_NONE:
-			fprintf(stderr, "[test_parameter_create] TYPE_NONE (%d) is invalid.\n", type);
-			return NULL;
-			break;
-
-		case TYPE_STRING_CREATE:
-			struct StringCreateTestParameters *parameters = malloc(sizeof(struct StringCreateTestParameters) * length);
-			if (parameters == NULL) {
-				fprintf(stderr, "[test_parameter_create] Failed to allocate memory for %zu StringCreateTestParameters structs on the heap.\n", length);
-				return NULL;
-			}
-			break;
-
-		case TYPE_STRING_SPLICE:
-			struct StringSpliceTestParameters *parameters = malloc(sizeof(struct StringSpliceTestParameters) * length);
-			if (parameters == NULL) {
-				fprintf(stderr, "[test_parameter_create] Failed to allocate memory for %zu StringSpliceCreateTestParameters  structs on the heap.\n", length);
-				return NULL;
-			}
-			break;
-
-		default:  
-			fprintf(stderr, "[test_parameter_create] ParameterSetType code %d is invalid or unimplemented.\n", type);
-			return NULL;
-			break;
-	}
-
-	return ((void*) parameters);
-}
-
-bool test_parameter_set(void *parameter, enum ParameterSetType type, enum ParameterSetField field, void *data, size_t data_size) { 
-	if (parameter == NULL) {
-		fprintf(stderr, "[test_parameter_set] Cannot set the attributes of a struct addressed by a NULL pointer.\n");
-		return false;
-	} 
-
-	if (data == NULL) {
-		fprintf(stderr, "[test_parameter_set] Cannot set the attributes of a struct with the data addressed by a NULL pointer (data pointer is NULL).\n");
-		return false;
-	}
-
-	if (data_size == 0) {
-		fprintf(stderr, "[test_parameter_set] Data size cannot be 0 bytes.\n");
-		return false;
-	}
-
-	switch (type) {
-		case TYPE_NONE:
-			fprintf(stderr, "[test_parameter_set] TYPE_NONE is invalid when trying to set the fields of a parameter set.\n");
-			return false;
-			break;
-
-		case TYPE_STRING_CREATE: 
-			struct StringCreateTestParameters *casted_parameter = (struct StringCreateTestParameters*) parameter;
-			switch (field) {
-				case FIELD_NONE:
-					fprintf(stderr, "[test_parameter_set] Field FIELD_NONE is invalid when setting the fields of a StringCreateTestParameters struct.\n");
-					return false;
-					break;
-
-				case FIELD_TEXT: 
-					// Allocate memory for the text buffer if it does not already occupy some memory
-					if (casted_parameter->text == NULL) {
-						casted_parameter->text = malloc(sizeof(char) * data_length + 1);
-						if (casted_parameter->text == NULL) {
-							fprintf(stderr, "[test_parameter_set] Failed to allocate %zu bytes of memory to the \"text\" buffer of the provided StringCreateTestParameters struct so that the buffer can be set.\n", data_length + 1);
-							return false;
-						}
-					}
-
-					// Ensure there is enough memory in the buffer if it is already allocated
-					else {
-						if (casted_parameter->length < data_length + 1) {
-							casted_parameter->text = realloc(sizeof(char) * data_length + 1);
-							if (casted_parameter->text == NULL) { 
-								fprintf(stderr, "[test_parameter_set] Failed to reallocate the text buffer of the StringCreateTestParameters struct so that it can accomodate the requisite %zu bytes to hold the provided string.\n", data_length + 1);
-								return NULL;
-							}
-						}
-
-					
-					}
-
-					// Actually copy the data over 
-					strcpy(casted_parameter->text, (char*) data);	
-					break;
-
-				case FIELD_LENGTH:
-					memcpy( &(casted_parameter->length), data, sizeof(unsigned short));
-					break;
-
-				default:
-					fprintf(stderr, "[test_parameter_set] Field code %d is invalid when setting the fields of a StringCreateTestParameters struct.\n", field);
-					return false;
-					break;
-			}
-			break;
-
-		case TYPE_STRING_SPLICE:
-			break;
-
-		default:
-			return false;
-			break;
-	}
-
-	return true;
-}
-
-void string_splice_test_parameters_set_range(struct StringSpliceTestParameters *parameter, unsigned short start, unsigned short end, unsigned short step) {
-	if (parameter == NULL) {
-		fprintf(stderr, "[string_splice_test_parameters_set_range] Cannot set attributes in a memory region pointed to by a NULL pointer.\n");
-		return;
-	} 
-
-	parameter->start = start;
-	parameter->end = end;
-	parameter->step = step;
-	return; 
-}
-
-void test_parameter_destroy(void *test_parameter, enum ParameterSetType parameter_type) {
-	if (test_parameter == NULL) {
-		fprintf(stderr, "[test_parameter_destroy] Cannot free the memory addressed by a NULL pointer.\n");
-		return;
-	} 
-
-	switch (parameter_type) {
-		case TYPE_NONE:
-			fprintf(stderr, "[test_parameter_destroy] Cannot free the memory of a parameter set without knowing which kind of parameter it is (code %d \"TYPE_NONE\" is invalid).\n", parameter_type);
-			return;
-			break; 
-
-		case TYPE_STRING_CREATE:
-			struct StringCreateTestParameters *parameter = (struct StringCreateTestParameters*) test_parameter;
-			if (parameter->text != NULL) free(parameter->text); 
-			free(parameter);
-			return;
-			break;
-
-		case TYPE_STRING_SPLICE:
-			struct StringSpliceTestParameters *parameter = (struct StringSpliceTestParameters*) test_parameter;
-			// Free the input string
-			if (parameter->base != NULL && (parameter->base).data != NULL)
-				free( (parameter->base).data ); 
-
-			// Free the expected output string
-			if (parameter->expected_output != NULL && (parameter->expected_output).data != NULL) 
-				free( (parameter->expected_output).data );
-			
-			
-			// If using an array of parameters, then we don't want to free this one yet.
-			free(parameter);
-			return;
-			break;
-
-		default:  
-			fprintf(stderr, "[test_parameter_destroy] Code %d is invalid or unimplemented.\n", parameter_type);
-			return;
-			break;
-	}
-
-	return;
-}
-
-void test_parameter_array_destroy(void *test_parameters, enum ParameterSetType parameter_type, size_t length) {
-	if (test_parameters == NULL) {
-		fprintf(stderr, "[test_parameter_array_destroy] Cannot free the memory addressed by a NULL pointer.\n");
-		return;
-	} 
-
-	switch (parameter_type) {
-		case TYPE_NONE:
-			fprintf(stderr, "[test_parameter_array_destroy] Cannot free the memory of a parameter set without knowing which kind of parameter it is (code %d \"TYPE_NONE\" is invalid).\n", parameter_type);
-			return;
-			break; 
-
-		case TYPE_STRING_CREATE:
-			struct StringCreateTestParameters *parameters = (struct StringCreateTestParameters*) test_parameters;
-			struct StringCreateTestParameters *current_parameter;
-			// Free buffers within individual parameter structs 
-			for (size_t i = 0; i < length; i++) {
-				current_parameter = parameters[i];
-				if (current_parameter->text != NULL) 
-					free(parameter->text); 
-			}
-			// Free the entire array
-			free(parameters);
-			return;
-			break;
-
-		case TYPE_STRING_SPLICE:
-			struct StringSpliceTestParameters *parameters = (struct StringSpliceTestParameters*) test_parameters;
-			struct StringSpliceTestParameters *current_parameter;
-			char *current_base;
-			char *current_expected_output;
-			// Free the buffers within individual parameter structs
-			for(size_t i = 0; i < length; i++) { 
-				// Set current items of interest
-				current_parameter = parameters[i]; 
-				current_base = current_parameter->base;
-				current_expected_output = current_parameter->expected_output;
-
-				// Free the input string
-				if (current_base != NULL && current_base.data != NULL)
-					free(current_base.data); 
-
-				// Free the expected output string
-				if (current_expected_output != NULL && current_expected_output.data != NULL) 
-					free(current_expected_output.data);
-			}
-			
-			// Free the array itself
-			free(parameters);
-			return;
-			break;
-
-		default:  
-			fprintf(stderr, "[test_parameter_array_destroy] Code %d is invalid or unimplemented.\n", parameter_type);
-			return;
-			break;
-	}
-
-	return;
-}
-
-enum TestEnvironmentType {
-	ENVIRONMENT_NONE,
-	ENVIRONMENT_STRING_CREATE,
-	ENVIRONMENT_STRING_SPLICE
+struct SpliceCase {
+	const char *base;
+	size_t start;
+	size_t end;
+	size_t step;
+	const char *expected;	// NULL when the splice is rejected
 };
 
-struct TestEnvironment {
-	enum TestEnvironmentType type;
-	void *parameters;
-	size_t parameters_length;
-	bool *results;
-	size_t results_length;
+static const struct SpliceCase splice_cases[] = {
+	{ "My name is Dave and I am a programmer.", 0, 5, 1, "My na" },
+	{ "My name is Pink and I'm really glad to meet you.", 1, 7, 2, "ynm" },
+	{ "C is a procedural systems programming language.", 0, 1000, 10, "Ccsrn" },
+	{ "abcdef", 2, 3, 1, "c" },
+	{ "abcdef", 0, 6, 5, "af" },
+	{ "abcdef", 3, 3, 1, NULL },
+	{ "abcdef", 4, 2, 1, NULL },
+	{ "abcdef", 0, 6, 0, NULL },
+	{ "abcdef", 7, 100, 1, NULL }
 };
 
-
-// Utility functions
-void run_and_evaluate_tests(char *function_title, 
-		            bool (*test_function)(void*),
-			    void *parameter_sets,
-			    enum ParameterSetType parameter_set_type, 
-			    bool *results,
-			    size_t results_length);
-bool are_tests_passed(bool *results, size_t length);
-
-// Test functions
-bool test_string_init();		        	// Simple init test
-bool test_string_create(void *parameters);		// String with default value passed in
-bool test_string_set(void *parameters);			// Recently init'd string (no value) having a value set  
-bool test_string_splice(void *parameters);
-
-struct TestEnvironment* test_environment_create(enum TestEnvironmentType type) {
-	// Create TestEnvironment
-	struct TestEnvironment *environment = malloc(sizeof(struct TestEnvironment));
-	if (environment == NULL) { 
-		fprintf(stderr, "[test_environment_create] Failed to allocate space for TestEnvironment struct on the heap.\n");
-		return NULL;
-	}
-	environment->type = type;
-	
-	// Behavior based on type of environment
-	switch (type) { 
-		case ENVIRONMENT_NONE:
-			fprintf(stderr, "[test_environment_create] ERROR: TestEnvironmentType code %d (ENVIRONMENT_NONE) is invalid.\n", type);
-			free(environment);
-			return NULL;
-			break;
-
-		case ENVIRONMENT_STRING_CREATE:
-			break;
-
-		case ENVIRONMENT_STRING_SPLICE:
-			environment->parameters_length = 3;
-			// Allocate space for the StringSpliceTestParameters
-			environment->parameters = (void*) malloc(sizeof(struct StringSpliceTestParameters) * 3);
-			if (environment->parameters == NULL) {
-				fprintf(stderr, "[test_environment_create] Failed to allocate memory for 3 StringSpliceTestParameters on the heap.\n");
-				free(environment);
-				return NULL;
-			}
-			environment->results = malloc(sizeof(bool) * 3);
-			if (environment->results == NULL) { 
-				fprintf(stderr, "[test_environment_create] Failed to allocate memory for a size-3 boolean array on the heap.\n");
-				free(environment->parameters);
-				free(environment);
-				return NULL;
-			}
-
-			// SET THE VALUES FOR THE INDIVIDUAL PARAMETERS.
-			struct StringSpliceTestParameters *parameters = (struct StringSpliceTestParameters*) environment->parameters;
-			// (1.1) Set the ranges for the first parameter set
-			string_splice_test_parameters_set_range(parameters[0], 0, 5, 1);
-			
-			// (1.2) Set the input string for the first parameter set.
-			parameters[0]->base = string_create("My name is Dave and I am a programmer.");
-			if (parameters[0]->base == NULL) {
-				fprintf(stderr, "[test_environment_create] Call to string_create for the first parameter failed.\n");
-				test_parameter_array_destroy(parameters, TYPE_STRING_SPLICE, 3); 
-				free(environment->results);
-				free(environment);
-				return NULL;
-			} 
-
-			// (1.3) Set the expected output string for the first parameter set
-			parameters[0]->expected_output = string_create("My na");
-			if (parameters[0]->expected_output == NULL) {
-				fprintf(stderr, "[test_environment_create] Call to string_create for the first parameter's \"expected_output\" attribute failed.\n");
-				test_parameter_array_destroy(parameters, TYPE_STRING_SPLICE, 3);
-				free(environment->results);
-				free(environment);
-				return NULL;
-			}
-
-			// (2) Set the values for the second parameter set
-			string_splice_test_parameters_set_range(parameters[1], 1, 7, 2);
-			parameters[1]->base = string_create("My name is Pink and I'm really glad to meet you.");
-			if (parameters[1]->base == NULL) {
-				fprintf(stderr, "[test_environment_create] Call to string_create for the second parameter failed.\n");
-				test_parameter_array_destroy(parameters, TYPE_STRING_SPLICE, 3);
-				free(environment->results);
-				free(environment);
-				return NULL;
-			} 
-			parameters[1]->expected_output = string_create("ynm");
-			if (parameters[1]->base == NULL) {
-				fprintf(stderr, "[test_environment_create] Call to string_create for the second parameter failed.\n");
-				test_parameter_array_destroy(parameters, TYPE_STRING_SPLICE, 3);
-				free(environment->results);
-				free(environment);
-				return NULL;
-			} 
-
-			// (3) Set the attributes for the third parameter set
-			parameters[2]->base = string_create("C is a procedural systems programming language created by Dennis Ritchie. It is my favorite programming language.");
-			if (parameters[2]->base == NULL) {
-				fprintf(stderr, "[test_environment_create] Call to string_create for the third parameter failed.\n");
-				test_parameter_array_destroy(parameters, TYPE_STRING_SPLICE, 3);
-				free(environment->results);
-				free(environment);
-				return NULL;
-			}
-			
-			return environment;
-			break;
-
-		default:
-			fprintf(stderr, "[test_environment_create] ERROR: TestEnvironmentType code %d is invalid/unimplemented.\n", type);
-			free(environment);
-			return NULL;
-			break; 
-	} 
-}
-
-void test_environment_destroy(struct TestEnvironment *environment) {
-	if (environment == NULL) {
-		fprintf(stderr, "[test_environment_destroy] Cannot free memory addressed by a NULL pointer.\n");
-		return;
-	} 
-
-	if (environment->results != NULL) 	free (environment->results); 
-	switch (environment->type) {
-		case ENVIRONMENT_NONE:
-			fprintf(stderr, "[test_environment_destroy] Cannot be certain of how to delete the dynamically allocated properties of a test environment which has an unknown type (ENVIRONMENT_NONE). There may be a memory leak due to this.\n");
-			free(environment);
-			break;
-
-		case ENVIRONMENT_STRING_CREATE:
-
-			free (environment);
-			break;
-
-		case ENVIRONMENT_STRING_SPLICE:
-			test_parameter_array_destroy(environment->parameters, TYPE_STRING_SPLICE, 3);
-			free(environment);
-			break;
-		
-		default:
-			fprintf(stderr, "[test_environment_destroy] TestEnvironmentType %d is an invalid/unimplemented case. The environment will be freed, but there is no guarantee that its dynamically allocated attributes will be freed correctly. A memory leak may be caused by this.\n");
-			free(environment);
-			break;
-	}
-	return;
-}
-
-int main(int argc, char **argv) {
-	// Test simple string init
-	bool string_init_test_results[1];
-	run_and_evaluate_tests("string_init", &test_string_init, NULL, TYPE_NONE, string_init_test_results, 1);
-	
-	// Test string creation with default value
-	bool string_create_test_results[2];
-	char *longer_string = "This is some text that I believe will be longer than the default 32 characters that a string is initially given.";
-	size_t longer_string_length = strlen(longer_string);
-	struct StringCreateTestParameters string_create_test_parameters[2];
-	string_create_test_parameters[0].text = "dave";
-	string_create_test_parameters[0].length = 4;
-
-	string_create_test_parameters[1].text = longer_string;
-	string_create_test_parameters[1].length = longer_string_length;
-	struct StringCreateTestParameters *current_parameters;
-	run_and_evaluate_tests(
-		"string_create",
-		&test_string_create,
-		(void*) string_create_test_parameters,
-		TYPE_STRING_CREATE,
-		string_create_test_results,
-		2
-	);
-	
-	// Test string_set with a recently initialized string
-	bool string_set_test_results[2];
-	run_and_evaluate_tests("string_set", &test_string_set, (void*) string_create_test_parameters, TYPE_STRING_CREATE, string_set_test_results, 2);
-
-	// Test string splice
-	run_and_evaluate_tests("string_splice", &test_string_splice, (void*) string_splice_test_parameters, TYPE_STRING_SPLICE, string_splice_test_results, 3);
-
-	return 0;
-} // end main
-
-void run_and_evaluate_tests(char *function_title, 
-		            bool (*test_function)(void*),
-			    void *parameter_sets,
-			    enum ParameterSetType parameter_set_type, 
-			    bool *results,
-			    size_t results_length) { 
-	printf("Running tests for the %s() function...\n", function_title);
-
-	// Run function with provided parameter sets and store results 
-	void *current_parameters;
-	for (size_t i = 0; i < results_length; i++) {
-		switch (parameter_set_type) {
-			case TYPE_NONE:
-				current_parameters = NULL;
-				break;
-			
-			case TYPE_STRING_CREATE:
-				current_parameters = &((struct StringCreateTestParameters*) parameter_sets)[i];
-				break;
-
-			case TYPE_STRING_SPLICE:
-				current_parameters = &((struct StringSpliceTestParameters*) parameter_sets)[i];
-				break;
-
-			default:
-				current_parameters = NULL;
-				break;
-		} 
-
-		printf("Running test %zu/%zu...\n", i + 1, results_length);
-		results[i] = test_function(current_parameters);
-	} 
-
-	// Evaluate performance
-	if (are_tests_passed(results, results_length) == false)
-		fprintf(stderr, "Failed on some tests of the %s() function.\n", function_title);
-
-	printf("\n");
-}
-
-bool are_tests_passed(bool *results, size_t length) {
-	size_t tests_passed = 0;	
-	if (results == NULL) {
-		fprintf(stderr, "[are_tests_passed] Cannot check validity of test results using a NULL pointer in place of a boolean pointer.\n");
-	}
-
-	for (size_t i = 0; i < length; i++) {
-		if (results[i] == false) { 
-			fprintf(stderr, "FAILED: test #%zu.\n", i + 1);
-			continue;
-		} 
-
-		printf("PASSED: Test #%zu.\n", i + 1);
-		tests_passed++;
-	}
-
-	printf("Passed %zu/%zu tests.\n", tests_passed, length);
-	if (tests_passed == length) return true;
-	else                        return false;
-}
-
-bool test_string_init() {
+static bool check_init() {
 	struct String *string = string_init();
-	if (string == NULL) { 
-		fprintf(stderr, "[test_string_simple_creation] Call to string_init() returned NULL pointer.\n");
-		return false;
-	} 
-
-	if (string->length != 0) {
-		fprintf(stderr, "[test_string_simple_creation] Newly created string did not have 0 length.\n");
-		return false;
-	}
-
-	if (string->capacity != 32) {
-		fprintf(stderr, "[test_string_simple_creation] Newly created string did not have a capacity of 32.\n");
+	if (string == NULL || string->length != 0 || string->capacity != 32) {
+		fprintf(stderr, "[check_init] A new String should be empty with a capacity of 32.\n");
+		if (string != NULL)
+			string_destroy(string);
 		return false;
 	}
 
-	free(string->data);
-	free(string);
+	string_destroy(string);
 	return true;
 }
 
-bool test_string_create(void *parameters) {
-	char   *text  = ((struct StringCreateTestParameters*) parameters)->text;
-	size_t length = ((struct StringCreateTestParameters*) parameters)->length;
-
-	if (text == NULL) {
-		fprintf(stderr, "[test_string_create] Provided test string was NULL.\n");
-		return false;
-	}
-	
-	struct String *string = string_create(text, (unsigned short) length);
-	if (string == NULL) {
-		fprintf(stderr, "[test_string_create] Returned string was NULL.\n");
-		return false;
+static bool check_create() {
+	bool passed = true;
+	for (size_t i = 0; i < sizeof(set_cases) / sizeof(set_cases[0]); i++) {
+		const char *text = set_cases[i].data;
+		struct String *string = string_create((char*) text);
+		if (string == NULL || string->length != strlen(text) || string->capacity <= string->length || strcmp(string->data, text) != 0) {
+			fprintf(stderr, "[check_create] string_create(\"%s\") did not copy its text.\n", text);
+			passed = false;
+		}
+		if (string != NULL)
+			string_destroy(string);
 	}
 
-	if (string->data == NULL) {
-		fprintf(stderr, "[test_string_create] Returned string had a NULL pointer for its data buffer.\n");
-		free(string);
-		return false;
-	} 
-
-	if (string->length != length) {
-		fprintf(stderr, "[test_string_create] Returned string has a different length attribute (%hu) than the value provided (%zu).\n", string->length, length);
-		free(string->data);
-		free(string);
-		return false; 
-	}
-
-	if (strcmp(string->data, text) != 0) {
-		fprintf(stderr, "[test_string_create] Returned string does not have the expected textual contents (\"%s\" != \"%s\").\n", string->data, text);
-		free(string->data);
-		free(string);
-		return false;
+	if (string_create("") != NULL) {
+		fprintf(stderr, "[check_create] string_create(\"\") should be rejected.\n");
+		passed = false;
 	}
-
-	return true;
+	return passed;
 }
 
-bool test_string_set(void *parameters) { 
-	char *text = ((struct StringCreateTestParameters*) parameters)->text;
-	size_t length = ((struct StringCreateTestParameters*) parameters)->length;
-
-	if (text == NULL) { 
-		fprintf(stderr, "[test_string_set] Cannot perform a test using a test value char pointer that points to NULL.\n");
-		return false;
-	}
-
+static bool check_set(const struct SetCase *test) {
 	struct String *string = string_init();
-	if (string == NULL) { 
-		fprintf(stderr, "[test_string_set] Failed to allocate space for a default init string on the heap.\n");
+	if (string == NULL)
 		return false;
+
+	bool passed = true;
+	enum StringError error = string_set(string, (char*) test->data, test->length);
+	if (error != test->error) {
+		fprintf(stderr, "[check_set] Setting %zu bytes of \"%s\" returned %d, expected %d.\n", test->length, test->data, error, test->error);
+		passed = false;
+	} else if (test->expected != NULL && (string->length != strlen(test->expected) || strcmp(string->data, test->expected) != 0)) {
+		fprintf(stderr, "[check_set] Setting %zu bytes of \"%s\" gave \"%s\".\n", test->length, test->data, string->data);
+		passed = false;
 	}
 
-	if (string_set(string, text, length) != STRING_ERROR_NONE) { 
-		fprintf(stderr, "[test_string_set] Call to string_set failed while using string \"%s\" of length %zu.\n", text, length);
-		if (string->data != NULL) free(string->data);
-		if (string != NULL)       free(string);
-		return false;
+	// Clearing leaves an empty String that can be set again
+	if (passed && (string_clear(string) != STRING_ERROR_NONE || string->length != 0 || string->data[0] != '\0' ||
+	               string_set(string, "again", 5) != STRING_ERROR_NONE || strcmp(string->data, "again") != 0)) {
+		fprintf(stderr, "[check_set] The String set from \"%s\" could not be cleared and set again.\n", test->data);
+		passed = false;
 	}
 
-	return true;
+	string_destroy(string);
+	return passed;
 }
 
-bool test_string_splice(void *parameters) {
-	if (parameters == NULL) { 
-		fprintf(stderr, "[test_string_splice] Cannot use NULL pointer for parameters argument.\n");
+static bool check_splice(const struct SpliceCase *test) {
+	struct String *base = string_create((char*) test->base);
+	if (base == NULL)
 		return false;
+
+	struct String *spliced = string_splice(base, test->start, test->end, test->step);
+	bool passed = true;
+	if (test->expected == NULL) {
+		if (spliced != NULL) {
+			fprintf(stderr, "[check_splice] [%zu:%zu:%zu] of \"%s\" gave \"%s\", but should be rejected.\n", test->start, test->end, test->step, test->base, spliced->data);
+			passed = false;
+		}
+	} else if (spliced == NULL || spliced->length != strlen(test->expected) || strcmp(spliced->data, test->expected) != 0) {
+		fprintf(stderr, "[check_splice] [%zu:%zu:%zu] of \"%s\" gave \"%s\", expected \"%s\".\n", test->start, test->end, test->step, test->base,
+			spliced != NULL ? spliced->data : "(NULL)", test->expected);
+		passed = false;
 	}
 
-	struct String *string = ((struct StringSpliceTestParameters*) parameters)->base;
-	unsigned short start = ((struct StringSpliceTestParameters*) parameters)->start;
-	unsigned short end = ((struct StringSpliceTestParameters*) parameters)->end;
-	unsigned short step = ((struct StringSpliceTestParameters*) parameters)->step;
-	struct String *expected_output = ((struct StringSpliceTestParameters*) parameters)->expected_output;
+	if (spliced != NULL)
+		string_destroy(spliced);
+	string_destroy(base);
+	return passed;
+}
 
-	struct String *spliced_string = string_splice(string, start, end, step);
-	if (spliced_string == NULL) {
-		fprintf(stderr, "[test_string_splice] Output string is a NULL pointer.\n");
-		return false;
-	}
-	
-	if (spliced_string->data == NULL) { 
-		fprintf(stderr, "[test_string_splice] Output string has a NULL pointer for its data attribute.\n");
-		free(spliced_string);
-		return false;
-	}
+int main() {
+	size_t set_length = sizeof(set_cases) / sizeof(set_cases[0]);
+	size_t splice_length = sizeof(splice_cases) / sizeof(splice_cases[0]);
+	size_t total = 2 + set_length + splice_length;
+	size_t failures = 0;
 
-	if (spliced_string->length != expected_output->length) {
-		fprintf(stderr, "[test_string_splice] Output string does not have the same length (got %hu, but expected  %hu) attribute as the expected output string.\n", spliced_string->length, expected_output->length);
-		free(spliced_string->data);
-		free(spliced_string);
-		return false;
+	if (!check_init())
+		failures++;
+	if (!check_create())
+		failures++;
+	for (size_t i = 0; i < set_length; i++) {
+		if (!check_set(&set_cases[i]))
+			failures++;
 	}
-
-	if (strcmp(spliced_string->data, expected_output->data) != 0) {
-		fprintf(stderr, "[test_string_splice] Output string does not have the same textual contents (got \"%s\", but expected  \"%s\") attribute as the expected output string.\n", spliced_string->data, expected_output->data);
-		free(spliced_string->data);
-		free(spliced_string);
-		return false;
+	for (size_t i = 0; i < splice_length; i++) {
+		if (!check_splice(&splice_cases[i]))
+			failures++;
 	}
 
-	free(spliced_string->data);
-	free(spliced_string);
-	return true;
+	printf("%zu/%zu string cases passed\n", total - failures, total);
+	return failures == 0 ? 0 : 1;
 }
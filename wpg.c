@@ -1,18 +1,53 @@
-#include <stdio.h> 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include "wpgmanifest.h"
+#include "wpgparallel.h"
+#include "wpgsite.h"
 #define REQUIRED_ARGUMENTS_COUNT 1
-enum CommandLineArgument { 
+enum CommandLineArgument {
 	ARG_NONE,
-	ARG_TITLE
+	ARG_MANIFEST
 };
 
-int main(int argc, char **argv) {   
-	if (argc < ) { 
+int main(int argc, char **argv) {
+	if (argc < REQUIRED_ARGUMENTS_COUNT + 1) {
 		fprintf(stderr, "Insufficient arguments provided.\n");
+		fprintf(stderr, "Usage: %s <manifest>\n", argv[ARG_NONE]);
 		return 1;
 	}
 
-		
+	struct Manifest *manifest = manifest_load(argv[ARG_MANIFEST]);
+	if (manifest == NULL)
+		return 1;
+
+	struct Site *site = manifest_site_create(manifest);
+	if (site == NULL) {
+		manifest_destroy(manifest);
+		return 1;
+	}
+
+	// Pinned before any pages load, so the worker that reads a page in is on
+	// the node of the worker that later renders it
+	parallel_pin_workers(manifest->pin_threads);
+
+	// A memory budget asks for the bounded build; otherwise every page is
+	// loaded up front so links can be validated and searched
+	enum SiteError error;
+	if (manifest->memory_budget > 0) {
+		struct PageSource source = manifest_page_source(manifest);
+		error = site_build_streaming(site, &source);
+	} else if (manifest_load_pages(manifest, site) != MANIFEST_ERROR_NONE)
+		error = SITE_ERROR_FAILED_SOURCE;
+	else
+		error = site_build(site);
+
+	if (error == SITE_ERROR_NONE)
+		printf("Built %zu pages into \"%s\".\n", manifest->pages_length, site->output_directory);
+	else
+		fprintf(stderr, "Failed to build the site described by \"%s\".\n", argv[ARG_MANIFEST]);
 
-	return 0;
+	site_destroy(site);
+	manifest_destroy(manifest);
+	return error == SITE_ERROR_NONE ? 0 : 1;
+}
@@ -0,0 +1,561 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include "wpgbuffer.h"
+#include "wpglayout.h"
+#include "wpglib.h"
+#include "wpglinks.h"
+#include "wpgparallel.h"
+#include "wpgrender.h"
+#include "wpgasset.h"
+
+#define ASSET_PRIME_1 11400714785074694791ULL
+#define ASSET_PRIME_2 14029467366897019727ULL
+#define ASSET_PRIME_3 1609587929392839161ULL
+#define ASSET_PRIME_4 9650029242287828579ULL
+#define ASSET_PRIME_5 2870177450012600261ULL
+
+struct AssetJob {
+	struct AssetSet *set;
+	char *output_directory;
+	atomic_int error;
+};
+
+static inline unsigned long long asset_rotate(unsigned long long value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline unsigned long long asset_read64(const unsigned char *bytes) {
+	unsigned long long value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static inline unsigned int asset_read32(const unsigned char *bytes) {
+	unsigned int value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static inline unsigned long long asset_round(unsigned long long accumulator, unsigned long long input) {
+	accumulator += input * ASSET_PRIME_2;
+	accumulator = asset_rotate(accumulator, 31);
+	return accumulator * ASSET_PRIME_1;
+}
+
+static inline unsigned long long asset_merge_round(unsigned long long hash, unsigned long long accumulator) {
+	hash ^= asset_round(0, accumulator);
+	return hash * ASSET_PRIME_1 + ASSET_PRIME_4;
+}
+
+unsigned long long asset_hash(const void *data, size_t length, unsigned long long seed) {
+	const unsigned char *bytes = data;
+	const unsigned char *end = bytes + length;
+	unsigned long long hash;
+
+	if (length >= 32) {
+		unsigned long long lanes[4] = { seed + ASSET_PRIME_1 + ASSET_PRIME_2, seed + ASSET_PRIME_2, seed, seed - ASSET_PRIME_1 };
+		const unsigned char *stripes_end = end - 32;
+		do {
+			for (int lane = 0; lane < 4; lane++)
+				lanes[lane] = asset_round(lanes[lane], asset_read64(bytes + lane * 8));
+			bytes += 32;
+		} while (bytes <= stripes_end);
+
+		hash = asset_rotate(lanes[0], 1) + asset_rotate(lanes[1], 7) + asset_rotate(lanes[2], 12) + asset_rotate(lanes[3], 18);
+		for (int lane = 0; lane < 4; lane++)
+			hash = asset_merge_round(hash, lanes[lane]);
+	} else {
+		hash = seed + ASSET_PRIME_5;
+	}
+
+	hash += (unsigned long long) length;
+
+	for (; bytes + 8 <= end; bytes += 8) {
+		hash ^= asset_round(0, asset_read64(bytes));
+		hash = asset_rotate(hash, 27) * ASSET_PRIME_1 + ASSET_PRIME_4;
+	}
+	if (bytes + 4 <= end) {
+		hash ^= (unsigned long long) asset_read32(bytes) * ASSET_PRIME_1;
+		hash = asset_rotate(hash, 23) * ASSET_PRIME_2 + ASSET_PRIME_3;
+		bytes += 4;
+	}
+	for (; bytes < end; bytes++) {
+		hash ^= (*bytes) * ASSET_PRIME_5;
+		hash = asset_rotate(hash, 11) * ASSET_PRIME_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= ASSET_PRIME_2;
+	hash ^= hash >> 29;
+	hash *= ASSET_PRIME_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+struct AssetSet* asset_set_create(char *source_directory) {
+	if (source_directory == NULL) {
+		fprintf(stderr, "[asset_set_create] Cannot create an AssetSet using a source directory that points to NULL.\n");
+		return NULL;
+	}
+
+	struct AssetSet *new_set = calloc(1, sizeof(struct AssetSet));
+	if (new_set == NULL) {
+		fprintf(stderr, "[asset_set_create] Failed to allocate memory for a new AssetSet on the heap.\n");
+		return NULL;
+	}
+
+	new_set->source_directory = strdup(source_directory);
+	new_set->assets_capacity = 16;
+	new_set->assets = malloc(sizeof(struct Asset) * new_set->assets_capacity);
+	if (new_set->source_directory == NULL || new_set->assets == NULL) {
+		fprintf(stderr, "[asset_set_create] Failed to allocate the asset list of the new AssetSet.\n");
+		asset_set_destroy(new_set);
+		return NULL;
+	}
+
+	return new_set;
+}
+
+enum AssetError asset_set_add(struct AssetSet *set, char *path) {
+	if (set == NULL || path == NULL) {
+		fprintf(stderr, "[asset_set_add] Cannot add an asset using a set or path pointer that points to NULL.\n");
+		return ASSET_ERROR_NULL_POINTER;
+	}
+
+	if (set->assets_length >= set->assets_capacity) {
+		size_t new_capacity = set->assets_capacity * 2;
+		struct Asset *new_assets = realloc(set->assets, sizeof(struct Asset) * new_capacity);
+		if (new_assets == NULL) {
+			fprintf(stderr, "[asset_set_add] Failed to reallocate the asset list to hold %zu assets.\n", new_capacity);
+			return ASSET_ERROR_FAILED_REALLOC;
+		}
+		set->assets = new_assets;
+		set->assets_capacity = new_capacity;
+	}
+
+	while (*path == '/')
+		path++;
+
+	struct Asset *asset = &(set->assets[set->assets_length]);
+	asset->path = strdup(path);
+	asset->fingerprinted = NULL;
+	asset->hash = 0;
+	if (asset->path == NULL) {
+		fprintf(stderr, "[asset_set_add] Failed to copy the asset path \"%s\".\n", path);
+		return ASSET_ERROR_FAILED_REALLOC;
+	}
+
+	set->assets_length++;
+	return ASSET_ERROR_NONE;
+}
+
+static enum AssetError asset_fingerprint(struct AssetSet *set, struct Asset *asset) {
+	char source_path[PATH_MAX];
+	snprintf(source_path, sizeof(source_path), "%s/%s", set->source_directory, asset->path);
+
+	int descriptor = open(source_path, O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0) {
+		fprintf(stderr, "[asset_fingerprint] Failed to open the asset \"%s\".\n", source_path);
+		return ASSET_ERROR_FAILED_OPEN;
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		fprintf(stderr, "[asset_fingerprint] Failed to stat the asset \"%s\".\n", source_path);
+		close(descriptor);
+		return ASSET_ERROR_FAILED_READ;
+	}
+
+	// Hash straight out of the page cache
+	if (status.st_size == 0) {
+		asset->hash = asset_hash("", 0, 0);
+	} else {
+		void *contents = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (contents == MAP_FAILED) {
+			fprintf(stderr, "[asset_fingerprint] Failed to map the asset \"%s\".\n", source_path);
+			close(descriptor);
+			return ASSET_ERROR_FAILED_READ;
+		}
+		madvise(contents, status.st_size, MADV_SEQUENTIAL);
+		asset->hash = asset_hash(contents, status.st_size, 0);
+		munmap(contents, status.st_size);
+	}
+	close(descriptor);
+
+	// Insert the hash before the extension: "css/site.css" -> "css/site.<hash>.css"
+	const char *name = strrchr(asset->path, '/');
+	name = name == NULL ? asset->path : name + 1;
+	const char *extension = strrchr(name, '.');
+	if (extension == NULL || extension == name)
+		extension = name + strlen(name);
+
+	size_t stem_length = extension - asset->path;
+	size_t fingerprinted_size = strlen(asset->path) + 18;
+	asset->fingerprinted = malloc(fingerprinted_size);
+	if (asset->fingerprinted == NULL) {
+		fprintf(stderr, "[asset_fingerprint] Failed to allocate the fingerprinted path of \"%s\".\n", asset->path);
+		return ASSET_ERROR_FAILED_REALLOC;
+	}
+	snprintf(asset->fingerprinted, fingerprinted_size, "%.*s.%016llx%s", (int) stem_length, asset->path, asset->hash, extension);
+
+	return ASSET_ERROR_NONE;
+}
+
+static void asset_fingerprint_range(size_t start, size_t end, unsigned int worker, void *context) {
+	(void) worker;
+	struct AssetJob *job = context;
+
+	for (size_t i = start; i < end; i++) {
+		enum AssetError error = asset_fingerprint(job->set, &(job->set->assets[i]));
+		if (error != ASSET_ERROR_NONE) {
+			int expected = ASSET_ERROR_NONE;
+			atomic_compare_exchange_strong(&(job->error), &expected, error);
+		}
+	}
+}
+
+// qsort has no context argument, so the set being sorted is handed over here.
+static _Thread_local struct AssetSet *asset_sort_set;
+
+static int asset_path_compare(const void *a, const void *b) {
+	return strcmp(asset_sort_set->assets[*(const size_t*) a].path, asset_sort_set->assets[*(const size_t*) b].path);
+}
+
+static int asset_fingerprinted_compare(const void *a, const void *b) {
+	return strcmp(asset_sort_set->assets[*(const size_t*) a].fingerprinted, asset_sort_set->assets[*(const size_t*) b].fingerprinted);
+}
+
+enum AssetError asset_set_fingerprint(struct AssetSet *set, unsigned int threads) {
+	if (set == NULL) {
+		fprintf(stderr, "[asset_set_fingerprint] Cannot fingerprint an AssetSet pointer that points to NULL.\n");
+		return ASSET_ERROR_NULL_POINTER;
+	}
+
+	struct AssetJob job = { .set = set };
+	atomic_init(&(job.error), ASSET_ERROR_NONE);
+	if (!parallel_for(set->assets_length, threads, asset_fingerprint_range, &job))
+		return ASSET_ERROR_FAILED_REALLOC;
+	if (atomic_load(&(job.error)) != ASSET_ERROR_NONE)
+		return atomic_load(&(job.error));
+
+	// Build the two sorted lookup orders
+	free(set->by_path);
+	free(set->by_fingerprinted);
+	set->by_path = malloc(sizeof(size_t) * (set->assets_length ? set->assets_length : 1));
+	set->by_fingerprinted = malloc(sizeof(size_t) * (set->assets_length ? set->assets_length : 1));
+	if (set->by_path == NULL || set->by_fingerprinted == NULL) {
+		fprintf(stderr, "[asset_set_fingerprint] Failed to allocate the lookup tables for %zu assets.\n", set->assets_length);
+		return ASSET_ERROR_FAILED_REALLOC;
+	}
+
+	for (size_t i = 0; i < set->assets_length; i++) {
+		set->by_path[i] = i;
+		set->by_fingerprinted[i] = i;
+	}
+
+	asset_sort_set = set;
+	qsort(set->by_path, set->assets_length, sizeof(size_t), asset_path_compare);
+	qsort(set->by_fingerprinted, set->assets_length, sizeof(size_t), asset_fingerprinted_compare);
+	asset_sort_set = NULL;
+
+	return ASSET_ERROR_NONE;
+}
+
+// Copies source into destination, preferring a reflink, then an in-kernel copy.
+static bool asset_copy_contents(int source, int destination, off_t size) {
+#ifdef FICLONE
+	if (ioctl(destination, FICLONE, source) == 0)
+		return true;
+#endif
+
+	off_t copied = 0;
+	while (copied < size) {
+		ssize_t result = copy_file_range(source, NULL, destination, NULL, size - copied, 0);
+		if (result > 0) {
+			copied += result;
+			continue;
+		}
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result == 0 || errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)
+			break;
+		return false;
+	}
+
+	// Fall back to a plain read/write loop from wherever the kernel copy stopped
+	char chunk[64 * 1024];
+	while (copied < size) {
+		ssize_t read_length = pread(source, chunk, sizeof(chunk), copied);
+		if (read_length < 0 && errno == EINTR)
+			continue;
+		if (read_length <= 0)
+			return false;
+
+		for (ssize_t written = 0; written < read_length; ) {
+			ssize_t result = pwrite(destination, chunk + written, read_length - written, copied + written);
+			if (result < 0 && errno == EINTR)
+				continue;
+			if (result < 0)
+				return false;
+			written += result;
+		}
+		copied += read_length;
+	}
+
+	return true;
+}
+
+static enum AssetError asset_copy(struct AssetSet *set, struct Asset *asset, char *output_directory) {
+	char source_path[PATH_MAX];
+	char destination_path[PATH_MAX];
+	snprintf(source_path, sizeof(source_path), "%s/%s", set->source_directory, asset->path);
+	snprintf(destination_path, sizeof(destination_path), "%s/%s", output_directory, asset->fingerprinted);
+
+	int source = open(source_path, O_RDONLY | O_CLOEXEC);
+	if (source < 0) {
+		fprintf(stderr, "[asset_copy] Failed to open the asset \"%s\".\n", source_path);
+		return ASSET_ERROR_FAILED_OPEN;
+	}
+
+	struct stat source_status;
+	struct stat destination_status;
+	if (fstat(source, &source_status) != 0) {
+		fprintf(stderr, "[asset_copy] Failed to stat the asset \"%s\".\n", source_path);
+		close(source);
+		return ASSET_ERROR_FAILED_READ;
+	}
+
+	// The name is derived from the content, so an existing file is already correct
+	if (stat(destination_path, &destination_status) == 0 && destination_status.st_size == source_status.st_size) {
+		close(source);
+		return ASSET_ERROR_NONE;
+	}
+
+	int destination = render_open_file(output_directory, asset->fingerprinted);
+	if (destination < 0) {
+		close(source);
+		return ASSET_ERROR_FAILED_OPEN;
+	}
+
+	enum AssetError error = ASSET_ERROR_NONE;
+	if (!asset_copy_contents(source, destination, source_status.st_size)) {
+		fprintf(stderr, "[asset_copy] Failed to copy \"%s\" to \"%s\".\n", source_path, destination_path);
+		error = ASSET_ERROR_FAILED_WRITE;
+	}
+
+	if (close(destination) != 0)
+		error = ASSET_ERROR_FAILED_WRITE;
+	close(source);
+
+	// Never leave a partial file behind under a content addressed name
+	if (error != ASSET_ERROR_NONE)
+		unlink(destination_path);
+	return error;
+}
+
+static void asset_copy_range(size_t start, size_t end, unsigned int worker, void *context) {
+	(void) worker;
+	struct AssetJob *job = context;
+
+	for (size_t i = start; i < end; i++) {
+		enum AssetError error = asset_copy(job->set, &(job->set->assets[i]), job->output_directory);
+		if (error != ASSET_ERROR_NONE) {
+			int expected = ASSET_ERROR_NONE;
+			atomic_compare_exchange_strong(&(job->error), &expected, error);
+		}
+	}
+}
+
+enum AssetError asset_set_copy(struct AssetSet *set, char *output_directory, unsigned int threads) {
+	if (set == NULL || output_directory == NULL) {
+		fprintf(stderr, "[asset_set_copy] Cannot copy assets using a set or output directory pointer that points to NULL.\n");
+		return ASSET_ERROR_NULL_POINTER;
+	}
+
+	for (size_t i = 0; i < set->assets_length; i++) {
+		if (set->assets[i].fingerprinted == NULL) {
+			fprintf(stderr, "[asset_set_copy] Asset \"%s\" has not been fingerprinted; call asset_set_fingerprint first.\n", set->assets[i].path);
+			return ASSET_ERROR_NULL_POINTER;
+		}
+	}
+
+	struct AssetJob job = { .set = set, .output_directory = output_directory };
+	atomic_init(&(job.error), ASSET_ERROR_NONE);
+	if (!parallel_for(set->assets_length, threads, asset_copy_range, &job))
+		return ASSET_ERROR_FAILED_REALLOC;
+
+	return atomic_load(&(job.error));
+}
+
+static struct Asset* asset_set_search(struct AssetSet *set, size_t *order, bool fingerprinted, const char *path) {
+	if (order == NULL)
+		return NULL;
+
+	size_t low = 0;
+	size_t high = set->assets_length;
+	while (low < high) {
+		size_t middle = (low + high) / 2;
+		struct Asset *asset = &(set->assets[order[middle]]);
+		int comparison = strcmp(fingerprinted ? asset->fingerprinted : asset->path, path);
+		if (comparison == 0)
+			return asset;
+		if (comparison < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return NULL;
+}
+
+const char* asset_set_lookup(struct AssetSet *set, const char *path) {
+	if (set == NULL || path == NULL)
+		return NULL;
+
+	while (*path == '/')
+		path++;
+
+	struct Asset *asset = asset_set_search(set, set->by_path, false, path);
+	return asset == NULL ? NULL : asset->fingerprinted;
+}
+
+bool asset_set_contains(struct AssetSet *set, const char *path) {
+	if (set == NULL || path == NULL)
+		return false;
+
+	while (*path == '/')
+		path++;
+
+	return asset_set_search(set, set->by_path, false, path) != NULL ||
+		asset_set_search(set, set->by_fingerprinted, true, path) != NULL;
+}
+
+enum AssetError asset_rewrite_pages(struct AssetSet *set, struct Page **pages, size_t pages_length) {
+	if (set == NULL || pages == NULL) {
+		fprintf(stderr, "[asset_rewrite_pages] Cannot rewrite pages using a set or pages pointer that points to NULL.\n");
+		return ASSET_ERROR_NULL_POINTER;
+	}
+
+	char resolved[PATH_MAX];
+	char rewritten[PATH_MAX];
+	for (size_t i = 0; i < pages_length; i++) {
+		if (pages[i]->page_type != PAGETYPE_GRID_LANDING || pages[i]->page_data == NULL)
+			continue;
+
+		struct GridPage *grid_page = pages[i]->page_data;
+		for (size_t j = 0; j < grid_page->grid_items_length; j++) {
+			struct String *href = grid_page->grid_items[j].href;
+			if (!link_resolve(pages[i]->path, href->data, resolved, sizeof(resolved)))
+				continue;
+
+			const char *fingerprinted = asset_set_lookup(set, resolved);
+			if (fingerprinted == NULL)
+				continue;
+
+			// Use a root relative href and keep any query or fragment
+			int length = snprintf(rewritten, sizeof(rewritten), "/%s%s", fingerprinted, href->data + strcspn(href->data, "?#"));
+			if (length < 0 || (size_t) length >= sizeof(rewritten) || string_set(href, rewritten, length) != STRING_ERROR_NONE) {
+				fprintf(stderr, "[asset_rewrite_pages] Failed to rewrite href \"%s\" of page \"%s\".\n", href->data, pages[i]->path);
+				return ASSET_ERROR_FAILED_REALLOC;
+			}
+		}
+	}
+
+	return ASSET_ERROR_NONE;
+}
+
+// Rewrites root relative href="/..." and src="/..." values in buffer.
+static enum AssetError asset_rewrite_buffer(struct AssetSet *set, struct Buffer *buffer) {
+	struct Buffer rewritten;
+	if (buffer_init(&rewritten, buffer->length + 256) != BUFFER_ERROR_NONE)
+		return ASSET_ERROR_FAILED_REALLOC;
+
+	char path[PATH_MAX];
+	size_t copied = 0;
+	for (size_t i = 0; i < buffer->length; i++) {
+		size_t value_start;
+		if (buffer->length - i > 7 && memcmp(buffer->data + i, "href=\"/", 7) == 0)
+			value_start = i + 6;
+		else if (buffer->length - i > 6 && memcmp(buffer->data + i, "src=\"/", 6) == 0)
+			value_start = i + 5;
+		else
+			continue;
+
+		const char *value_end = memchr(buffer->data + value_start, '"', buffer->length - value_start);
+		if (value_end == NULL)
+			break;
+
+		size_t value_length = value_end - (buffer->data + value_start);
+		size_t path_length = strcspn(buffer->data + value_start, "?#\"");
+		if (path_length >= sizeof(path) || (value_start + 1 < buffer->length && buffer->data[value_start + 1] == '/')) {
+			i = value_start + value_length;
+			continue;
+		}
+		memcpy(path, buffer->data + value_start, path_length);
+		path[path_length] = '\0';
+
+		const char *fingerprinted = asset_set_lookup(set, path);
+		if (fingerprinted != NULL) {
+			if (buffer_append(&rewritten, buffer->data + copied, value_start + 1 - copied) != BUFFER_ERROR_NONE ||
+			    buffer_append_cstring(&rewritten, fingerprinted) != BUFFER_ERROR_NONE) {
+				buffer_free(&rewritten);
+				return ASSET_ERROR_FAILED_REALLOC;
+			}
+			copied = value_start + path_length;
+		}
+		i = value_start + value_length;
+	}
+
+	if (buffer_append(&rewritten, buffer->data + copied, buffer->length - copied) != BUFFER_ERROR_NONE) {
+		buffer_free(&rewritten);
+		return ASSET_ERROR_FAILED_REALLOC;
+	}
+
+	buffer_free(buffer);
+	*buffer = rewritten;
+	return ASSET_ERROR_NONE;
+}
+
+enum AssetError asset_rewrite_layout(struct AssetSet *set, struct Layout *layout) {
+	if (set == NULL || layout == NULL) {
+		fprintf(stderr, "[asset_rewrite_layout] Cannot rewrite a layout using a set or layout pointer that points to NULL.\n");
+		return ASSET_ERROR_NULL_POINTER;
+	}
+
+	enum AssetError error = asset_rewrite_buffer(set, &(layout->head));
+	if (error == ASSET_ERROR_NONE)
+		error = asset_rewrite_buffer(set, &(layout->tail));
+	return error;
+}
+
+void asset_set_destroy(struct AssetSet *set) {
+	if (set == NULL) {
+		fprintf(stderr, "[asset_set_destroy] Cannot free the memory of an AssetSet pointer that points to NULL.\n");
+		return;
+	}
+
+	if (set->assets != NULL) {
+		for (size_t i = 0; i < set->assets_length; i++) {
+			free(set->assets[i].path);
+			free(set->assets[i].fingerprinted);
+		}
+		free(set->assets);
+	}
+
+	free(set->by_path);
+	free(set->by_fingerprinted);
+	free(set->source_directory);
+	free(set);
+}
@@ -0,0 +1,61 @@
+#ifndef wpgasset_h
+#define wpgasset_h
+#include <stdbool.h>
+#include <stddef.h>
+#include "wpglayout.h"
+#include "wpglib.h"
+
+enum AssetError {
+	ASSET_ERROR_NONE,
+	ASSET_ERROR_NULL_POINTER,
+	ASSET_ERROR_FAILED_OPEN,
+	ASSET_ERROR_FAILED_READ,
+	ASSET_ERROR_FAILED_WRITE,
+	ASSET_ERROR_FAILED_REALLOC
+};
+
+struct Asset {
+	char *path;		// site relative source path, e.g. "css/site.css"
+	char *fingerprinted;	// content addressed path, e.g. "css/site.0f3c2a9b8d7e6f51.css"
+	unsigned long long hash;
+};
+
+struct AssetSet {
+	char *source_directory;
+	struct Asset *assets;
+	size_t assets_length;
+	size_t assets_capacity;
+	size_t *by_path;		// asset indexes sorted by path, built by asset_set_fingerprint
+	size_t *by_fingerprinted;	// asset indexes sorted by fingerprinted path
+};
+
+// 64-bit XXH64 of data. Stripes of 32 bytes feed four independent
+// accumulators, which keeps the multiply pipelines (or vector lanes) busy.
+unsigned long long asset_hash(const void *data, size_t length, unsigned long long seed);
+
+struct AssetSet* asset_set_create(char *source_directory);
+
+enum AssetError asset_set_add(struct AssetSet *set, char *path);
+
+// Hashes every asset in parallel and derives its fingerprinted path.
+enum AssetError asset_set_fingerprint(struct AssetSet *set, unsigned int threads);
+
+// Copies every asset to its fingerprinted path under output_directory, using a
+// reflink or copy_file_range where the filesystem allows. Assets whose target
+// already exists are skipped, as the name already pins the content.
+enum AssetError asset_set_copy(struct AssetSet *set, char *output_directory, unsigned int threads);
+
+// Returns the fingerprinted path for a site relative asset path, or NULL.
+const char* asset_set_lookup(struct AssetSet *set, const char *path);
+
+// True if path names an asset, either by its source or its fingerprinted path.
+bool asset_set_contains(struct AssetSet *set, const char *path);
+
+// Points GridPage hrefs that resolve to an asset at its fingerprinted path.
+enum AssetError asset_rewrite_pages(struct AssetSet *set, struct Page **pages, size_t pages_length);
+
+// Rewrites root relative href="..." and src="..." references in the layout.
+enum AssetError asset_rewrite_layout(struct AssetSet *set, struct Layout *layout);
+
+void asset_set_destroy(struct AssetSet *set);
+#endif
@@ -0,0 +1,196 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "wpgbuffer.h"
+
+static _Thread_local size_t buffer_growth_count;
+
+enum BufferError buffer_init(struct Buffer *buffer, size_t capacity) {
+	if (buffer == NULL) {
+		fprintf(stderr, "[buffer_init] Cannot initialize a Buffer pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	if (capacity == 0) capacity = 64;
+
+	buffer->length = 0;
+	buffer->capacity = capacity;
+	buffer->mapped = false;
+	buffer->hugepages = false;
+	buffer->data = malloc(sizeof(char) * capacity);
+	buffer_growth_count++;
+	if (buffer->data == NULL) {
+		fprintf(stderr, "[buffer_init] Failed to allocate %zu bytes for a new Buffer.\n", capacity);
+		buffer->capacity = 0;
+		return BUFFER_ERROR_FAILED_REALLOC;
+	}
+
+	return BUFFER_ERROR_NONE;
+}
+
+// Mappings are whole pages, and hugepages only cover aligned 2 MiB extents.
+static size_t buffer_mapped_size(size_t capacity, bool hugepages) {
+	size_t granule = hugepages ? 2 * 1024 * 1024 : (size_t) sysconf(_SC_PAGESIZE);
+	return (capacity + granule - 1) / granule * granule;
+}
+
+static void buffer_advise(struct Buffer *buffer) {
+#ifdef MADV_HUGEPAGE
+	if (buffer->hugepages)
+		madvise(buffer->data, buffer->capacity, MADV_HUGEPAGE);
+#endif
+}
+
+enum BufferError buffer_init_mapped(struct Buffer *buffer, size_t capacity, bool hugepages) {
+	if (buffer == NULL) {
+		fprintf(stderr, "[buffer_init_mapped] Cannot initialize a Buffer pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	buffer->length = 0;
+	buffer->capacity = buffer_mapped_size(capacity != 0 ? capacity : 1, hugepages);
+	buffer->mapped = true;
+	buffer->hugepages = hugepages;
+	buffer->data = mmap(NULL, buffer->capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	buffer_growth_count++;
+	if (buffer->data == MAP_FAILED) {
+		fprintf(stderr, "[buffer_init_mapped] Failed to map %zu bytes for a new Buffer.\n", buffer->capacity);
+		buffer->data = NULL;
+		buffer->capacity = 0;
+		buffer->mapped = false;
+		return BUFFER_ERROR_FAILED_REALLOC;
+	}
+
+	buffer_advise(buffer);
+	return BUFFER_ERROR_NONE;
+}
+
+enum BufferError buffer_reserve(struct Buffer *buffer, size_t additional) {
+	if (buffer == NULL) {
+		fprintf(stderr, "[buffer_reserve] Cannot reserve memory for a Buffer pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	if (buffer->capacity - buffer->length >= additional)
+		return BUFFER_ERROR_NONE;
+
+	// Grow geometrically so that repeated appends stay amortized O(1)
+	size_t new_capacity = buffer->capacity ? buffer->capacity : 64;
+	while (new_capacity - buffer->length < additional)
+		new_capacity *= 2;
+
+	if (buffer->mapped) {
+		new_capacity = buffer_mapped_size(new_capacity, buffer->hugepages);
+		char *new_data = mremap(buffer->data, buffer->capacity, new_capacity, MREMAP_MAYMOVE);
+		buffer_growth_count++;
+		if (new_data == MAP_FAILED) {
+			fprintf(stderr, "[buffer_reserve] Failed to remap the Buffer to %zu bytes.\n", new_capacity);
+			return BUFFER_ERROR_FAILED_REALLOC;
+		}
+
+		buffer->data = new_data;
+		buffer->capacity = new_capacity;
+		buffer_advise(buffer);
+		return BUFFER_ERROR_NONE;
+	}
+
+	char *new_data = realloc(buffer->data, sizeof(char) * new_capacity);
+	buffer_growth_count++;
+	if (new_data == NULL) {
+		fprintf(stderr, "[buffer_reserve] Failed to reallocate the Buffer to %zu bytes.\n", new_capacity);
+		return BUFFER_ERROR_FAILED_REALLOC;
+	}
+
+	buffer->data = new_data;
+	buffer->capacity = new_capacity;
+	return BUFFER_ERROR_NONE;
+}
+
+enum BufferError buffer_append(struct Buffer *buffer, const char *data, size_t length) {
+	if (data == NULL) {
+		fprintf(stderr, "[buffer_append] Cannot append data from a char pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	enum BufferError error = buffer_reserve(buffer, length);
+	if (error != BUFFER_ERROR_NONE)
+		return error;
+
+	memcpy(buffer->data + buffer->length, data, length);
+	buffer->length += length;
+	return BUFFER_ERROR_NONE;
+}
+
+enum BufferError buffer_append_cstring(struct Buffer *buffer, const char *data) {
+	if (data == NULL) {
+		fprintf(stderr, "[buffer_append_cstring] Cannot append data from a char pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	return buffer_append(buffer, data, strlen(data));
+}
+
+enum BufferError buffer_append_escaped(struct Buffer *buffer, const char *data, size_t length) {
+	if (data == NULL) {
+		fprintf(stderr, "[buffer_append_escaped] Cannot append data from a char pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	// Copy runs of characters that need no escaping in one go
+	size_t run_start = 0;
+	for (size_t i = 0; i < length; i++) {
+		const char *entity;
+		switch (data[i]) {
+			case '&':  entity = "&amp;";  break;
+			case '<':  entity = "&lt;";   break;
+			case '>':  entity = "&gt;";   break;
+			case '"':  entity = "&quot;"; break;
+			case '\'': entity = "&#39;";  break;
+			default:   continue;
+		}
+
+		enum BufferError error = buffer_append(buffer, data + run_start, i - run_start);
+		if (error != BUFFER_ERROR_NONE)
+			return error;
+
+		error = buffer_append_cstring(buffer, entity);
+		if (error != BUFFER_ERROR_NONE)
+			return error;
+
+		run_start = i + 1;
+	}
+
+	return buffer_append(buffer, data + run_start, length - run_start);
+}
+
+void buffer_clear(struct Buffer *buffer) {
+	if (buffer == NULL) {
+		fprintf(stderr, "[buffer_clear] Cannot clear a Buffer pointer that points to NULL.\n");
+		return;
+	}
+
+	buffer->length = 0;
+}
+
+void buffer_free(struct Buffer *buffer) {
+	if (buffer == NULL) {
+		fprintf(stderr, "[buffer_free] Cannot free the memory of a Buffer pointer that points to NULL.\n");
+		return;
+	}
+
+	if (buffer->mapped && buffer->data != NULL)
+		munmap(buffer->data, buffer->capacity);
+	else
+		free(buffer->data);
+	buffer->data = NULL;
+	buffer->mapped = false;
+	buffer->length = 0;
+	buffer->capacity = 0;
+}
+
+size_t buffer_growths() {
+	return buffer_growth_count;
+}
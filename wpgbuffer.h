@@ -0,0 +1,51 @@
+#ifndef wpgbuffer_h
+#define wpgbuffer_h
+#include <stdbool.h>
+#include <stddef.h>
+
+// Growable byte buffer for generated output, meant to be appended to and
+// flushed repeatedly.
+
+enum BufferError {
+	BUFFER_ERROR_NONE,
+	BUFFER_ERROR_NULL_POINTER,
+	BUFFER_ERROR_FAILED_REALLOC
+};
+
+struct Buffer {
+	char *data;
+	size_t length;
+	size_t capacity;
+	bool mapped;		// data comes from mmap rather than malloc
+	bool hugepages;
+};
+
+enum BufferError buffer_init(struct Buffer *buffer, size_t capacity);
+
+// Like buffer_init, but the memory is mapped straight from the kernel and grown
+// with mremap. Nothing is backed until it is written, so the pages land on the
+// NUMA node of the thread that first writes them, which for a worker's own
+// output buffer is the worker. With hugepages set the mapping is offered to
+// transparent hugepages, which cuts TLB misses on buffers of a few megabytes
+// and up; the kernel may still decline.
+enum BufferError buffer_init_mapped(struct Buffer *buffer, size_t capacity, bool hugepages);
+
+enum BufferError buffer_reserve(struct Buffer *buffer, size_t additional);
+
+enum BufferError buffer_append(struct Buffer *buffer, const char *data, size_t length);
+
+enum BufferError buffer_append_cstring(struct Buffer *buffer, const char *data);
+
+// Appends data with &, <, >, " and ' replaced by entities. Safe for both HTML
+// text/attribute values and XML character data.
+enum BufferError buffer_append_escaped(struct Buffer *buffer, const char *data, size_t length);
+
+void buffer_clear(struct Buffer *buffer);
+
+// Number of times a Buffer on the calling thread has been allocated or grown,
+// for profiling. Other heap allocations, such as those of Strings and Pages,
+// are not counted. Never reset.
+size_t buffer_growths();
+
+void buffer_free(struct Buffer *buffer);
+#endif
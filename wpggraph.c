@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "wpglib.h"
+#include "wpglinks.h"
+#include "wpgparallel.h"
+#include "wpggraph.h"
+
+#define LINK_GRAPH_NONE UINT_MAX
+// Neighbours considered on each side of a page within a grid.
+#define LINK_GRAPH_WINDOW 3
+// Grids consulted per page when ranking related pages.
+#define LINK_GRAPH_SOURCES_MAX 16
+
+struct LinkGraphJob {
+	struct Page **pages;
+	size_t pages_length;
+	size_t *anchor_offsets;		// anchors before each page, pages_length + 1 entries
+	struct PathSet *set;
+	unsigned int *targets;		// resolved page per anchor, or LINK_GRAPH_NONE
+	size_t *worker_links;		// links found by each worker, then where each worker's links start
+	struct LinkGraph *graph;
+};
+
+struct LinkGraphCandidate {
+	unsigned int page;
+	unsigned int score;
+	unsigned int distance;
+};
+
+// Index of the page holding anchor, by binary search over the anchor offsets.
+static size_t link_graph_anchor_page(struct LinkGraphJob *job, size_t anchor) {
+	size_t low = 0;
+	size_t high = job->pages_length;
+	while (low + 1 < high) {
+		size_t middle = (low + high) / 2;
+		if (job->anchor_offsets[middle] <= anchor)
+			low = middle;
+		else
+			high = middle;
+	}
+	// Skip pages without anchors that share the offset
+	while (low + 1 < job->pages_length && job->anchor_offsets[low + 1] <= anchor)
+		low++;
+	return low;
+}
+
+// The one pass over the anchors: resolve each href to a page index.
+static void link_graph_resolve_range(size_t start, size_t end, unsigned int worker, void *context) {
+	struct LinkGraphJob *job = context;
+	if (start == end)
+		return;
+
+	char resolved[PATH_MAX];
+	size_t links = 0;
+	size_t page_index = link_graph_anchor_page(job, start);
+	for (size_t anchor = start; anchor < end; anchor++) {
+		while (job->anchor_offsets[page_index + 1] <= anchor)
+			page_index++;
+
+		struct Page *page = job->pages[page_index];
+		struct GridPage *grid_page = page->page_data;
+		unsigned int target = LINK_GRAPH_NONE;
+		if (link_resolve(page->path, grid_page->grid_items[anchor - job->anchor_offsets[page_index]].href->data, resolved, sizeof(resolved))) {
+			size_t found = path_set_find(job->set, resolved, strlen(resolved));
+			if (found != PATH_SET_NOT_FOUND && found != page_index)
+				target = (unsigned int) found;
+		}
+
+		job->targets[anchor] = target;
+		if (target != LINK_GRAPH_NONE)
+			links++;
+	}
+	job->worker_links[worker] = links;
+}
+
+// Workers own the same anchor ranges as in the resolve pass, and links come out
+// in anchor order, so each worker can write its links straight into place.
+static void link_graph_compact_range(size_t start, size_t end, unsigned int worker, void *context) {
+	struct LinkGraphJob *job = context;
+	if (start == end)
+		return;
+
+	struct LinkGraph *graph = job->graph;
+	size_t position = job->worker_links[worker];
+	size_t page_index = link_graph_anchor_page(job, start);
+	for (size_t anchor = start; anchor < end; anchor++) {
+		while (job->anchor_offsets[page_index + 1] <= anchor)
+			page_index++;
+		if (anchor == job->anchor_offsets[page_index])
+			graph->out_offsets[page_index] = position;
+
+		if (job->targets[anchor] != LINK_GRAPH_NONE)
+			graph->out_targets[position++] = job->targets[anchor];
+	}
+}
+
+static void link_graph_add_candidate(struct LinkGraphCandidate *candidates, size_t *candidates_length, unsigned int page, unsigned int distance) {
+	for (size_t i = 0; i < *candidates_length; i++) {
+		if (candidates[i].page == page) {
+			candidates[i].score += LINK_GRAPH_WINDOW + 1 - distance;
+			if (distance < candidates[i].distance)
+				candidates[i].distance = distance;
+			return;
+		}
+	}
+
+	candidates[*candidates_length].page = page;
+	candidates[*candidates_length].score = LINK_GRAPH_WINDOW + 1 - distance;
+	candidates[*candidates_length].distance = distance;
+	(*candidates_length)++;
+}
+
+static int link_graph_candidate_compare(const void *a, const void *b) {
+	const struct LinkGraphCandidate *first = a;
+	const struct LinkGraphCandidate *second = b;
+	if (first->score != second->score)
+		return first->score < second->score ? 1 : -1;
+	if (first->distance != second->distance)
+		return first->distance < second->distance ? -1 : 1;
+	return first->page < second->page ? -1 : first->page > second->page;
+}
+
+// Ranks the pages listed near each page by the grids that link to it. Only a
+// bounded window of each grid is looked at, so this is linear in the pages.
+static void link_graph_related_range(size_t start, size_t end, unsigned int worker, void *context) {
+	(void) worker;
+	struct LinkGraph *graph = context;
+	struct LinkGraphCandidate candidates[LINK_GRAPH_SOURCES_MAX * LINK_GRAPH_WINDOW * 2];
+
+	for (size_t page = start; page < end; page++) {
+		size_t candidates_length = 0;
+		size_t sources = 0;
+		for (size_t e = graph->in_offsets[page]; e < graph->in_offsets[page + 1] && sources < LINK_GRAPH_SOURCES_MAX; e++) {
+			unsigned int source = graph->in_sources[e];
+			// A grid listing the page twice only counts once
+			if (e > graph->in_offsets[page] && graph->in_sources[e - 1] == source)
+				continue;
+			sources++;
+
+			size_t out_start = graph->out_offsets[source];
+			size_t out_length = graph->out_offsets[source + 1] - out_start;
+			size_t position = graph->in_positions[e];
+			for (unsigned int distance = 1; distance <= LINK_GRAPH_WINDOW; distance++) {
+				if (position >= distance && graph->out_targets[out_start + position - distance] != page)
+					link_graph_add_candidate(candidates, &candidates_length, graph->out_targets[out_start + position - distance], distance);
+				if (position + distance < out_length && graph->out_targets[out_start + position + distance] != page)
+					link_graph_add_candidate(candidates, &candidates_length, graph->out_targets[out_start + position + distance], distance);
+			}
+		}
+
+		qsort(candidates, candidates_length, sizeof(struct LinkGraphCandidate), link_graph_candidate_compare);
+		size_t kept = candidates_length < LINK_GRAPH_RELATED_MAX ? candidates_length : LINK_GRAPH_RELATED_MAX;
+		for (size_t i = 0; i < kept; i++)
+			graph->related[page * LINK_GRAPH_RELATED_MAX + i] = candidates[i].page;
+		graph->related_length[page] = (unsigned char) kept;
+	}
+}
+
+struct LinkGraph* link_graph_create(struct Page **pages, size_t pages_length, unsigned int threads) {
+	if (pages == NULL && pages_length > 0) {
+		fprintf(stderr, "[link_graph_create] Cannot build a link graph using a pages pointer that points to NULL.\n");
+		return NULL;
+	}
+
+	if (threads == 0)
+		threads = parallel_default_threads();
+
+	struct LinkGraph *graph = calloc(1, sizeof(struct LinkGraph));
+	struct LinkGraphJob job = { .pages = pages, .pages_length = pages_length, .graph = graph };
+	if (graph == NULL) {
+		fprintf(stderr, "[link_graph_create] Failed to allocate memory for a new LinkGraph on the heap.\n");
+		return NULL;
+	}
+	graph->pages_length = pages_length;
+
+	job.anchor_offsets = malloc(sizeof(size_t) * (pages_length + 1));
+	job.worker_links = calloc(threads, sizeof(size_t));
+	graph->out_offsets = malloc(sizeof(size_t) * (pages_length + 1));
+	graph->in_offsets = calloc(pages_length + 1, sizeof(size_t));
+	graph->related = malloc(sizeof(unsigned int) * LINK_GRAPH_RELATED_MAX * (pages_length ? pages_length : 1));
+	graph->related_length = calloc(pages_length ? pages_length : 1, sizeof(unsigned char));
+	if (job.anchor_offsets == NULL || job.worker_links == NULL || graph->out_offsets == NULL || graph->in_offsets == NULL ||
+	    graph->related == NULL || graph->related_length == NULL) {
+		fprintf(stderr, "[link_graph_create] Failed to allocate the offsets of a graph over %zu pages.\n", pages_length);
+		goto failed;
+	}
+
+	// Split the work by anchors rather than pages so one huge grid does not serialize the pass
+	job.anchor_offsets[0] = 0;
+	for (size_t i = 0; i < pages_length; i++) {
+		size_t anchors = 0;
+		if (pages[i]->page_type == PAGETYPE_GRID_LANDING && pages[i]->page_data != NULL)
+			anchors = ((struct GridPage*) pages[i]->page_data)->grid_items_length;
+		job.anchor_offsets[i + 1] = job.anchor_offsets[i] + anchors;
+	}
+	size_t anchors_length = job.anchor_offsets[pages_length];
+
+	job.set = path_set_create(pages, pages_length, threads);
+	job.targets = malloc(sizeof(unsigned int) * (anchors_length ? anchors_length : 1));
+	if (job.set == NULL || job.targets == NULL) {
+		fprintf(stderr, "[link_graph_create] Failed to allocate room to resolve %zu anchors.\n", anchors_length);
+		goto failed;
+	}
+
+	if (!parallel_for(anchors_length, threads, link_graph_resolve_range, &job))
+		goto failed;
+
+	// Turn each worker's link count into where its links start
+	size_t links_length = 0;
+	for (unsigned int w = 0; w < threads; w++) {
+		size_t links = job.worker_links[w];
+		job.worker_links[w] = links_length;
+		links_length += links;
+	}
+	if (links_length >= LINK_GRAPH_NONE) {
+		fprintf(stderr, "[link_graph_create] A link graph can hold at most %u links, but %zu were found.\n", LINK_GRAPH_NONE - 1, links_length);
+		goto failed;
+	}
+
+	graph->out_targets = malloc(sizeof(unsigned int) * (links_length ? links_length : 1));
+	graph->in_sources = malloc(sizeof(unsigned int) * (links_length ? links_length : 1));
+	graph->in_positions = malloc(sizeof(unsigned int) * (links_length ? links_length : 1));
+	if (graph->out_targets == NULL || graph->in_sources == NULL || graph->in_positions == NULL) {
+		fprintf(stderr, "[link_graph_create] Failed to allocate room for %zu links.\n", links_length);
+		goto failed;
+	}
+
+	if (!parallel_for(anchors_length, threads, link_graph_compact_range, &job))
+		goto failed;
+
+	// Pages without anchors start where the next page does
+	graph->out_offsets[pages_length] = links_length;
+	for (size_t i = pages_length; i-- > 0; ) {
+		if (job.anchor_offsets[i] == job.anchor_offsets[i + 1])
+			graph->out_offsets[i] = graph->out_offsets[i + 1];
+	}
+
+	// Transpose with a counting sort. Walking sources in order leaves every
+	// page's backlinks sorted by source without a comparison sort
+	for (size_t e = 0; e < links_length; e++)
+		graph->in_offsets[graph->out_targets[e] + 1]++;
+	for (size_t i = 0; i < pages_length; i++)
+		graph->in_offsets[i + 1] += graph->in_offsets[i];
+	size_t *cursor = job.anchor_offsets;	// no longer needed, reused as fill positions
+	memcpy(cursor, graph->in_offsets, sizeof(size_t) * (pages_length + 1));
+	for (size_t source = 0; source < pages_length; source++) {
+		for (size_t e = graph->out_offsets[source]; e < graph->out_offsets[source + 1]; e++) {
+			size_t slot = cursor[graph->out_targets[e]]++;
+			graph->in_sources[slot] = (unsigned int) source;
+			graph->in_positions[slot] = (unsigned int) (e - graph->out_offsets[source]);
+		}
+	}
+
+	if (!parallel_for(pages_length, threads, link_graph_related_range, graph))
+		goto failed;
+
+	path_set_destroy(job.set);
+	free(job.targets);
+	free(job.worker_links);
+	free(job.anchor_offsets);
+	return graph;
+
+failed:
+	if (job.set != NULL)
+		path_set_destroy(job.set);
+	free(job.targets);
+	free(job.worker_links);
+	free(job.anchor_offsets);
+	link_graph_destroy(graph);
+	return NULL;
+}
+
+void link_graph_destroy(struct LinkGraph *graph) {
+	if (graph == NULL) {
+		fprintf(stderr, "[link_graph_destroy] Cannot free the memory of a LinkGraph pointer that points to NULL.\n");
+		return;
+	}
+
+	free(graph->out_offsets);
+	free(graph->out_targets);
+	free(graph->in_offsets);
+	free(graph->in_sources);
+	free(graph->in_positions);
+	free(graph->related);
+	free(graph->related_length);
+	free(graph);
+}
@@ -0,0 +1,34 @@
+#ifndef wpggraph_h
+#define wpggraph_h
+#include <stddef.h>
+#include "wpglib.h"
+
+// Page to page link graph in compressed sparse row form. The links out of page
+// p are out_targets[out_offsets[p] .. out_offsets[p + 1]), in anchor order,
+// and the links into it are in_sources[in_offsets[p] .. in_offsets[p + 1]),
+// ordered by source page. Pages are identified by their index in the page
+// array the graph was built from. Links to the page itself, external links and
+// links to paths that are not pages are left out.
+
+// Most related pages kept per page.
+#define LINK_GRAPH_RELATED_MAX 5
+
+struct LinkGraph {
+	size_t pages_length;
+	size_t *out_offsets;		// pages_length + 1 entries
+	unsigned int *out_targets;
+	size_t *in_offsets;		// pages_length + 1 entries
+	unsigned int *in_sources;
+	unsigned int *in_positions;	// where each link sits within its source's out_targets
+	unsigned int *related;		// LINK_GRAPH_RELATED_MAX entries per page
+	unsigned char *related_length;
+};
+
+// Builds the graph from every GridPage anchor in one parallel pass over the
+// anchors, then ranks related pages for every page in parallel. Two pages are
+// related when grids list them close together; pages listed near each other by
+// more grids rank higher.
+struct LinkGraph* link_graph_create(struct Page **pages, size_t pages_length, unsigned int threads);
+
+void link_graph_destroy(struct LinkGraph *graph);
+#endif
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "wpgbuffer.h"
+#include "wpglayout.h"
+#include "wpgminify.h"
+
+const char layout_document_prefix[] = "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>";
+const size_t layout_document_prefix_length = sizeof(layout_document_prefix) - 1;
+const char layout_minified_prefix[] = "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>";
+const size_t layout_minified_prefix_length = sizeof(layout_minified_prefix) - 1;
+
+// Appends the whole contents of the file at path, if path is not NULL.
+static bool layout_append_partial(struct Buffer *buffer, char *path) {
+	if (path == NULL)
+		return true;
+
+	FILE *input = fopen(path, "rb");
+	if (input == NULL) {
+		fprintf(stderr, "[layout_append_partial] Failed to open the layout partial \"%s\".\n", path);
+		return false;
+	}
+
+	bool success = true;
+	char chunk[16 * 1024];
+	size_t chunk_length;
+	while (success && (chunk_length = fread(chunk, 1, sizeof(chunk), input)) > 0)
+		success = buffer_append(buffer, chunk, chunk_length) == BUFFER_ERROR_NONE;
+
+	if (ferror(input)) {
+		fprintf(stderr, "[layout_append_partial] Failed to read the layout partial \"%s\".\n", path);
+		success = false;
+	}
+
+	fclose(input);
+	return success;
+}
+
+struct Layout* layout_create(char *head_path, char *header_path, char *nav_path, char *footer_path) {
+	struct Layout *new_layout = malloc(sizeof(struct Layout));
+	if (new_layout == NULL) {
+		fprintf(stderr, "[layout_create] Failed to allocate memory for a new Layout on the heap.\n");
+		return NULL;
+	}
+
+	new_layout->prefix = layout_document_prefix;
+	new_layout->prefix_length = layout_document_prefix_length;
+	new_layout->minified = false;
+	if (buffer_init(&(new_layout->head), 1024) != BUFFER_ERROR_NONE) {
+		free(new_layout);
+		return NULL;
+	}
+	if (buffer_init(&(new_layout->tail), 1024) != BUFFER_ERROR_NONE) {
+		buffer_free(&(new_layout->head));
+		free(new_layout);
+		return NULL;
+	}
+
+	bool success = buffer_append_cstring(&(new_layout->head), "</title>\n") == BUFFER_ERROR_NONE &&
+		layout_append_partial(&(new_layout->head), head_path) &&
+		buffer_append_cstring(&(new_layout->head), "</head>\n<body>\n") == BUFFER_ERROR_NONE &&
+		layout_append_partial(&(new_layout->head), header_path) &&
+		layout_append_partial(&(new_layout->head), nav_path) &&
+		layout_append_partial(&(new_layout->tail), footer_path) &&
+		buffer_append_cstring(&(new_layout->tail), "</body>\n</html>\n") == BUFFER_ERROR_NONE;
+
+	if (!success) {
+		fprintf(stderr, "[layout_create] Failed to build the shared layout.\n");
+		layout_destroy(new_layout);
+		return NULL;
+	}
+
+	return new_layout;
+}
+
+// Replaces the contents of buffer with their minified form.
+static bool layout_minify_buffer(struct Buffer *buffer) {
+	struct Buffer minified;
+	if (buffer_init(&minified, buffer->length) != BUFFER_ERROR_NONE)
+		return false;
+
+	struct Minifier minifier;
+	minifier_init(&minifier);
+	if (minify_append(&minifier, &minified, buffer->data, buffer->length) != BUFFER_ERROR_NONE ||
+	    minify_finish(&minifier, &minified) != BUFFER_ERROR_NONE) {
+		buffer_free(&minified);
+		return false;
+	}
+
+	buffer_free(buffer);
+	*buffer = minified;
+	return true;
+}
+
+bool layout_minify(struct Layout *layout) {
+	if (layout == NULL) {
+		fprintf(stderr, "[layout_minify] Cannot minify a Layout pointer that points to NULL.\n");
+		return false;
+	}
+	if (layout->minified)
+		return true;
+
+	if (!layout_minify_buffer(&(layout->head)) || !layout_minify_buffer(&(layout->tail))) {
+		fprintf(stderr, "[layout_minify] Failed to allocate room for the minified layout.\n");
+		return false;
+	}
+
+	layout->prefix = layout_minified_prefix;
+	layout->prefix_length = layout_minified_prefix_length;
+	layout->minified = true;
+	return true;
+}
+
+void layout_destroy(struct Layout *layout) {
+	if (layout == NULL) {
+		fprintf(stderr, "[layout_destroy] Cannot free the memory of a Layout pointer that points to NULL.\n");
+		return;
+	}
+
+	buffer_free(&(layout->head));
+	buffer_free(&(layout->tail));
+	free(layout);
+}
@@ -0,0 +1,32 @@
+#ifndef wpglayout_h
+#define wpglayout_h
+#include <stdbool.h>
+#include <stddef.h>
+#include "wpgbuffer.h"
+
+// Markup shared by every page, rendered once per build. A page is written as
+//     document prefix, page title, layout head, page body, layout tail
+// where only the title and body are rendered per page; the shared parts are
+// handed to writev as they are and never copied into page output.
+struct Layout {
+	const char *prefix;	// everything before the page title; one of the constants below
+	size_t prefix_length;
+	struct Buffer head;	// "</title>", the head partial, "</head><body>", header and nav partials
+	struct Buffer tail;	// footer partial, "</body></html>"
+	bool minified;		// set by layout_minify; pages should then be rendered minified too
+};
+
+extern const char layout_document_prefix[];
+extern const size_t layout_document_prefix_length;
+extern const char layout_minified_prefix[];
+extern const size_t layout_minified_prefix_length;
+
+// Builds a Layout from partial files. Any path may be NULL to leave that
+// partial out; the head partial is placed inside <head> (stylesheets, meta).
+struct Layout* layout_create(char *head_path, char *header_path, char *nav_path, char *footer_path);
+
+// Minifies the shared markup in place, once per build rather than per page.
+bool layout_minify(struct Layout *layout);
+
+void layout_destroy(struct Layout *layout);
+#endif
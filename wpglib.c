@@ -2,6 +2,29 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "wpgbuffer.h"
+#include "wpgstring.h"
+#include "wpgutf8.h"
+#include "wpglib.h"
+
+// Returns text itself when it is valid UTF-8. Otherwise returns a copy held in
+// scratch with each invalid sequence replaced by U+FFFD, so that bad bytes from
+// source data never reach the generated HTML. The caller frees scratch.
+static char* text_sanitize(char *text, size_t length, struct Buffer *scratch, const char *caller) {
+	if (utf8_validate(text, length) == length)
+		return text;
+
+	if (buffer_init(scratch, length + 16) != BUFFER_ERROR_NONE)
+		return NULL;
+
+	size_t replacements = utf8_sanitize(text, length, scratch);
+	if (buffer_append(scratch, "", 1) != BUFFER_ERROR_NONE)
+		return NULL;
+
+	fprintf(stderr, "[%s] Replaced %zu invalid UTF-8 sequence(s) in \"%.64s%s\" with U+FFFD.\n", caller, replacements, scratch->data, scratch->length > 65 ? "..." : "");
+	return scratch->data;
+}
 
 struct GridPage* grid_page_create() {
 	struct GridPage *new_grid_page = malloc(sizeof(struct GridPage));
@@ -17,39 +40,114 @@ struct GridPage* grid_page_create() {
 		return NULL;
 	}
 	new_grid_page->grid_items_length = 0;
-	new_grid_page->grid_items_capacity = 5;	
+	new_grid_page->grid_items_capacity = 5;
+
+	return new_grid_page;
+}
+
+enum GridPageError grid_page_add(struct GridPage *grid_page, char *href, char *text) {
+	if (grid_page == NULL) {
+		fprintf(stderr, "[grid_page_add] Cannot add a grid item to a GridPage pointer that points to NULL.\n");
+		return GRID_PAGE_ERROR_NULL_POINTER;
+	}
+
+	if (href == NULL || text == NULL) {
+		fprintf(stderr, "[grid_page_add] Cannot add a grid item using an href or text pointer that points to NULL.\n");
+		return GRID_PAGE_ERROR_NULL_POINTER;
+	}
+
+	// Ensure there is room for one more grid item
+	if (grid_page->grid_items_length >= grid_page->grid_items_capacity) {
+		if (grid_page->grid_items_capacity > SIZE_MAX / 2 / sizeof(struct AnchorTag)) {
+			fprintf(stderr, "[grid_page_add] GridPage already holds the maximum of %zu grid items.\n", grid_page->grid_items_capacity);
+			return GRID_PAGE_ERROR_FULL;
+		}
+
+		size_t new_capacity = grid_page->grid_items_capacity * 2;
+		struct AnchorTag *new_grid_items = realloc(grid_page->grid_items, sizeof(struct AnchorTag) * new_capacity);
+		if (new_grid_items == NULL) {
+			fprintf(stderr, "[grid_page_add] Failed to reallocate memory for %zu grid items.\n", new_capacity);
+			return GRID_PAGE_ERROR_FAILED_REALLOC;
+		}
+		grid_page->grid_items = new_grid_items;
+		grid_page->grid_items_capacity = new_capacity;
+	}
+
+	struct AnchorTag *anchor_tag = &(grid_page->grid_items[grid_page->grid_items_length]);
+	struct Buffer scratch = { 0 };
+	char *checked = text_sanitize(href, strlen(href), &scratch, "grid_page_add");
+	anchor_tag->href = checked != NULL ? string_create(checked) : NULL;
+	buffer_free(&scratch);
+	if (anchor_tag->href == NULL) {
+		fprintf(stderr, "[grid_page_add] Failed to create the href String for \"%s\".\n", href);
+		return GRID_PAGE_ERROR_FAILED_REALLOC;
+	}
+
+	checked = text_sanitize(text, strlen(text), &scratch, "grid_page_add");
+	anchor_tag->text = checked != NULL ? string_create(checked) : NULL;
+	buffer_free(&scratch);
+	if (anchor_tag->text == NULL) {
+		fprintf(stderr, "[grid_page_add] Failed to create the text String for \"%s\".\n", text);
+		string_destroy(anchor_tag->href);
+		return GRID_PAGE_ERROR_FAILED_REALLOC;
+	}
+
+	grid_page->grid_items_length++;
+	return GRID_PAGE_ERROR_NONE;
 }
 
-void grid_page_destroy(struct *GridPage grid_page);
+void grid_page_destroy(struct GridPage *grid_page) {
+	if (grid_page == NULL) {
+		fprintf(stderr, "[grid_page_destroy] Cannot free the memory of a GridPage using a pointer that points to NULL.\n");
+		return;
+	}
+
+	if (grid_page->grid_items != NULL) {
+		for (size_t i = 0; i < grid_page->grid_items_length; i++) {
+			if (grid_page->grid_items[i].href != NULL) string_destroy(grid_page->grid_items[i].href);
+			if (grid_page->grid_items[i].text != NULL) string_destroy(grid_page->grid_items[i].text);
+		}
+		free(grid_page->grid_items);
+	}
+
+	free(grid_page);
+}
 
-struct AnchorTag* anchor_tag_create() { 
+struct AnchorTag* anchor_tag_create(char *href, char *text) {
 	struct AnchorTag *new_anchor_tag = malloc(sizeof(struct AnchorTag));
-	if (new_anchor_tag == NULL) { 
+	if (new_anchor_tag == NULL) {
 		fprintf(stderr, "[anchor_tag_create] Failed to allocate memroy for a new AnchorTag on the heap.\n");
 		return NULL;
 	}
-	
-	// Allocate 64 bytes for the href attribute.
-	new_anchor_tag->href_capacity = 64; 
-	new_anchor_tag->href = create_string( &(new_anchor_tag->href_length), new_anchor_tag->href_capacity ); 
-	if (new_anchor_tag->href == NULL) { 
-		fprintf(stderr, "[anchor_tag_create] Failed to allocate memory for a new char buffer for the href attribute.\n");
+
+	if (href == NULL || text == NULL) {
+		fprintf(stderr, "[anchor_tag_create] Cannot create an AnchorTag using an href or text pointer that points to NULL.\n");
 		free(new_anchor_tag);
 		return NULL;
 	}
-	
-	// Allocate 64 bytes for the text attribute.
-	new_anchor_tag->text_capacity = 64; 
-	new_anchor_tag->text = create_string( &(new_anchor_tag->text_length), new_anchor_tag->text_capacity ); 
-	if (new_anchor_tag->text == NULL) { 
-		fprintf(stderr, "[anchor_tag_create] Failed to allocate memory for a new char buffer for the text attribute.\n");
-		free(new_anchor_tag->href);
+
+	struct Buffer scratch = { 0 };
+	char *checked = text_sanitize(href, strlen(href), &scratch, "anchor_tag_create");
+	new_anchor_tag->href = checked != NULL ? string_create(checked) : NULL;
+	buffer_free(&scratch);
+	if (new_anchor_tag->href == NULL) {
+		fprintf(stderr, "[anchor_tag_create] Failed to allocate memory for a new String for the href attribute.\n");
+		free(new_anchor_tag);
+		return NULL;
+	}
+
+	checked = text_sanitize(text, strlen(text), &scratch, "anchor_tag_create");
+	new_anchor_tag->text = checked != NULL ? string_create(checked) : NULL;
+	buffer_free(&scratch);
+	if (new_anchor_tag->text == NULL) {
+		fprintf(stderr, "[anchor_tag_create] Failed to allocate memory for a new String for the text attribute.\n");
+		string_destroy(new_anchor_tag->href);
 		free(new_anchor_tag);
 		return NULL;
 	}
 
 	return new_anchor_tag;
-} 
+}
 
 void anchor_tag_destroy(struct AnchorTag *anchor_tag) {
 	if (anchor_tag == NULL) {
@@ -57,12 +155,171 @@ void anchor_tag_destroy(struct AnchorTag *anchor_tag) {
 		return;
 	}
 
-	if (anchor_tag->href != NULL) free(anchor_tag->href);
-	if (anchor_tag->text != NULL) free(anchor_tag->text);
+	if (anchor_tag->href != NULL) string_destroy(anchor_tag->href);
+	if (anchor_tag->text != NULL) string_destroy(anchor_tag->text);
 
 	free(anchor_tag);
 	return;
 }
 
-struct Page* page_create();
-void page_destroy(struct Page *page);
+struct ArticlePage* article_page_create() {
+	struct ArticlePage *new_article_page = malloc(sizeof(struct ArticlePage));
+	if (new_article_page == NULL) {
+		fprintf(stderr, "[article_page_create] Failed to allocate memory for a new ArticlePage on the heap.\n");
+		return NULL;
+	}
+
+	// Start with an empty body, to be filled with string_set
+	new_article_page->body = string_init();
+	if (new_article_page->body == NULL) {
+		fprintf(stderr, "[article_page_create] Failed to allocate memory for the body of a new ArticlePage.\n");
+		free(new_article_page);
+		return NULL;
+	}
+	new_article_page->body->data[0] = '\0';
+
+	return new_article_page;
+}
+
+enum StringError article_page_set_body(struct ArticlePage *article_page, char *body, size_t length) {
+	if (article_page == NULL || body == NULL) {
+		fprintf(stderr, "[article_page_set_body] Cannot set a body using an ArticlePage or body pointer that points to NULL.\n");
+		return STRING_ERROR_NULL_POINTER;
+	}
+
+	struct Buffer scratch = { 0 };
+	char *checked = text_sanitize(body, length, &scratch, "article_page_set_body");
+	if (checked == NULL) {
+		buffer_free(&scratch);
+		return STRING_ERROR_FAILED_REALLOC;
+	}
+
+	// Replacement characters are longer than the bytes they replace
+	size_t checked_length = checked == body ? length : scratch.length - 1;
+	enum StringError error = string_set(article_page->body, checked, checked_length);
+	buffer_free(&scratch);
+	return error;
+}
+
+void article_page_destroy(struct ArticlePage *article_page) {
+	if (article_page == NULL) {
+		fprintf(stderr, "[article_page_destroy] Cannot free the memory of an ArticlePage using a pointer that points to NULL.\n");
+		return;
+	}
+
+	if (article_page->body != NULL) string_destroy(article_page->body);
+	free(article_page);
+}
+
+struct Page* page_create(enum PageType page_type, char *title, char *path) {
+	if (title == NULL || path == NULL) {
+		fprintf(stderr, "[page_create] Cannot create a Page using a title or path pointer that points to NULL.\n");
+		return NULL;
+	}
+
+	struct Page *new_page = malloc(sizeof(struct Page));
+	if (new_page == NULL) {
+		fprintf(stderr, "[page_create] Failed to allocate memory for a new Page on the heap.\n");
+		return NULL;
+	}
+
+	new_page->page_type = page_type;
+	new_page->page_data = NULL;
+	struct Buffer scratch = { 0 };
+	char *checked = text_sanitize(title, strlen(title), &scratch, "page_create");
+	new_page->title = checked != NULL ? strdup(checked) : NULL;
+	buffer_free(&scratch);
+	checked = text_sanitize(path, strlen(path), &scratch, "page_create");
+	new_page->path = checked != NULL ? strdup(checked) : NULL;
+	buffer_free(&scratch);
+	if (new_page->title == NULL || new_page->path == NULL) {
+		fprintf(stderr, "[page_create] Failed to copy the title \"%s\" and path \"%s\" of the new Page.\n", title, path);
+		free(new_page->title);
+		free(new_page->path);
+		free(new_page);
+		return NULL;
+	}
+
+	// Create the type specific data
+	switch (page_type) {
+		case PAGETYPE_GRID_LANDING:
+			new_page->page_data = grid_page_create();
+			if (new_page->page_data == NULL) {
+				fprintf(stderr, "[page_create] Failed to create the GridPage for page \"%s\".\n", path);
+				page_destroy(new_page);
+				return NULL;
+			}
+			break;
+
+		case PAGETYPE_ARTICLE:
+			new_page->page_data = article_page_create();
+			if (new_page->page_data == NULL) {
+				fprintf(stderr, "[page_create] Failed to create the ArticlePage for page \"%s\".\n", path);
+				page_destroy(new_page);
+				return NULL;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return new_page;
+}
+
+void page_destroy(struct Page *page) {
+	if (page == NULL) {
+		fprintf(stderr, "[page_destroy] Cannot free the memory of a Page using a pointer that points to NULL.\n");
+		return;
+	}
+
+	if (page->page_data != NULL) {
+		switch (page->page_type) {
+			case PAGETYPE_GRID_LANDING:
+				grid_page_destroy((struct GridPage*) page->page_data);
+				break;
+
+			case PAGETYPE_ARTICLE:
+				article_page_destroy((struct ArticlePage*) page->page_data);
+				break;
+
+			default:
+				free(page->page_data);
+				break;
+		}
+	}
+
+	free(page->title);
+	free(page->path);
+	free(page);
+}
+
+size_t page_memory_size(struct Page *page) {
+	if (page == NULL)
+		return 0;
+
+	size_t size = sizeof(struct Page) + strlen(page->title) + 1 + strlen(page->path) + 1;
+	if (page->page_data == NULL)
+		return size;
+
+	switch (page->page_type) {
+		case PAGETYPE_GRID_LANDING: {
+			struct GridPage *grid_page = page->page_data;
+			size += sizeof(struct GridPage) + sizeof(struct AnchorTag) * grid_page->grid_items_capacity;
+			for (size_t i = 0; i < grid_page->grid_items_length; i++) {
+				size += 2 * sizeof(struct String);
+				size += grid_page->grid_items[i].href->capacity + grid_page->grid_items[i].text->capacity;
+			}
+			break;
+		}
+
+		case PAGETYPE_ARTICLE:
+			size += sizeof(struct ArticlePage) + sizeof(struct String) + ((struct ArticlePage*) page->page_data)->body->capacity;
+			break;
+
+		default:
+			break;
+	}
+
+	return size;
+}
@@ -1,5 +1,6 @@
 #ifndef wpglib_h
 #define wpglib_h
+#include "wpgstring.h"
 
 enum PageType {
 	PAGETYPE_NONE,
@@ -7,21 +8,32 @@ enum PageType {
 	PAGETYPE_ARTICLE
 };
 
+enum GridPageError {
+	GRID_PAGE_ERROR_NONE,
+	GRID_PAGE_ERROR_NULL_POINTER,
+	GRID_PAGE_ERROR_FULL,
+	GRID_PAGE_ERROR_FAILED_REALLOC
+};
 
 struct AnchorTag {
-	struct String href;
-	struct String text;
+	struct String *href;
+	struct String *text;
 };
 
 struct GridPage {
 	struct AnchorTag *grid_items;
-	unsigned short grid_items_length; 
-	unsigned short grid_items_capacity;
+	size_t grid_items_length;
+	size_t grid_items_capacity;
+};
+
+struct ArticlePage {
+	struct String *body;
 };
 
 struct Page{
 	enum PageType page_type;
 	char *title;
+	char *path;		// output path relative to the site root, e.g. "blog/index.html"
 	void *page_data;	// based on page_type
 };
 
@@ -29,12 +41,20 @@ struct String* string_create();
 void string_destroy(struct String *string);
 
 struct GridPage* grid_page_create();
-void grid_page_destroy(struct *GridPage grid_page);
+enum GridPageError grid_page_add(struct GridPage *grid_page, char *href, char *text);
+void grid_page_destroy(struct GridPage *grid_page);
 
 struct AnchorTag* anchor_tag_create(char *href, char *text);
 void anchor_tag_destroy(struct AnchorTag *anchor_tag);
 
-struct Page* page_create();
+struct ArticlePage* article_page_create();
+enum StringError article_page_set_body(struct ArticlePage *article_page, char *body, size_t length);
+void article_page_destroy(struct ArticlePage *article_page);
+
+struct Page* page_create(enum PageType page_type, char *title, char *path);
 void page_destroy(struct Page *page);
 
+// Approximate heap bytes held by page and everything it owns.
+size_t page_memory_size(struct Page *page);
+
 #endif
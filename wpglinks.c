@@ -0,0 +1,565 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include "wpgbuffer.h"
+#include "wpglib.h"
+#include "wpgparallel.h"
+#include "wpglinks.h"
+
+#define LINK_INDEX_FLUSH_BYTES (64 * 1024)
+
+struct LinkPair* link_pairs_collect(struct Page **pages, size_t pages_length, size_t *pairs_length, char **targets) {
+	if (pages == NULL || pairs_length == NULL || targets == NULL) {
+		fprintf(stderr, "[link_pairs_collect] Cannot collect links using a pages, length or targets pointer that points to NULL.\n");
+		return NULL;
+	}
+
+	// Count first so that the pairs are gathered with a single allocation
+	size_t count = 0;
+	for (size_t i = 0; i < pages_length; i++) {
+		if (pages[i]->page_type != PAGETYPE_GRID_LANDING || pages[i]->page_data == NULL)
+			continue;
+		count += ((struct GridPage*) pages[i]->page_data)->grid_items_length;
+	}
+
+	// Resolved targets go into one text block; pointers into it are only
+	// taken once it has stopped growing
+	struct LinkPair *pairs = malloc(sizeof(struct LinkPair) * (count ? count : 1));
+	size_t *offsets = malloc(sizeof(size_t) * (count ? count : 1));
+	struct Buffer text;
+	if (pairs == NULL || offsets == NULL || buffer_init(&text, 64 * 1024) != BUFFER_ERROR_NONE) {
+		fprintf(stderr, "[link_pairs_collect] Failed to allocate memory for %zu link pairs.\n", count);
+		free(pairs);
+		free(offsets);
+		return NULL;
+	}
+
+	char resolved[PATH_MAX];
+	size_t length = 0;
+	for (size_t i = 0; i < pages_length; i++) {
+		if (pages[i]->page_type != PAGETYPE_GRID_LANDING || pages[i]->page_data == NULL)
+			continue;
+
+		struct GridPage *grid_page = (struct GridPage*) pages[i]->page_data;
+		for (size_t j = 0; j < grid_page->grid_items_length; j++) {
+			if (!link_resolve(pages[i]->path, grid_page->grid_items[j].href->data, resolved, sizeof(resolved)) || resolved[0] == '\0')
+				continue;
+
+			offsets[length] = text.length;
+			if (buffer_append(&text, resolved, strlen(resolved) + 1) != BUFFER_ERROR_NONE) {
+				free(pairs);
+				free(offsets);
+				buffer_free(&text);
+				return NULL;
+			}
+			pairs[length].source = pages[i]->path;
+			length++;
+		}
+	}
+
+	for (size_t i = 0; i < length; i++)
+		pairs[i].target = text.data + offsets[i];
+	free(offsets);
+
+	*targets = text.data;
+	*pairs_length = length;
+	return pairs;
+}
+
+static int link_pair_compare(const void *a, const void *b) {
+	const struct LinkPair *left = a;
+	const struct LinkPair *right = b;
+
+	int order = strcmp(left->target, right->target);
+	if (order != 0)
+		return order;
+	return strcmp(left->source, right->source);
+}
+
+struct LinkIndexWriter* link_index_writer_create(char *output_path) {
+	if (output_path == NULL) {
+		fprintf(stderr, "[link_index_writer_create] Cannot create a LinkIndexWriter using an output path that points to NULL.\n");
+		return NULL;
+	}
+
+	struct LinkIndexWriter *new_writer = calloc(1, sizeof(struct LinkIndexWriter));
+	if (new_writer == NULL) {
+		fprintf(stderr, "[link_index_writer_create] Failed to allocate memory for a new LinkIndexWriter on the heap.\n");
+		return NULL;
+	}
+
+	if (buffer_init(&(new_writer->buffer), LINK_INDEX_FLUSH_BYTES + 1024) != BUFFER_ERROR_NONE ||
+	    buffer_init(&(new_writer->previous_target), 256) != BUFFER_ERROR_NONE ||
+	    buffer_init(&(new_writer->previous_source), 256) != BUFFER_ERROR_NONE) {
+		link_index_writer_destroy(new_writer);
+		return NULL;
+	}
+
+	new_writer->output = fopen(output_path, "wb");
+	if (new_writer->output == NULL) {
+		fprintf(stderr, "[link_index_writer_create] Failed to open link index \"%s\" for writing.\n", output_path);
+		link_index_writer_destroy(new_writer);
+		return NULL;
+	}
+
+	return new_writer;
+}
+
+static bool link_index_writer_remember(struct Buffer *previous, const char *value) {
+	buffer_clear(previous);
+	return buffer_append(previous, value, strlen(value) + 1) == BUFFER_ERROR_NONE;
+}
+
+enum LinkError link_index_writer_add(struct LinkIndexWriter *writer, const char *target, const char *source) {
+	if (writer == NULL || target == NULL || source == NULL) {
+		fprintf(stderr, "[link_index_writer_add] Cannot add a link using pointers that point to NULL.\n");
+		return LINK_ERROR_NULL_POINTER;
+	}
+
+	// Group consecutive pairs of one target onto one line
+	bool new_target = writer->pairs_length == 0 || strcmp(target, writer->previous_target.data) != 0;
+	if (!new_target && strcmp(source, writer->previous_source.data) == 0)
+		return LINK_ERROR_NONE;
+
+	if (new_target) {
+		if (writer->pairs_length != 0 && buffer_append(&(writer->buffer), "\n", 1) != BUFFER_ERROR_NONE)
+			return LINK_ERROR_FAILED_REALLOC;
+		if (buffer_append_cstring(&(writer->buffer), target) != BUFFER_ERROR_NONE ||
+		    !link_index_writer_remember(&(writer->previous_target), target))
+			return LINK_ERROR_FAILED_REALLOC;
+	}
+
+	if (buffer_append(&(writer->buffer), "\t", 1) != BUFFER_ERROR_NONE ||
+	    buffer_append_cstring(&(writer->buffer), source) != BUFFER_ERROR_NONE ||
+	    !link_index_writer_remember(&(writer->previous_source), source))
+		return LINK_ERROR_FAILED_REALLOC;
+
+	writer->pairs_length++;
+
+	if (writer->buffer.length >= LINK_INDEX_FLUSH_BYTES) {
+		if (fwrite(writer->buffer.data, 1, writer->buffer.length, writer->output) != writer->buffer.length) {
+			fprintf(stderr, "[link_index_writer_add] Failed to write %zu bytes of the link index.\n", writer->buffer.length);
+			return LINK_ERROR_FAILED_WRITE;
+		}
+		buffer_clear(&(writer->buffer));
+	}
+
+	return LINK_ERROR_NONE;
+}
+
+enum LinkError link_index_writer_finish(struct LinkIndexWriter *writer) {
+	if (writer == NULL) {
+		fprintf(stderr, "[link_index_writer_finish] Cannot finish a LinkIndexWriter pointer that points to NULL.\n");
+		return LINK_ERROR_NULL_POINTER;
+	}
+
+	enum LinkError error = LINK_ERROR_NONE;
+	if (writer->pairs_length > 0 && buffer_append(&(writer->buffer), "\n", 1) != BUFFER_ERROR_NONE)
+		error = LINK_ERROR_FAILED_REALLOC;
+
+	if (error == LINK_ERROR_NONE && fwrite(writer->buffer.data, 1, writer->buffer.length, writer->output) != writer->buffer.length)
+		error = LINK_ERROR_FAILED_WRITE;
+
+	if (fclose(writer->output) != 0 && error == LINK_ERROR_NONE)
+		error = LINK_ERROR_FAILED_WRITE;
+	writer->output = NULL;
+
+	if (error != LINK_ERROR_NONE)
+		fprintf(stderr, "[link_index_writer_finish] Failed to write the link index (error %d).\n", error);
+
+	buffer_clear(&(writer->buffer));
+	return error;
+}
+
+void link_index_writer_destroy(struct LinkIndexWriter *writer) {
+	if (writer == NULL) {
+		fprintf(stderr, "[link_index_writer_destroy] Cannot free the memory of a LinkIndexWriter pointer that points to NULL.\n");
+		return;
+	}
+
+	if (writer->output != NULL)
+		fclose(writer->output);
+
+	buffer_free(&(writer->buffer));
+	buffer_free(&(writer->previous_target));
+	buffer_free(&(writer->previous_source));
+	free(writer);
+}
+
+enum LinkError link_index_write(struct Page **pages, size_t pages_length, char *output_path) {
+	if (pages == NULL || output_path == NULL) {
+		fprintf(stderr, "[link_index_write] Cannot write a link index using a pages or output path pointer that points to NULL.\n");
+		return LINK_ERROR_NULL_POINTER;
+	}
+
+	size_t pairs_length = 0;
+	char *targets = NULL;
+	struct LinkPair *pairs = link_pairs_collect(pages, pages_length, &pairs_length, &targets);
+	if (pairs == NULL)
+		return LINK_ERROR_FAILED_REALLOC;
+
+	qsort(pairs, pairs_length, sizeof(struct LinkPair), link_pair_compare);
+
+	struct LinkIndexWriter *writer = link_index_writer_create(output_path);
+	if (writer == NULL) {
+		free(pairs);
+		free(targets);
+		return LINK_ERROR_FAILED_OPEN;
+	}
+
+	enum LinkError error = LINK_ERROR_NONE;
+	for (size_t i = 0; i < pairs_length && error == LINK_ERROR_NONE; i++)
+		error = link_index_writer_add(writer, pairs[i].target, pairs[i].source);
+
+	if (error == LINK_ERROR_NONE)
+		error = link_index_writer_finish(writer);
+
+	link_index_writer_destroy(writer);
+	free(pairs);
+	free(targets);
+	return error;
+}
+
+static unsigned long long path_hash(const char *path, size_t length) {
+	// 64-bit FNV-1a
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char) path[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static const char* path_key(const char *path) {
+	while (*path == '/')
+		path++;
+	return path;
+}
+
+static void path_set_insert_range(size_t start, size_t end, unsigned int worker, void *context) {
+	(void) worker;
+	struct PathSet *set = context;
+
+	for (size_t i = start; i < end; i++) {
+		const char *key = path_key(set->pages[i]->path);
+		size_t key_length = strlen(key);
+		unsigned long long hash = path_hash(key, key_length);
+		unsigned long long entry = ((hash >> 32) << 32) | (unsigned long long) (i + 1);
+
+		for (size_t slot = hash & set->mask; ; slot = (slot + 1) & set->mask) {
+			unsigned long long expected = 0;
+			if (atomic_compare_exchange_strong(&(set->slots[slot]), &expected, entry))
+				break;
+
+			// The slot was taken, possibly by this very path from another page
+			if ((expected >> 32) == (hash >> 32)) {
+				const char *other = path_key(set->pages[(expected & 0xFFFFFFFFULL) - 1]->path);
+				if (strcmp(other, key) == 0) {
+					atomic_fetch_add(&(set->duplicates), 1);
+					break;
+				}
+			}
+		}
+	}
+}
+
+struct PathSet* path_set_create(struct Page **pages, size_t pages_length, unsigned int threads) {
+	if (pages == NULL && pages_length > 0) {
+		fprintf(stderr, "[path_set_create] Cannot create a PathSet using a pages pointer that points to NULL.\n");
+		return NULL;
+	}
+
+	if (pages_length >= 0xFFFFFFFFULL) {
+		fprintf(stderr, "[path_set_create] A PathSet can hold at most %llu pages, but %zu were given.\n", 0xFFFFFFFEULL, pages_length);
+		return NULL;
+	}
+
+	struct PathSet *new_set = malloc(sizeof(struct PathSet));
+	if (new_set == NULL) {
+		fprintf(stderr, "[path_set_create] Failed to allocate memory for a new PathSet on the heap.\n");
+		return NULL;
+	}
+
+	// Keep the load factor at or below one half
+	size_t capacity = 16;
+	while (capacity < pages_length * 2)
+		capacity *= 2;
+
+	new_set->slots = calloc(capacity, sizeof(unsigned long long));
+	if (new_set->slots == NULL) {
+		fprintf(stderr, "[path_set_create] Failed to allocate %zu slots for a new PathSet.\n", capacity);
+		free(new_set);
+		return NULL;
+	}
+	new_set->mask = capacity - 1;
+	new_set->pages = pages;
+	atomic_init(&(new_set->duplicates), 0);
+
+	if (!parallel_for(pages_length, threads, path_set_insert_range, new_set)) {
+		path_set_destroy(new_set);
+		return NULL;
+	}
+
+	return new_set;
+}
+
+size_t path_set_find(struct PathSet *set, const char *path, size_t length) {
+	if (set == NULL || path == NULL) {
+		fprintf(stderr, "[path_set_find] Cannot search using a set or path pointer that points to NULL.\n");
+		return PATH_SET_NOT_FOUND;
+	}
+
+	while (length > 0 && *path == '/') {
+		path++;
+		length--;
+	}
+
+	unsigned long long hash = path_hash(path, length);
+	for (size_t slot = hash & set->mask; ; slot = (slot + 1) & set->mask) {
+		unsigned long long entry = atomic_load_explicit(&(set->slots[slot]), memory_order_relaxed);
+		if (entry == 0)
+			return PATH_SET_NOT_FOUND;
+
+		if ((entry >> 32) != (hash >> 32))
+			continue;
+
+		size_t page_index = (entry & 0xFFFFFFFFULL) - 1;
+		const char *other = path_key(set->pages[page_index]->path);
+		if (strncmp(other, path, length) == 0 && other[length] == '\0')
+			return page_index;
+	}
+}
+
+void path_set_destroy(struct PathSet *set) {
+	if (set == NULL) {
+		fprintf(stderr, "[path_set_destroy] Cannot free the memory of a PathSet pointer that points to NULL.\n");
+		return;
+	}
+
+	free(set->slots);
+	free(set);
+}
+
+bool link_resolve(const char *source_path, const char *href, char *resolved, size_t resolved_size) {
+	if (source_path == NULL || href == NULL || resolved == NULL || resolved_size == 0) {
+		fprintf(stderr, "[link_resolve] Cannot resolve a link using pointers that point to NULL.\n");
+		return false;
+	}
+
+	// Anything with a scheme ("https:", "mailto:") or a network path is external
+	if (href[0] == '/' && href[1] == '/')
+		return false;
+	if ((href[0] >= 'a' && href[0] <= 'z') || (href[0] >= 'A' && href[0] <= 'Z')) {
+		for (const char *character = href; *character != '\0'; character++) {
+			if (*character == ':')
+				return false;
+			if (!((*character >= 'a' && *character <= 'z') || (*character >= 'A' && *character <= 'Z') ||
+			      (*character >= '0' && *character <= '9') || *character == '+' || *character == '-' || *character == '.'))
+				break;
+		}
+	}
+
+	size_t href_length = strcspn(href, "?#");
+
+	// A bare fragment or query points at the source page itself
+	const char *base = href_length == 0 ? source_path : (href[0] == '/' ? "" : source_path);
+	size_t base_length = 0;
+	if (href_length == 0) {
+		base_length = strlen(base);
+	} else if (href[0] != '/') {
+		const char *last_slash = strrchr(base, '/');
+		base_length = last_slash == NULL ? 0 : (size_t) (last_slash - base) + 1;
+	}
+
+	// Walk base then href segment by segment, applying "." and ".."
+	size_t length = 0;
+	bool trailing_directory = false;
+	for (int part = 0; part < 2; part++) {
+		const char *segment = part == 0 ? base : href;
+		const char *end = part == 0 ? base + base_length : href + href_length;
+
+		while (segment < end) {
+			const char *segment_end = memchr(segment, '/', end - segment);
+			if (segment_end == NULL)
+				segment_end = end;
+			size_t segment_length = segment_end - segment;
+
+			trailing_directory = segment_end != end || segment_length == 0;
+			if (segment_length == 0 || (segment_length == 1 && segment[0] == '.')) {
+				trailing_directory = true;
+			} else if (segment_length == 2 && segment[0] == '.' && segment[1] == '.') {
+				while (length > 0 && resolved[length - 1] != '/')
+					length--;
+				if (length > 0)
+					length--;
+				trailing_directory = true;
+			} else {
+				if (length + segment_length + 2 > resolved_size) {
+					resolved[0] = '\0';
+					return true;
+				}
+				if (length > 0)
+					resolved[length++] = '/';
+				memcpy(resolved + length, segment, segment_length);
+				length += segment_length;
+			}
+
+			segment = segment_end < end ? segment_end + 1 : end;
+		}
+	}
+
+	// Directory links are served by their index page
+	if (trailing_directory || length == 0) {
+		static const char index_name[] = "index.html";
+		if (length + sizeof(index_name) + 1 > resolved_size) {
+			resolved[0] = '\0';
+			return true;
+		}
+		if (length > 0)
+			resolved[length++] = '/';
+		memcpy(resolved + length, index_name, sizeof(index_name) - 1);
+		length += sizeof(index_name) - 1;
+	}
+
+	resolved[length] = '\0';
+	return true;
+}
+
+struct LinkValidation {
+	struct Page **pages;
+	size_t pages_length;
+	size_t *anchor_offsets;		// anchors before each page, pages_length + 1 entries
+	struct PathSet *set;
+	struct LinkProblem **problems;	// one array per worker
+	size_t *problems_length;
+	size_t *problems_capacity;
+	atomic_bool failed;
+};
+
+static void link_validate_range(size_t start, size_t end, unsigned int worker, void *context) {
+	struct LinkValidation *validation = context;
+	if (start == end)
+		return;
+
+	// Find the page holding the first anchor of this range
+	size_t low = 0;
+	size_t high = validation->pages_length;
+	while (low + 1 < high) {
+		size_t middle = (low + high) / 2;
+		if (validation->anchor_offsets[middle] <= start)
+			low = middle;
+		else
+			high = middle;
+	}
+
+	char resolved[PATH_MAX];
+	size_t anchor = start;
+	for (size_t page_index = low; page_index < validation->pages_length && anchor < end; page_index++) {
+		size_t page_end = validation->anchor_offsets[page_index + 1];
+		if (page_end <= anchor)
+			continue;
+
+		struct Page *page = validation->pages[page_index];
+		struct GridPage *grid_page = page->page_data;
+		for (; anchor < page_end && anchor < end; anchor++) {
+			size_t anchor_index = anchor - validation->anchor_offsets[page_index];
+			if (!link_resolve(page->path, grid_page->grid_items[anchor_index].href->data, resolved, sizeof(resolved)))
+				continue;
+
+			if (path_set_find(validation->set, resolved, strlen(resolved)) != PATH_SET_NOT_FOUND)
+				continue;
+
+			// Record the dangling anchor in this worker's own list
+			if (validation->problems_length[worker] >= validation->problems_capacity[worker]) {
+				size_t new_capacity = validation->problems_capacity[worker] ? validation->problems_capacity[worker] * 2 : 64;
+				struct LinkProblem *new_problems = realloc(validation->problems[worker], sizeof(struct LinkProblem) * new_capacity);
+				if (new_problems == NULL) {
+					fprintf(stderr, "[link_validate_range] Failed to reallocate memory for %zu link problems.\n", new_capacity);
+					atomic_store(&(validation->failed), true);
+					return;
+				}
+				validation->problems[worker] = new_problems;
+				validation->problems_capacity[worker] = new_capacity;
+			}
+
+			validation->problems[worker][validation->problems_length[worker]].page_index = page_index;
+			validation->problems[worker][validation->problems_length[worker]].anchor_index = anchor_index;
+			validation->problems_length[worker]++;
+		}
+	}
+}
+
+struct LinkProblem* link_validate(struct Page **pages, size_t pages_length, unsigned int threads, size_t *problems_length) {
+	if (pages == NULL || problems_length == NULL) {
+		fprintf(stderr, "[link_validate] Cannot validate links using a pages or length pointer that points to NULL.\n");
+		return NULL;
+	}
+
+	if (threads == 0)
+		threads = parallel_default_threads();
+
+	struct LinkValidation validation = { .pages = pages, .pages_length = pages_length };
+	atomic_init(&(validation.failed), false);
+	struct LinkProblem *problems = NULL;
+
+	validation.anchor_offsets = malloc(sizeof(size_t) * (pages_length + 1));
+	validation.problems = calloc(threads, sizeof(struct LinkProblem*));
+	validation.problems_length = calloc(threads, sizeof(size_t));
+	validation.problems_capacity = calloc(threads, sizeof(size_t));
+	if (validation.anchor_offsets == NULL || validation.problems == NULL || validation.problems_length == NULL || validation.problems_capacity == NULL) {
+		fprintf(stderr, "[link_validate] Failed to allocate memory for the state of %u validation workers.\n", threads);
+		goto cleanup;
+	}
+
+	// Split the work by anchors rather than pages so one huge grid does not serialize the pass
+	validation.anchor_offsets[0] = 0;
+	for (size_t i = 0; i < pages_length; i++) {
+		size_t anchors = 0;
+		if (pages[i]->page_type == PAGETYPE_GRID_LANDING && pages[i]->page_data != NULL)
+			anchors = ((struct GridPage*) pages[i]->page_data)->grid_items_length;
+		validation.anchor_offsets[i + 1] = validation.anchor_offsets[i] + anchors;
+	}
+
+	validation.set = path_set_create(pages, pages_length, threads);
+	if (validation.set == NULL)
+		goto cleanup;
+
+	if (!parallel_for(validation.anchor_offsets[pages_length], threads, link_validate_range, &validation) || atomic_load(&(validation.failed)))
+		goto cleanup;
+
+	// Workers own contiguous anchor ranges, so concatenating keeps the order
+	size_t total = 0;
+	for (unsigned int i = 0; i < threads; i++)
+		total += validation.problems_length[i];
+
+	problems = malloc(sizeof(struct LinkProblem) * (total ? total : 1));
+	if (problems == NULL) {
+		fprintf(stderr, "[link_validate] Failed to allocate memory for %zu link problems.\n", total);
+		goto cleanup;
+	}
+
+	size_t length = 0;
+	for (unsigned int i = 0; i < threads; i++) {
+		if (validation.problems_length[i] == 0)
+			continue;
+		memcpy(problems + length, validation.problems[i], sizeof(struct LinkProblem) * validation.problems_length[i]);
+		length += validation.problems_length[i];
+	}
+	*problems_length = length;
+
+cleanup:
+	if (validation.set != NULL)
+		path_set_destroy(validation.set);
+	if (validation.problems != NULL) {
+		for (unsigned int i = 0; i < threads; i++)
+			free(validation.problems[i]);
+	}
+	free(validation.problems);
+	free(validation.problems_length);
+	free(validation.problems_capacity);
+	free(validation.anchor_offsets);
+	return problems;
+}
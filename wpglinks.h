@@ -0,0 +1,87 @@
+#ifndef wpglinks_h
+#define wpglinks_h
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stddef.h>
+#include "wpgbuffer.h"
+#include "wpglib.h"
+
+enum LinkError {
+	LINK_ERROR_NONE,
+	LINK_ERROR_NULL_POINTER,
+	LINK_ERROR_FAILED_OPEN,
+	LINK_ERROR_FAILED_WRITE,
+	LINK_ERROR_FAILED_REALLOC
+};
+
+struct LinkPair {
+	const char *target;	// site path the anchor resolves to, as given by link_resolve
+	const char *source;	// path of the page holding the anchor, borrowed from the Page
+};
+
+// Open addressing hash set of page paths that can be filled from several
+// threads at once. Each slot packs the top 32 bits of the path hash with the
+// page index + 1, so an insert is a single compare-and-swap.
+struct PathSet {
+	_Atomic unsigned long long *slots;
+	size_t mask;
+	struct Page **pages;
+	atomic_size_t duplicates;	// pages whose path was already present
+};
+
+// Streams a reverse link index out as sorted (target, source) pairs arrive.
+struct LinkIndexWriter {
+	FILE *output;
+	struct Buffer buffer;
+	struct Buffer previous_target;
+	struct Buffer previous_source;
+	size_t pairs_length;
+};
+
+// Value returned by path_set_find when the path is not in the set.
+#define PATH_SET_NOT_FOUND ((size_t) -1)
+
+struct LinkProblem {
+	size_t page_index;	// page holding the dangling anchor
+	size_t anchor_index;	// position of the anchor within that page's grid
+};
+
+// Collects a (target, page path) pair for every internal GridPage anchor of
+// pages, with the href resolved to a site path so that "page.html",
+// "./page.html" and "/dir/page.html" all name the same target. External links
+// are left out. Targets are stored in *targets and sources borrowed from the
+// pages; both the returned array and *targets must be freed with free().
+struct LinkPair* link_pairs_collect(struct Page **pages, size_t pages_length, size_t *pairs_length, char **targets);
+
+// Writes a reverse link index: one line per internal link target, sorted,
+// listing every page that links to it as "target\tsource\tsource...\n".
+enum LinkError link_index_write(struct Page **pages, size_t pages_length, char *output_path);
+
+struct LinkIndexWriter* link_index_writer_create(char *output_path);
+
+// Pairs must be added in (target, source) order; repeated pairs are dropped.
+enum LinkError link_index_writer_add(struct LinkIndexWriter *writer, const char *target, const char *source);
+
+enum LinkError link_index_writer_finish(struct LinkIndexWriter *writer);
+
+void link_index_writer_destroy(struct LinkIndexWriter *writer);
+
+struct PathSet* path_set_create(struct Page **pages, size_t pages_length, unsigned int threads);
+
+// Returns the index of the page whose path equals the first length bytes of
+// path, or PATH_SET_NOT_FOUND.
+size_t path_set_find(struct PathSet *set, const char *path, size_t length);
+
+void path_set_destroy(struct PathSet *set);
+
+// Resolves href against the page at source_path into a site relative path,
+// dropping any query or fragment and "."/".." segments. Returns false for
+// external links (those with a scheme or starting with "//").
+bool link_resolve(const char *source_path, const char *href, char *resolved, size_t resolved_size);
+
+// Checks every internal GridPage anchor against the set of generated paths in
+// parallel. Returns the dangling anchors ordered by page and position; the
+// array must be freed with free() and is NULL only on allocation failure.
+struct LinkProblem* link_validate(struct Page **pages, size_t pages_length, unsigned int threads, size_t *problems_length);
+#endif
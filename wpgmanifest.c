@@ -0,0 +1,642 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "wpgasset.h"
+#include "wpglayout.h"
+#include "wpglib.h"
+#include "wpgparallel.h"
+#include "wpgsite.h"
+#include "wpgmanifest.h"
+
+#define MANIFEST_MAX_ARGUMENTS 6
+
+struct ManifestLoadJob {
+	struct Manifest *manifest;
+	struct Page **pages;
+	atomic_int error;
+};
+
+// Reads the whole file at path into a NUL terminated heap buffer.
+static char* manifest_read_file(const char *path, size_t *length) {
+	FILE *input = fopen(path, "rb");
+	if (input == NULL) {
+		fprintf(stderr, "[manifest_read_file] Failed to open \"%s\".\n", path);
+		return NULL;
+	}
+
+	struct stat status;
+	if (fstat(fileno(input), &status) != 0 || !S_ISREG(status.st_mode)) {
+		fprintf(stderr, "[manifest_read_file] \"%s\" is not a regular file.\n", path);
+		fclose(input);
+		return NULL;
+	}
+
+	char *data = malloc((size_t) status.st_size + 1);
+	if (data == NULL) {
+		fprintf(stderr, "[manifest_read_file] Failed to allocate %lld bytes to read \"%s\".\n", (long long) status.st_size, path);
+		fclose(input);
+		return NULL;
+	}
+
+	size_t data_length = fread(data, 1, (size_t) status.st_size, input);
+	if (ferror(input)) {
+		fprintf(stderr, "[manifest_read_file] Failed to read \"%s\".\n", path);
+		free(data);
+		fclose(input);
+		return NULL;
+	}
+
+	fclose(input);
+	data[data_length] = '\0';
+	*length = data_length;
+	return data;
+}
+
+// Splits line into arguments in place, NUL terminating each one and removing
+// the quotes and backslash escapes of quoted arguments. Returns the number of
+// arguments, or -1 if there are too many or a quote is left open.
+static int manifest_split(char *line, char *end, char **arguments) {
+	int arguments_length = 0;
+	char *read = line;
+	while (true) {
+		while (read < end && (*read == ' ' || *read == '\t'))
+			read++;
+		if (read >= end)
+			return arguments_length;
+		if (arguments_length == MANIFEST_MAX_ARGUMENTS)
+			return -1;
+
+		char *write = read;
+		arguments[arguments_length++] = write;
+		if (*read == '"') {
+			read++;
+			while (read < end && *read != '"') {
+				if (*read == '\\' && read + 1 < end)
+					read++;
+				*write++ = *read++;
+			}
+			if (read >= end)
+				return -1;
+			read++;
+		} else {
+			while (read < end && *read != ' ' && *read != '\t')
+				*write++ = *read++;
+			// The terminator below lands on the separator, so step past it
+			if (read < end)
+				read++;
+		}
+		*write = '\0';
+	}
+}
+
+static bool manifest_parse_flag(char *value, bool *flag) {
+	if (strcmp(value, "yes") == 0 || strcmp(value, "true") == 0 || strcmp(value, "on") == 0)
+		*flag = true;
+	else if (strcmp(value, "no") == 0 || strcmp(value, "false") == 0 || strcmp(value, "off") == 0)
+		*flag = false;
+	else
+		return false;
+	return true;
+}
+
+// Accepts a byte count with an optional K, M or G suffix.
+static bool manifest_parse_size(char *value, size_t *size) {
+	char *suffix;
+	errno = 0;
+	unsigned long long number = strtoull(value, &suffix, 10);
+	if (errno != 0 || suffix == value || *value == '-')
+		return false;
+
+	int shift = 0;
+	if (*suffix == 'K' || *suffix == 'k')
+		shift = 10;
+	else if (*suffix == 'M' || *suffix == 'm')
+		shift = 20;
+	else if (*suffix == 'G' || *suffix == 'g')
+		shift = 30;
+	if (shift != 0)
+		suffix++;
+	if (*suffix != '\0' || number > (SIZE_MAX >> shift))
+		return false;
+
+	*size = (size_t) number << shift;
+	return true;
+}
+
+// An output path must stay inside the output directory: relative, with no
+// empty, "." or ".." segments.
+static bool manifest_valid_output_path(const char *path) {
+	if (*path == '\0' || *path == '/')
+		return false;
+
+	while (*path != '\0') {
+		const char *slash = strchr(path, '/');
+		size_t segment_length = slash != NULL ? (size_t) (slash - path) : strlen(path);
+		if (segment_length == 0 || (segment_length == 1 && path[0] == '.') || (segment_length == 2 && path[0] == '.' && path[1] == '.'))
+			return false;
+		if (slash == NULL)
+			break;
+		path = slash + 1;
+		if (*path == '\0')
+			return false;
+	}
+	return true;
+}
+
+static bool manifest_add_page(struct Manifest *manifest, char **arguments) {
+	if (manifest->pages_length >= manifest->pages_capacity) {
+		size_t new_capacity = manifest->pages_capacity * 2;
+		struct ManifestPage *new_pages = realloc(manifest->pages, sizeof(struct ManifestPage) * new_capacity);
+		if (new_pages == NULL) {
+			fprintf(stderr, "[manifest_add_page] Failed to reallocate the page index to hold %zu pages.\n", new_capacity);
+			return false;
+		}
+		manifest->pages = new_pages;
+		manifest->pages_capacity = new_capacity;
+	}
+
+	struct ManifestPage *page = &(manifest->pages[manifest->pages_length++]);
+	page->page_type = strcmp(arguments[1], "grid") == 0 ? PAGETYPE_GRID_LANDING : PAGETYPE_ARTICLE;
+	page->path = (unsigned int) (arguments[2] - manifest->text);
+	page->title = (unsigned int) (arguments[3] - manifest->text);
+	page->source = (unsigned int) (arguments[4] - manifest->text);
+	return true;
+}
+
+static bool manifest_add_asset(struct Manifest *manifest, char *path) {
+	if (manifest->assets_length >= manifest->assets_capacity) {
+		size_t new_capacity = manifest->assets_capacity * 2;
+		unsigned int *new_assets = realloc(manifest->assets, sizeof(unsigned int) * new_capacity);
+		if (new_assets == NULL) {
+			fprintf(stderr, "[manifest_add_asset] Failed to reallocate the asset index to hold %zu assets.\n", new_capacity);
+			return false;
+		}
+		manifest->assets = new_assets;
+		manifest->assets_capacity = new_capacity;
+	}
+
+	manifest->assets[manifest->assets_length++] = (unsigned int) (path - manifest->text);
+	return true;
+}
+
+// Handles one directive. Returns an error message, or NULL on success.
+static const char* manifest_directive(struct Manifest *manifest, char **arguments, int arguments_length, bool *out_of_memory) {
+	static const char *layout_directives[MANIFEST_LAYOUT_PARTIALS] = { "layout_head", "layout_header", "layout_nav", "layout_footer" };
+	char *directive = arguments[0];
+
+	if (strcmp(directive, "page") == 0) {
+		if (arguments_length != 5)
+			return "expected: page <grid|article> <path> <title> <source>";
+		if (strcmp(arguments[1], "grid") != 0 && strcmp(arguments[1], "article") != 0)
+			return "the page type must be grid or article";
+		if (!manifest_valid_output_path(arguments[2]))
+			return "the page path must be relative to the output directory, without empty, \".\" or \"..\" segments";
+		if (!manifest_add_page(manifest, arguments))
+			*out_of_memory = true;
+		return NULL;
+	}
+
+	if (strcmp(directive, "asset") == 0) {
+		if (arguments_length != 2)
+			return "expected: asset <path>";
+		if (!manifest_add_asset(manifest, arguments[1]))
+			*out_of_memory = true;
+		return NULL;
+	}
+
+	if (arguments_length != 2)
+		return "expected a directive followed by exactly one value";
+	char *value = arguments[1];
+
+	for (int partial = 0; partial < MANIFEST_LAYOUT_PARTIALS; partial++) {
+		if (strcmp(directive, layout_directives[partial]) == 0) {
+			manifest->layout_partials[partial] = value;
+			return NULL;
+		}
+	}
+
+	if (strcmp(directive, "output") == 0)
+		manifest->output_directory = value;
+	else if (strcmp(directive, "base_url") == 0)
+		manifest->base_url = value;
+	else if (strcmp(directive, "cache") == 0)
+		manifest->cache_directory = value;
+	else if (strcmp(directive, "assets") == 0)
+		manifest->asset_directory = value;
+	else if (strcmp(directive, "threads") == 0) {
+		char *end;
+		errno = 0;
+		unsigned long threads = strtoul(value, &end, 10);
+		if (errno != 0 || end == value || *end != '\0' || *value == '-' || threads > 4096)
+			return "threads must be a number from 0 to 4096";
+		manifest->threads = (unsigned int) threads;
+	} else if (strcmp(directive, "budget") == 0) {
+		if (!manifest_parse_size(value, &(manifest->memory_budget)))
+			return "budget must be a byte count with an optional K, M or G suffix";
+	} else if (strcmp(directive, "profile") == 0) {
+		char *end;
+		errno = 0;
+		unsigned long pages = strtoul(value, &end, 10);
+		if (errno != 0 || end == value || *end != '\0' || *value == '-' || pages > 10000)
+			return "profile must be the number of slowest pages to report, up to 10000";
+		manifest->profile_pages = pages;
+	} else if (strcmp(directive, "reproducible") == 0) {
+		if (!manifest_parse_flag(value, &(manifest->reproducible)))
+			return "reproducible must be yes or no";
+	} else if (strcmp(directive, "sitemap") == 0) {
+		if (!manifest_parse_flag(value, &(manifest->emit_sitemap)))
+			return "sitemap must be yes or no";
+	} else if (strcmp(directive, "link_index") == 0) {
+		if (!manifest_parse_flag(value, &(manifest->emit_link_index)))
+			return "link_index must be yes or no";
+	} else if (strcmp(directive, "search") == 0) {
+		if (!manifest_parse_flag(value, &(manifest->emit_search_index)))
+			return "search must be yes or no";
+	} else if (strcmp(directive, "validate") == 0) {
+		if (!manifest_parse_flag(value, &(manifest->validate_links)))
+			return "validate must be yes or no";
+	} else if (strcmp(directive, "navigation") == 0) {
+		if (!manifest_parse_flag(value, &(manifest->navigation)))
+			return "navigation must be yes or no";
+	} else if (strcmp(directive, "hugepages") == 0) {
+		if (!manifest_parse_flag(value, &(manifest->hugepages)))
+			return "hugepages must be yes or no";
+	} else if (strcmp(directive, "pin_threads") == 0) {
+		if (!manifest_parse_flag(value, &(manifest->pin_threads)))
+			return "pin_threads must be yes or no";
+	} else if (strcmp(directive, "minify") == 0) {
+		if (!manifest_parse_flag(value, &(manifest->minify)))
+			return "minify must be yes or no";
+	} else
+		return "unknown directive";
+
+	return NULL;
+}
+
+struct Manifest* manifest_load(char *path) {
+	if (path == NULL) {
+		fprintf(stderr, "[manifest_load] Cannot load a manifest using a path that points to NULL.\n");
+		return NULL;
+	}
+
+	struct Manifest *new_manifest = calloc(1, sizeof(struct Manifest));
+	if (new_manifest == NULL) {
+		fprintf(stderr, "[manifest_load] Failed to allocate memory for a new Manifest on the heap.\n");
+		return NULL;
+	}
+
+	new_manifest->emit_sitemap = true;
+	new_manifest->emit_link_index = true;
+	new_manifest->pages_capacity = 64;
+	new_manifest->pages = malloc(sizeof(struct ManifestPage) * new_manifest->pages_capacity);
+	new_manifest->assets_capacity = 16;
+	new_manifest->assets = malloc(sizeof(unsigned int) * new_manifest->assets_capacity);
+	char *slash = strrchr(path, '/');
+	new_manifest->directory = slash == NULL ? strdup(".") : strndup(path, slash == path ? 1 : (size_t) (slash - path));
+	if (new_manifest->pages == NULL || new_manifest->assets == NULL || new_manifest->directory == NULL) {
+		fprintf(stderr, "[manifest_load] Failed to allocate the page and asset index of the new Manifest.\n");
+		manifest_destroy(new_manifest);
+		return NULL;
+	}
+
+	new_manifest->text = manifest_read_file(path, &(new_manifest->text_length));
+	if (new_manifest->text == NULL) {
+		manifest_destroy(new_manifest);
+		return NULL;
+	}
+	if (new_manifest->text_length >= UINT_MAX) {
+		fprintf(stderr, "[manifest_load] The manifest \"%s\" is larger than the 4 GiB limit.\n", path);
+		manifest_destroy(new_manifest);
+		return NULL;
+	}
+
+	// One pass over the text: each line is cut off at its newline, split in
+	// place and recorded as offsets, so the cost is linear in the file size
+	char *line = new_manifest->text;
+	char *text_end = new_manifest->text + new_manifest->text_length;
+	size_t line_number = 0;
+	while (line < text_end) {
+		line_number++;
+		char *end = memchr(line, '\n', (size_t) (text_end - line));
+		if (end == NULL)
+			end = text_end;
+		char *next = end + 1;
+		if (end > line && end[-1] == '\r')
+			end--;
+		*end = '\0';
+
+		// Blank and comment lines are skipped before splitting, so a comment
+		// may hold any number of words and stray quotes
+		char *first = line;
+		while (first < end && (*first == ' ' || *first == '\t'))
+			first++;
+		if (first == end || *first == '#') {
+			line = next;
+			continue;
+		}
+
+		char *arguments[MANIFEST_MAX_ARGUMENTS];
+		int arguments_length = manifest_split(first, end, arguments);
+		const char *problem = NULL;
+		bool out_of_memory = false;
+		if (arguments_length < 0)
+			problem = "too many arguments or an unterminated quote";
+		else
+			problem = manifest_directive(new_manifest, arguments, arguments_length, &out_of_memory);
+
+		if (problem != NULL || out_of_memory) {
+			if (problem != NULL)
+				fprintf(stderr, "[manifest_load] %s:%zu: %s.\n", path, line_number, problem);
+			manifest_destroy(new_manifest);
+			return NULL;
+		}
+		line = next;
+	}
+
+	if (new_manifest->output_directory == NULL || new_manifest->base_url == NULL) {
+		fprintf(stderr, "[manifest_load] The manifest \"%s\" must set both output and base_url.\n", path);
+		manifest_destroy(new_manifest);
+		return NULL;
+	}
+	if (new_manifest->memory_budget > 0 && (new_manifest->validate_links || new_manifest->navigation || new_manifest->emit_search_index)) {
+		fprintf(stderr, "[manifest_load] The manifest \"%s\" streams pages under a budget, but validate, navigation and search need every page in memory.\n", path);
+		manifest_destroy(new_manifest);
+		return NULL;
+	}
+	if (new_manifest->assets_length > 0 && new_manifest->asset_directory == NULL) {
+		fprintf(stderr, "[manifest_load] The manifest \"%s\" lists assets without an assets directory.\n", path);
+		manifest_destroy(new_manifest);
+		return NULL;
+	}
+
+	return new_manifest;
+}
+
+void manifest_resolve_path(struct Manifest *manifest, const char *path, char *resolved, size_t resolved_size) {
+	if (path[0] == '/' || strcmp(manifest->directory, ".") == 0)
+		snprintf(resolved, resolved_size, "%s", path);
+	else
+		snprintf(resolved, resolved_size, "%s/%s", manifest->directory, path);
+}
+
+// Creates path and any missing parents, like mkdir -p.
+static bool manifest_make_directory(char *path) {
+	for (char *slash = path + 1; (slash = strchr(slash, '/')) != NULL; slash++) {
+		*slash = '\0';
+		bool made = mkdir(path, 0755) == 0 || errno == EEXIST;
+		*slash = '/';
+		if (!made)
+			break;
+	}
+	if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "[manifest_make_directory] Failed to create the directory \"%s\".\n", path);
+		return false;
+	}
+	return true;
+}
+
+// Adds one grid item per "href,text" line. Splits the source in place.
+static enum ManifestError manifest_fill_grid(struct GridPage *grid_page, char *source, size_t source_length, const char *path) {
+	char *line = source;
+	char *source_end = source + source_length;
+	size_t line_number = 0;
+	while (line < source_end) {
+		line_number++;
+		char *end = memchr(line, '\n', (size_t) (source_end - line));
+		if (end == NULL)
+			end = source_end;
+		char *next = end + 1;
+		if (end > line && end[-1] == '\r')
+			end--;
+		*end = '\0';
+
+		if (end > line && line[0] != '#') {
+			char *comma = memchr(line, ',', (size_t) (end - line));
+			if (comma == NULL) {
+				fprintf(stderr, "[manifest_fill_grid] %s:%zu: expected href,text.\n", path, line_number);
+				return MANIFEST_ERROR_BAD_SYNTAX;
+			}
+			*comma = '\0';
+			enum GridPageError error = grid_page_add(grid_page, line, comma + 1);
+			if (error == GRID_PAGE_ERROR_FAILED_REALLOC)
+				return MANIFEST_ERROR_FAILED_REALLOC;
+			if (error != GRID_PAGE_ERROR_NONE)
+				return MANIFEST_ERROR_BAD_SYNTAX;
+		}
+		line = next;
+	}
+	return MANIFEST_ERROR_NONE;
+}
+
+enum ManifestError manifest_load_page(struct Manifest *manifest, size_t index, struct Page **page) {
+	if (manifest == NULL || page == NULL || index >= manifest->pages_length) {
+		fprintf(stderr, "[manifest_load_page] Cannot load a page using a manifest or page pointer that points to NULL, or an index out of range.\n");
+		return MANIFEST_ERROR_NULL_POINTER;
+	}
+
+	struct ManifestPage *entry = &(manifest->pages[index]);
+	char source_path[PATH_MAX];
+	manifest_resolve_path(manifest, manifest->text + entry->source, source_path, sizeof(source_path));
+
+	size_t source_length;
+	char *source = manifest_read_file(source_path, &source_length);
+	if (source == NULL)
+		return MANIFEST_ERROR_FAILED_READ;
+
+	struct Page *new_page = page_create((enum PageType) entry->page_type, manifest->text + entry->title, manifest->text + entry->path);
+	if (new_page == NULL) {
+		free(source);
+		return MANIFEST_ERROR_FAILED_REALLOC;
+	}
+
+	// An empty article is a mistake in the input, not a lack of memory
+	enum ManifestError error = MANIFEST_ERROR_NONE;
+	if (new_page->page_type == PAGETYPE_GRID_LANDING) {
+		error = manifest_fill_grid(new_page->page_data, source, source_length, source_path);
+	} else if (source_length == 0) {
+		fprintf(stderr, "[manifest_load_page] The article source \"%s\" is empty.\n", source_path);
+		error = MANIFEST_ERROR_BAD_SYNTAX;
+	} else {
+		enum StringError body_error = article_page_set_body(new_page->page_data, source, source_length);
+		if (body_error == STRING_ERROR_FAILED_REALLOC) {
+			fprintf(stderr, "[manifest_load_page] Failed to allocate the body of \"%s\".\n", source_path);
+			error = MANIFEST_ERROR_FAILED_REALLOC;
+		} else if (body_error != STRING_ERROR_NONE) {
+			fprintf(stderr, "[manifest_load_page] The article source \"%s\" is not a valid body.\n", source_path);
+			error = MANIFEST_ERROR_BAD_SYNTAX;
+		}
+	}
+
+	free(source);
+	if (error != MANIFEST_ERROR_NONE) {
+		page_destroy(new_page);
+		return error;
+	}
+
+	*page = new_page;
+	return MANIFEST_ERROR_NONE;
+}
+
+struct Site* manifest_site_create(struct Manifest *manifest) {
+	if (manifest == NULL) {
+		fprintf(stderr, "[manifest_site_create] Cannot create a Site using a manifest that points to NULL.\n");
+		return NULL;
+	}
+
+	char path[PATH_MAX];
+	manifest_resolve_path(manifest, manifest->output_directory, path, sizeof(path));
+	if (!manifest_make_directory(path))
+		return NULL;
+	struct Site *site = site_create(path, manifest->base_url);
+	if (site == NULL)
+		return NULL;
+
+	site->threads = manifest->threads;
+	site->reproducible = manifest->reproducible;
+	site->memory_budget = manifest->memory_budget;
+	site->emit_sitemap = manifest->emit_sitemap;
+	site->emit_link_index = manifest->emit_link_index;
+	site->emit_search_index = manifest->emit_search_index;
+	site->validate_links = manifest->validate_links;
+	site->minify = manifest->minify;
+	site->navigation = manifest->navigation;
+	site->hugepages = manifest->hugepages;
+	site->profile_pages = manifest->profile_pages;
+
+	if (manifest->cache_directory != NULL) {
+		manifest_resolve_path(manifest, manifest->cache_directory, path, sizeof(path));
+		if (!manifest_make_directory(path)) {
+			site_destroy(site);
+			return NULL;
+		}
+		site->cache_directory = strdup(path);
+		if (site->cache_directory == NULL) {
+			fprintf(stderr, "[manifest_site_create] Failed to copy the cache directory of the new Site.\n");
+			site_destroy(site);
+			return NULL;
+		}
+	}
+
+	char partials[MANIFEST_LAYOUT_PARTIALS][PATH_MAX];
+	char *partial_paths[MANIFEST_LAYOUT_PARTIALS];
+	for (int partial = 0; partial < MANIFEST_LAYOUT_PARTIALS; partial++) {
+		partial_paths[partial] = NULL;
+		if (manifest->layout_partials[partial] != NULL) {
+			manifest_resolve_path(manifest, manifest->layout_partials[partial], partials[partial], PATH_MAX);
+			partial_paths[partial] = partials[partial];
+		}
+	}
+	site->layout = layout_create(partial_paths[MANIFEST_LAYOUT_HEAD], partial_paths[MANIFEST_LAYOUT_HEADER],
+				     partial_paths[MANIFEST_LAYOUT_NAV], partial_paths[MANIFEST_LAYOUT_FOOTER]);
+	if (site->layout == NULL) {
+		site_destroy(site);
+		return NULL;
+	}
+
+	if (manifest->asset_directory != NULL) {
+		manifest_resolve_path(manifest, manifest->asset_directory, path, sizeof(path));
+		site->assets = asset_set_create(path);
+		if (site->assets == NULL) {
+			site_destroy(site);
+			return NULL;
+		}
+		for (size_t i = 0; i < manifest->assets_length; i++) {
+			if (asset_set_add(site->assets, manifest->text + manifest->assets[i]) != ASSET_ERROR_NONE) {
+				site_destroy(site);
+				return NULL;
+			}
+		}
+	}
+
+	return site;
+}
+
+static void manifest_load_range(size_t start, size_t end, unsigned int worker, void *context) {
+	(void) worker;
+	struct ManifestLoadJob *job = context;
+	for (size_t i = start; i < end && atomic_load(&(job->error)) == MANIFEST_ERROR_NONE; i++) {
+		enum ManifestError error = manifest_load_page(job->manifest, i, &(job->pages[i]));
+		if (error != MANIFEST_ERROR_NONE) {
+			int expected = MANIFEST_ERROR_NONE;
+			atomic_compare_exchange_strong(&(job->error), &expected, error);
+		}
+	}
+}
+
+enum ManifestError manifest_load_pages(struct Manifest *manifest, struct Site *site) {
+	if (manifest == NULL || site == NULL) {
+		fprintf(stderr, "[manifest_load_pages] Cannot load pages using a manifest or site pointer that points to NULL.\n");
+		return MANIFEST_ERROR_NULL_POINTER;
+	}
+	if (manifest->pages_length == 0)
+		return MANIFEST_ERROR_NONE;
+
+	struct ManifestLoadJob job = { .manifest = manifest };
+	job.pages = calloc(manifest->pages_length, sizeof(struct Page*));
+	if (job.pages == NULL) {
+		fprintf(stderr, "[manifest_load_pages] Failed to allocate room for %zu pages.\n", manifest->pages_length);
+		return MANIFEST_ERROR_FAILED_REALLOC;
+	}
+	atomic_init(&(job.error), MANIFEST_ERROR_NONE);
+
+	enum ManifestError error = MANIFEST_ERROR_NONE;
+	if (!parallel_for(manifest->pages_length, site->threads, manifest_load_range, &job))
+		error = MANIFEST_ERROR_FAILED_REALLOC;
+	else
+		error = (enum ManifestError) atomic_load(&(job.error));
+
+	// Pages are added in manifest order no matter which worker loaded them
+	size_t i = 0;
+	for (; error == MANIFEST_ERROR_NONE && i < manifest->pages_length; i++) {
+		if (site_add_page(site, job.pages[i]) != SITE_ERROR_NONE)
+			error = MANIFEST_ERROR_FAILED_REALLOC;
+		else
+			job.pages[i] = NULL;
+	}
+	for (i = 0; i < manifest->pages_length; i++) {
+		if (job.pages[i] != NULL)
+			page_destroy(job.pages[i]);
+	}
+
+	free(job.pages);
+	return error;
+}
+
+static enum SiteError manifest_next_page(void *context, struct Page **page) {
+	struct Manifest *manifest = context;
+	if (manifest->pages_streamed >= manifest->pages_length) {
+		*page = NULL;
+		return SITE_ERROR_NONE;
+	}
+
+	if (manifest_load_page(manifest, manifest->pages_streamed, page) != MANIFEST_ERROR_NONE)
+		return SITE_ERROR_FAILED_SOURCE;
+	manifest->pages_streamed++;
+	return SITE_ERROR_NONE;
+}
+
+struct PageSource manifest_page_source(struct Manifest *manifest) {
+	if (manifest != NULL)
+		manifest->pages_streamed = 0;
+	struct PageSource source = { .next = manifest_next_page, .context = manifest };
+	return source;
+}
+
+void manifest_destroy(struct Manifest *manifest) {
+	if (manifest == NULL) {
+		fprintf(stderr, "[manifest_destroy] Cannot free the memory of a Manifest pointer that points to NULL.\n");
+		return;
+	}
+
+	free(manifest->text);
+	free(manifest->directory);
+	free(manifest->pages);
+	free(manifest->assets);
+	free(manifest);
+}
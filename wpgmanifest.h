@@ -0,0 +1,111 @@
+#ifndef wpgmanifest_h
+#define wpgmanifest_h
+#include <stdbool.h>
+#include <stddef.h>
+#include "wpglib.h"
+#include "wpgsite.h"
+
+// A site manifest is a line based text file. Blank lines and lines starting
+// with '#' are ignored; every other line is a directive followed by its
+// arguments, separated by spaces or tabs, with "double quotes" around
+// arguments that contain spaces:
+//
+//     output         public
+//     base_url       https://example.com
+//     threads        8
+//     cache          .wpg-cache
+//     budget         512M                 (streams pages; K, M and G suffixes; not with validate, navigation or search)
+//     reproducible   yes
+//     sitemap        yes                  (also link_index, search, validate, minify, navigation)
+//     profile        10                   (report render times and the 10 slowest pages)
+//     hugepages      yes                  (map per-worker render buffers for transparent hugepages)
+//     pin_threads    yes                  (pin worker w to processor w, so pages stay near their worker)
+//     layout_head    partials/head.html   (also layout_header, layout_nav, layout_footer)
+//     assets         static               (directory the asset lines are relative to)
+//     asset          css/site.css
+//     page  grid     index.html  "Home"   data/home.csv
+//     page  article  about.html  "About"  content/about.html
+//
+// Relative file system paths are taken from the manifest's own directory.
+// Page paths are output paths, relative to the output directory, and may not
+// start with '/' or hold empty, "." or ".." segments.
+// A grid source holds one "href,text" line per grid item; an article source
+// is the article body.
+
+enum ManifestError {
+	MANIFEST_ERROR_NONE,
+	MANIFEST_ERROR_NULL_POINTER,
+	MANIFEST_ERROR_FAILED_OPEN,
+	MANIFEST_ERROR_FAILED_READ,
+	MANIFEST_ERROR_BAD_SYNTAX,
+	MANIFEST_ERROR_FAILED_REALLOC
+};
+
+// Strings are offsets into Manifest.text, so a page entry is 16 bytes and the
+// whole manifest costs two allocations plus the page and asset arrays.
+struct ManifestPage {
+	unsigned int path;
+	unsigned int title;
+	unsigned int source;
+	unsigned int page_type;
+};
+
+enum ManifestLayoutPartial {
+	MANIFEST_LAYOUT_HEAD,
+	MANIFEST_LAYOUT_HEADER,
+	MANIFEST_LAYOUT_NAV,
+	MANIFEST_LAYOUT_FOOTER,
+	MANIFEST_LAYOUT_PARTIALS
+};
+
+struct Manifest {
+	char *text;		// the manifest file, with every argument NUL terminated in place
+	size_t text_length;
+	char *directory;
+	struct ManifestPage *pages;
+	size_t pages_length;
+	size_t pages_capacity;
+	unsigned int *assets;
+	size_t assets_length;
+	size_t assets_capacity;
+	char *output_directory;
+	char *base_url;
+	char *cache_directory;
+	char *asset_directory;
+	char *layout_partials[MANIFEST_LAYOUT_PARTIALS];
+	unsigned int threads;
+	size_t memory_budget;
+	bool reproducible;
+	bool emit_sitemap;
+	bool emit_link_index;
+	bool emit_search_index;
+	bool validate_links;
+	bool minify;
+	bool navigation;
+	bool hugepages;
+	bool pin_threads;
+	size_t profile_pages;
+	size_t pages_streamed;	// next entry manifest_page_source hands out
+};
+
+struct Manifest* manifest_load(char *path);
+
+// Resolves a path from the manifest against the manifest's directory.
+void manifest_resolve_path(struct Manifest *manifest, const char *path, char *resolved, size_t resolved_size);
+
+// Creates the Page for entry index, reading its source file.
+enum ManifestError manifest_load_page(struct Manifest *manifest, size_t index, struct Page **page);
+
+// Creates a Site configured by the manifest, with its layout and assets but
+// no pages.
+struct Site* manifest_site_create(struct Manifest *manifest);
+
+// Loads every page in parallel and adds them to site in manifest order.
+enum ManifestError manifest_load_pages(struct Manifest *manifest, struct Site *site);
+
+// A PageSource that loads the manifest's pages one at a time, for
+// site_build_streaming.
+struct PageSource manifest_page_source(struct Manifest *manifest);
+
+void manifest_destroy(struct Manifest *manifest);
+#endif
@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include "wpgbuffer.h"
+#include "wpgminify.h"
+
+// Whitespace next to these never renders, so it can be dropped rather than
+// collapsed. Inline elements such as a, b or span are deliberately missing.
+static const char *minifier_block_names[] = {
+	"!doctype", "address", "article", "aside", "base", "blockquote", "body", "br", "caption", "col", "colgroup",
+	"dd", "details", "div", "dl", "dt", "fieldset", "figcaption", "figure", "footer", "form", "h1", "h2", "h3",
+	"h4", "h5", "h6", "head", "header", "hgroup", "hr", "html", "li", "link", "main", "meta", "nav", "noscript",
+	"ol", "option", "p", "pre", "script", "section", "style", "summary", "table", "tbody", "td", "tfoot", "th",
+	"thead", "title", "tr", "ul"
+};
+
+// Elements whose contents are copied untouched.
+static const char *minifier_raw_names[] = { "pre", "script", "style", "textarea" };
+
+static bool minifier_is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static bool minifier_name_in(const char *name, const char **names, size_t names_length) {
+	for (size_t i = 0; i < names_length; i++) {
+		if (strcasecmp(name, names[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
+// Output never outgrows the input plus a held back tag name and a space, and
+// minify_append reserves that up front, so writes need no capacity checks.
+static inline void minifier_put(struct Buffer *buffer, char c) {
+	buffer->data[buffer->length++] = c;
+}
+
+// Writes out the tag name read so far and decides what the whitespace before
+// it was worth.
+static void minifier_open_tag(struct Minifier *minifier, struct Buffer *buffer) {
+	minifier->name[minifier->name_length] = '\0';
+	minifier->tag_closing = minifier->name[0] == '/';
+	minifier->tag_block = minifier_name_in(minifier->name + minifier->tag_closing, minifier_block_names,
+					       sizeof(minifier_block_names) / sizeof(minifier_block_names[0]));
+
+	if (minifier->pending_space && !minifier->after_block && !minifier->tag_block)
+		minifier_put(buffer, ' ');
+	minifier->pending_space = false;
+
+	minifier_put(buffer, '<');
+	memcpy(buffer->data + buffer->length, minifier->name, minifier->name_length);
+	buffer->length += minifier->name_length;
+}
+
+void minifier_init(struct Minifier *minifier) {
+	if (minifier == NULL) {
+		fprintf(stderr, "[minifier_init] Cannot initialize a Minifier pointer that points to NULL.\n");
+		return;
+	}
+
+	memset(minifier, 0, sizeof(struct Minifier));
+	minifier->state = MINIFIER_TEXT;
+	minifier->after_block = true;
+}
+
+enum BufferError minify_append(struct Minifier *minifier, struct Buffer *buffer, const char *data, size_t length) {
+	if (minifier == NULL || buffer == NULL || data == NULL) {
+		fprintf(stderr, "[minify_append] Cannot minify using a minifier, buffer or data pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	enum BufferError error = buffer_reserve(buffer, length + MINIFIER_NAME_MAX + 2);
+	if (error != BUFFER_ERROR_NONE)
+		return error;
+
+	for (size_t i = 0; i < length; i++) {
+		char c = data[i];
+		switch (minifier->state) {
+			case MINIFIER_TEXT:
+				if (minifier_is_space(c)) {
+					minifier->pending_space = true;
+				} else if (c == '<') {
+					minifier->state = MINIFIER_TAG_NAME;
+					minifier->name_length = 0;
+				} else {
+					if (minifier->pending_space && !minifier->after_block)
+						minifier_put(buffer, ' ');
+					minifier->pending_space = false;
+					minifier->after_block = false;
+					minifier_put(buffer, c);
+				}
+				break;
+
+			case MINIFIER_TAG_NAME:
+				if (minifier->name_length < MINIFIER_NAME_MAX - 1 &&
+				    (isalnum((unsigned char) c) ||
+				     (minifier->name_length == 0 && (c == '/' || c == '!')) ||
+				     (minifier->name_length > 0 && c == '-'))) {
+					minifier->name[minifier->name_length++] = c;
+					if (minifier->name_length == 3 && memcmp(minifier->name, "!--", 3) == 0) {
+						minifier->state = MINIFIER_COMMENT;
+						minifier->matched = 0;
+					}
+					break;
+				}
+
+				if (minifier->name_length == 0) {
+					// A lone '<' is text
+					if (minifier->pending_space && !minifier->after_block)
+						minifier_put(buffer, ' ');
+					minifier->pending_space = false;
+					minifier->after_block = false;
+					minifier_put(buffer, '<');
+					minifier->state = MINIFIER_TEXT;
+				} else {
+					minifier_open_tag(minifier, buffer);
+					minifier->state = MINIFIER_TAG;
+				}
+				i--;	// look at c again in the new state
+				break;
+
+			case MINIFIER_TAG:
+				if (minifier_is_space(c)) {
+					minifier->pending_space = true;
+					break;
+				}
+				if (c == '>') {
+					minifier_put(buffer, '>');
+					minifier->pending_space = false;
+					minifier->after_block = minifier->tag_block;
+					minifier->state = MINIFIER_TEXT;
+					if (!minifier->tag_closing && minifier_name_in(minifier->name, minifier_raw_names, sizeof(minifier_raw_names) / sizeof(minifier_raw_names[0]))) {
+						minifier->state = MINIFIER_RAW;
+						minifier->matched = 0;
+					}
+					break;
+				}
+				if (minifier->pending_space)
+					minifier_put(buffer, ' ');
+				minifier->pending_space = false;
+				minifier_put(buffer, c);
+				if (c == '"')
+					minifier->state = MINIFIER_DOUBLE_QUOTED;
+				else if (c == '\'')
+					minifier->state = MINIFIER_SINGLE_QUOTED;
+				break;
+
+			case MINIFIER_DOUBLE_QUOTED:
+				minifier_put(buffer, c);
+				if (c == '"')
+					minifier->state = MINIFIER_TAG;
+				break;
+
+			case MINIFIER_SINGLE_QUOTED:
+				minifier_put(buffer, c);
+				if (c == '\'')
+					minifier->state = MINIFIER_TAG;
+				break;
+
+			case MINIFIER_COMMENT:
+				// Whitespace around a comment still counts once the comment is gone
+				if (c == '-') {
+					if (minifier->matched < 2)
+						minifier->matched++;
+				} else if (c == '>' && minifier->matched == 2) {
+					minifier->state = MINIFIER_TEXT;
+				} else {
+					minifier->matched = 0;
+				}
+				break;
+
+			case MINIFIER_RAW: {
+				minifier_put(buffer, c);
+				// Watch for "</name" to end the element, with name as opened
+				size_t name_length = strlen(minifier->name);
+				char expected = minifier->matched == 0 ? '<' : minifier->matched == 1 ? '/' : minifier->name[minifier->matched - 2];
+				if (tolower((unsigned char) c) == tolower((unsigned char) expected)) {
+					if (++minifier->matched == name_length + 2) {
+						memmove(minifier->name + 1, minifier->name, name_length + 1);
+						minifier->name[0] = '/';
+						minifier->name_length = name_length + 1;
+						minifier->tag_closing = true;
+						minifier->tag_block = minifier_name_in(minifier->name + 1, minifier_block_names,
+										       sizeof(minifier_block_names) / sizeof(minifier_block_names[0]));
+						minifier->state = MINIFIER_TAG;
+					}
+				} else {
+					minifier->matched = c == '<' ? 1 : 0;
+				}
+				break;
+			}
+		}
+	}
+
+	return BUFFER_ERROR_NONE;
+}
+
+enum BufferError minify_append_cstring(struct Minifier *minifier, struct Buffer *buffer, const char *data) {
+	if (data == NULL) {
+		fprintf(stderr, "[minify_append_cstring] Cannot minify a char pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	return minify_append(minifier, buffer, data, strlen(data));
+}
+
+enum BufferError minify_append_escaped(struct Minifier *minifier, struct Buffer *buffer, const char *data, size_t length) {
+	if (data == NULL) {
+		fprintf(stderr, "[minify_append_escaped] Cannot minify data from a char pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	// Plain runs go through in one call; only the escaped characters are split off
+	size_t run_start = 0;
+	for (size_t i = 0; i < length; i++) {
+		const char *entity;
+		switch (data[i]) {
+			case '&':  entity = "&amp;";  break;
+			case '<':  entity = "&lt;";   break;
+			case '>':  entity = "&gt;";   break;
+			case '"':  entity = "&quot;"; break;
+			case '\'': entity = "&#39;";  break;
+			default:   continue;
+		}
+
+		enum BufferError error = minify_append(minifier, buffer, data + run_start, i - run_start);
+		if (error == BUFFER_ERROR_NONE)
+			error = minify_append_cstring(minifier, buffer, entity);
+		if (error != BUFFER_ERROR_NONE)
+			return error;
+		run_start = i + 1;
+	}
+
+	return minify_append(minifier, buffer, data + run_start, length - run_start);
+}
+
+enum BufferError minify_finish(struct Minifier *minifier, struct Buffer *buffer) {
+	if (minifier == NULL || buffer == NULL) {
+		fprintf(stderr, "[minify_finish] Cannot finish using a minifier or buffer pointer that points to NULL.\n");
+		return BUFFER_ERROR_NULL_POINTER;
+	}
+
+	if (minifier->state == MINIFIER_TAG_NAME) {
+		enum BufferError error = buffer_reserve(buffer, MINIFIER_NAME_MAX + 2);
+		if (error != BUFFER_ERROR_NONE)
+			return error;
+		if (minifier->name_length == 0) {
+			if (minifier->pending_space && !minifier->after_block)
+				minifier_put(buffer, ' ');
+			minifier_put(buffer, '<');
+		} else {
+			minifier_open_tag(minifier, buffer);
+		}
+	}
+
+	minifier_init(minifier);
+	return BUFFER_ERROR_NONE;
+}
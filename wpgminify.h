@@ -0,0 +1,52 @@
+#ifndef wpgminify_h
+#define wpgminify_h
+#include <stdbool.h>
+#include <stddef.h>
+#include "wpgbuffer.h"
+
+// Streaming HTML minifier. Bytes are filtered as they are appended, so markup
+// is minified on its way into a Buffer instead of in a second pass over it:
+//   - comments are dropped
+//   - runs of whitespace in text collapse to one space, and disappear next to
+//     block level tags where they cannot affect rendering
+//   - runs of whitespace inside tags collapse to one space, quoted attribute
+//     values are kept as they are
+//   - pre, textarea, script and style contents are copied untouched
+// Input may be split across any number of appends, at any byte.
+
+#define MINIFIER_NAME_MAX 16
+
+enum MinifierState {
+	MINIFIER_TEXT,
+	MINIFIER_TAG_NAME,
+	MINIFIER_TAG,
+	MINIFIER_DOUBLE_QUOTED,
+	MINIFIER_SINGLE_QUOTED,
+	MINIFIER_COMMENT,
+	MINIFIER_RAW
+};
+
+struct Minifier {
+	enum MinifierState state;
+	bool pending_space;	// whitespace seen but not yet known to matter
+	bool after_block;	// the last thing emitted was a block level tag, or nothing
+	bool tag_block;		// the tag being read is block level
+	bool tag_closing;
+	char name[MINIFIER_NAME_MAX];	// lowercased name of the tag being read, or of the raw text element
+	size_t name_length;
+	size_t matched;		// progress through "-->" or "</name"
+};
+
+void minifier_init(struct Minifier *minifier);
+
+enum BufferError minify_append(struct Minifier *minifier, struct Buffer *buffer, const char *data, size_t length);
+
+enum BufferError minify_append_cstring(struct Minifier *minifier, struct Buffer *buffer, const char *data);
+
+// Like buffer_append_escaped, then minified.
+enum BufferError minify_append_escaped(struct Minifier *minifier, struct Buffer *buffer, const char *data, size_t length);
+
+// Ends the input: trailing whitespace is dropped and a tag name cut off by the
+// end is written out as it was.
+enum BufferError minify_finish(struct Minifier *minifier, struct Buffer *buffer);
+#endif
@@ -0,0 +1,127 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "wpgparallel.h"
+
+struct ParallelWorker {
+	pthread_t thread;
+	size_t start;
+	size_t end;
+	unsigned int worker;
+	ParallelRangeFunction function;
+	void *context;
+	int processor;		// processor to pin to, or -1
+};
+
+static atomic_bool parallel_pinned;
+
+void parallel_pin_workers(bool pin) {
+	atomic_store(&parallel_pinned, pin);
+}
+
+// Fills processors with the processors the process may run on, in order, and
+// returns how many there are.
+static unsigned int parallel_processors(int *processors, unsigned int processors_capacity) {
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+		return 0;
+
+	unsigned int processors_length = 0;
+	for (int cpu = 0; cpu < CPU_SETSIZE && processors_length < processors_capacity; cpu++) {
+		if (CPU_ISSET(cpu, &allowed))
+			processors[processors_length++] = cpu;
+	}
+	return processors_length;
+}
+
+static void parallel_pin(pthread_t thread, int processor) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(processor, &set);
+	if (pthread_setaffinity_np(thread, sizeof(set), &set) != 0)
+		fprintf(stderr, "[parallel_pin] Failed to pin a worker to processor %d.\n", processor);
+}
+
+static void* parallel_worker_run(void *argument) {
+	struct ParallelWorker *worker = argument;
+	if (worker->processor >= 0)
+		parallel_pin(pthread_self(), worker->processor);
+	worker->function(worker->start, worker->end, worker->worker, worker->context);
+	return NULL;
+}
+
+unsigned int parallel_default_threads() {
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	if (processors < 1)
+		return 1;
+	return (unsigned int) processors;
+}
+
+bool parallel_for(size_t length, unsigned int threads, ParallelRangeFunction function, void *context) {
+	if (function == NULL) {
+		fprintf(stderr, "[parallel_for] Cannot run a function pointer that points to NULL.\n");
+		return false;
+	}
+
+	if (threads == 0)
+		threads = parallel_default_threads();
+
+	// Run small or single threaded jobs inline
+	if (threads == 1 || length < 2) {
+		function(0, length, 0, context);
+		return true;
+	}
+
+	struct ParallelWorker *workers = malloc(sizeof(struct ParallelWorker) * threads);
+	if (workers == NULL) {
+		fprintf(stderr, "[parallel_for] Failed to allocate memory for %u workers.\n", threads);
+		return false;
+	}
+
+	int processors[CPU_SETSIZE];
+	unsigned int processors_length = atomic_load(&parallel_pinned) ? parallel_processors(processors, CPU_SETSIZE) : 0;
+
+	// The calling thread gets its own affinity back once its range is done
+	cpu_set_t caller_affinity;
+	bool caller_pinned = processors_length > 0 && pthread_getaffinity_np(pthread_self(), sizeof(caller_affinity), &caller_affinity) == 0;
+
+	unsigned int started = 0;
+	bool success = true;
+	for (unsigned int i = 0; i < threads; i++) {
+		workers[i].start = (length * i) / threads;
+		workers[i].end = (length * (i + 1)) / threads;
+		workers[i].worker = i;
+		workers[i].function = function;
+		workers[i].context = context;
+		workers[i].processor = processors_length > 0 ? processors[i % processors_length] : -1;
+		if (i == threads - 1 && !caller_pinned)
+			workers[i].processor = -1;
+
+		// The calling thread takes the last range itself
+		if (i == threads - 1)
+			break;
+
+		if (pthread_create(&(workers[i].thread), NULL, parallel_worker_run, &(workers[i])) != 0) {
+			fprintf(stderr, "[parallel_for] Failed to start worker thread %u.\n", i);
+			success = false;
+			break;
+		}
+		started++;
+	}
+
+	if (success)
+		parallel_worker_run(&(workers[threads - 1]));
+	if (caller_pinned)
+		pthread_setaffinity_np(pthread_self(), sizeof(caller_affinity), &caller_affinity);
+
+	for (unsigned int i = 0; i < started; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	free(workers);
+	return success;
+}
@@ -0,0 +1,23 @@
+#ifndef wpgparallel_h
+#define wpgparallel_h
+#include <stdbool.h>
+#include <stddef.h>
+
+// Called once per worker with the half-open range [start, end) it owns.
+typedef void (*ParallelRangeFunction)(size_t start, size_t end, unsigned int worker, void *context);
+
+// Number of online processors, or 1 if it cannot be determined.
+unsigned int parallel_default_threads();
+
+// Splits [0, length) into threads contiguous ranges and runs function over each
+// on its own thread, returning once all of them finish. Range boundaries only
+// depend on length and threads, so worker w always owns the same items.
+bool parallel_for(size_t length, unsigned int threads, ParallelRangeFunction function, void *context);
+
+// Pins worker w of every later parallel_for to the w-th processor the process
+// may run on, wrapping around if there are more workers than processors. With
+// boundaries fixed, the worker that first touches an item's memory is then
+// the one on the same NUMA node every time the item is visited again. Off by
+// default.
+void parallel_pin_workers(bool pin);
+#endif
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "wpgparallel.h"
+#include "wpgprofile.h"
+
+#define PROFILE_BAR_WIDTH 40
+
+struct Profile* profile_create(unsigned int threads, size_t top) {
+	struct Profile *new_profile = calloc(1, sizeof(struct Profile));
+	if (new_profile == NULL) {
+		fprintf(stderr, "[profile_create] Failed to allocate memory for a new Profile on the heap.\n");
+		return NULL;
+	}
+
+	new_profile->workers_length = threads != 0 ? threads : parallel_default_threads();
+	new_profile->top = top;
+	new_profile->workers = aligned_alloc(64, sizeof(struct ProfileWorker) * new_profile->workers_length);
+	if (new_profile->workers == NULL) {
+		fprintf(stderr, "[profile_create] Failed to allocate %u worker slots for the new Profile.\n", new_profile->workers_length);
+		free(new_profile);
+		return NULL;
+	}
+	memset(new_profile->workers, 0, sizeof(struct ProfileWorker) * new_profile->workers_length);
+
+	for (unsigned int w = 0; w < new_profile->workers_length; w++) {
+		if (top == 0)
+			continue;
+		new_profile->workers[w].slowest = malloc(sizeof(struct ProfileSample) * top);
+		if (new_profile->workers[w].slowest == NULL) {
+			fprintf(stderr, "[profile_create] Failed to allocate the slowest page list of worker %u.\n", w);
+			profile_destroy(new_profile);
+			return NULL;
+		}
+	}
+
+	return new_profile;
+}
+
+unsigned long long profile_clock() {
+	// CLOCK_MONOTONIC is answered from the vDSO off the timestamp counter, so
+	// this costs about as much as reading the counter and converting it here
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long) now.tv_sec * 1000000000ULL + (unsigned long long) now.tv_nsec;
+}
+
+// Values below 8 get a bucket each; above that each power of two is split
+// into eight equal sub-buckets.
+static size_t profile_bucket(unsigned long long nanoseconds) {
+	if (nanoseconds < 8)
+		return (size_t) nanoseconds;
+	int top_bit = 63 - __builtin_clzll(nanoseconds);
+	return (size_t) (top_bit - 2) * 8 + ((nanoseconds >> (top_bit - 3)) & 7);
+}
+
+static unsigned long long profile_bucket_start(size_t bucket) {
+	if (bucket < 8)
+		return bucket;
+	int top_bit = (int) (bucket / 8) + 2;
+	return (8ULL + bucket % 8) << (top_bit - 3);
+}
+
+// Midpoint of the bucket, used as the estimate for anything that landed in it.
+static unsigned long long profile_bucket_value(size_t bucket) {
+	if (bucket < 8)
+		return bucket;
+	int top_bit = (int) (bucket / 8) + 2;
+	return profile_bucket_start(bucket) + (1ULL << (top_bit - 3)) / 2;
+}
+
+void profile_record(struct Profile *profile, unsigned int worker, const char *path, unsigned long long nanoseconds, size_t output_bytes, size_t buffer_growths) {
+	if (profile == NULL || path == NULL || worker >= profile->workers_length)
+		return;
+
+	struct ProfileWorker *slot = &(profile->workers[worker]);
+	slot->histogram[profile_bucket(nanoseconds)]++;
+	slot->pages++;
+	slot->nanoseconds += nanoseconds;
+	slot->output_bytes += output_bytes;
+	slot->buffer_growths += buffer_growths;
+
+	// Most pages are faster than the current slowest few and stop here
+	if (profile->top == 0 || (slot->slowest_length == profile->top && nanoseconds <= slot->slowest[0].nanoseconds))
+		return;
+
+	size_t position;
+	if (slot->slowest_length < profile->top) {
+		position = slot->slowest_length++;
+	} else {
+		position = 0;
+	}
+	// Sink or shift into place, keeping the list ordered fastest first
+	while (position > 0 && slot->slowest[position - 1].nanoseconds > nanoseconds) {
+		slot->slowest[position] = slot->slowest[position - 1];
+		position--;
+	}
+	while (position + 1 < slot->slowest_length && slot->slowest[position + 1].nanoseconds < nanoseconds) {
+		slot->slowest[position] = slot->slowest[position + 1];
+		position++;
+	}
+
+	struct ProfileSample *sample = &(slot->slowest[position]);
+	sample->nanoseconds = nanoseconds;
+	sample->output_bytes = output_bytes;
+	sample->buffer_growths = buffer_growths;
+	snprintf(sample->path, sizeof(sample->path), "%s", path);
+}
+
+static void profile_format_duration(unsigned long long nanoseconds, char *text, size_t text_size) {
+	if (nanoseconds < 1000ULL)
+		snprintf(text, text_size, "%llu ns", nanoseconds);
+	else if (nanoseconds < 1000000ULL)
+		snprintf(text, text_size, "%.1f us", nanoseconds / 1e3);
+	else if (nanoseconds < 1000000000ULL)
+		snprintf(text, text_size, "%.2f ms", nanoseconds / 1e6);
+	else
+		snprintf(text, text_size, "%.2f s", nanoseconds / 1e9);
+}
+
+static int profile_sample_compare(const void *a, const void *b) {
+	const struct ProfileSample *first = a;
+	const struct ProfileSample *second = b;
+	if (first->nanoseconds != second->nanoseconds)
+		return first->nanoseconds < second->nanoseconds ? 1 : -1;
+	return strcmp(first->path, second->path);
+}
+
+// Returns the estimated latency below which fraction of the pages fall.
+static unsigned long long profile_percentile(unsigned long long *histogram, size_t pages, double fraction) {
+	unsigned long long rank = (unsigned long long) (fraction * (double) pages);
+	if (rank >= pages)
+		rank = pages - 1;
+	unsigned long long seen = 0;
+	for (size_t bucket = 0; bucket < PROFILE_BUCKETS; bucket++) {
+		seen += histogram[bucket];
+		if (seen > rank)
+			return profile_bucket_value(bucket);
+	}
+	return 0;
+}
+
+void profile_report(struct Profile *profile, FILE *output) {
+	if (profile == NULL || output == NULL) {
+		fprintf(stderr, "[profile_report] Cannot report using a profile or output pointer that points to NULL.\n");
+		return;
+	}
+
+	unsigned long long histogram[PROFILE_BUCKETS] = {0};
+	size_t pages = 0, output_bytes = 0, buffer_growths = 0, samples_length = 0;
+	unsigned long long nanoseconds = 0;
+	for (unsigned int w = 0; w < profile->workers_length; w++) {
+		struct ProfileWorker *slot = &(profile->workers[w]);
+		for (size_t bucket = 0; bucket < PROFILE_BUCKETS; bucket++)
+			histogram[bucket] += slot->histogram[bucket];
+		pages += slot->pages;
+		nanoseconds += slot->nanoseconds;
+		output_bytes += slot->output_bytes;
+		buffer_growths += slot->buffer_growths;
+		samples_length += slot->slowest_length;
+	}
+
+	char total[32], p50[32], p90[32], p99[32];
+	profile_format_duration(nanoseconds, total, sizeof(total));
+	fprintf(output, "Render profile: %zu pages, %s of render time, %zu bytes written, %zu buffer growths\n", pages, total, output_bytes, buffer_growths);
+	if (pages == 0)
+		return;
+
+	profile_format_duration(profile_percentile(histogram, pages, 0.50), p50, sizeof(p50));
+	profile_format_duration(profile_percentile(histogram, pages, 0.90), p90, sizeof(p90));
+	profile_format_duration(profile_percentile(histogram, pages, 0.99), p99, sizeof(p99));
+	fprintf(output, "  p50 %s, p90 %s, p99 %s\n", p50, p90, p99);
+
+	// The histogram is printed one row per power of two
+	unsigned long long rows[64] = {0};
+	int first_row = 64, last_row = -1;
+	unsigned long long largest_row = 0;
+	for (size_t bucket = 0; bucket < PROFILE_BUCKETS; bucket++) {
+		if (histogram[bucket] == 0)
+			continue;
+		unsigned long long start = profile_bucket_start(bucket);
+		int row = start == 0 ? 0 : 63 - __builtin_clzll(start);
+		rows[row] += histogram[bucket];
+		if (row < first_row)
+			first_row = row;
+		if (row > last_row)
+			last_row = row;
+	}
+	for (int row = first_row; row <= last_row; row++) {
+		if (rows[row] > largest_row)
+			largest_row = rows[row];
+	}
+	for (int row = first_row; row <= last_row; row++) {
+		char below[32];
+		profile_format_duration(2ULL << row, below, sizeof(below));
+		int bar = (int) ((rows[row] * PROFILE_BAR_WIDTH + largest_row - 1) / largest_row);
+		fprintf(output, "  < %10s %8llu %.*s\n", below, rows[row], bar, "########################################");
+	}
+
+	if (samples_length == 0)
+		return;
+
+	struct ProfileSample *samples = malloc(sizeof(struct ProfileSample) * samples_length);
+	if (samples == NULL) {
+		fprintf(stderr, "[profile_report] Failed to allocate room to merge %zu slow pages.\n", samples_length);
+		return;
+	}
+	size_t merged = 0;
+	for (unsigned int w = 0; w < profile->workers_length; w++) {
+		memcpy(samples + merged, profile->workers[w].slowest, sizeof(struct ProfileSample) * profile->workers[w].slowest_length);
+		merged += profile->workers[w].slowest_length;
+	}
+	qsort(samples, samples_length, sizeof(struct ProfileSample), profile_sample_compare);
+
+	size_t shown = samples_length < profile->top ? samples_length : profile->top;
+	fprintf(output, "  Slowest %zu pages:\n", shown);
+	for (size_t i = 0; i < shown; i++) {
+		char duration[32];
+		profile_format_duration(samples[i].nanoseconds, duration, sizeof(duration));
+		fprintf(output, "  %10s %10zu bytes %4zu buffer growths  %s\n", duration, samples[i].output_bytes, samples[i].buffer_growths, samples[i].path);
+	}
+
+	free(samples);
+}
+
+void profile_destroy(struct Profile *profile) {
+	if (profile == NULL) {
+		fprintf(stderr, "[profile_destroy] Cannot free the memory of a Profile pointer that points to NULL.\n");
+		return;
+	}
+
+	if (profile->workers != NULL) {
+		for (unsigned int w = 0; w < profile->workers_length; w++)
+			free(profile->workers[w].slowest);
+		free(profile->workers);
+	}
+	free(profile);
+}
@@ -0,0 +1,51 @@
+#ifndef wpgprofile_h
+#define wpgprofile_h
+#include <stdio.h>
+#include <stddef.h>
+
+// Optional per-page render profiling. Each worker records into its own slot,
+// so recording a page takes no locks and touches no shared cache lines; the
+// slots are only merged when the report is written.
+
+#define PROFILE_PATH_MAX 256
+// Eight sub-buckets per power of two keeps percentiles within 12.5%
+#define PROFILE_BUCKETS (62 * 8)
+
+struct ProfileSample {
+	unsigned long long nanoseconds;
+	size_t output_bytes;
+	size_t buffer_growths;		// as counted by buffer_growths()
+	char path[PROFILE_PATH_MAX];	// truncated if longer
+};
+
+struct ProfileWorker {
+	unsigned long long histogram[PROFILE_BUCKETS];
+	struct ProfileSample *slowest;	// ordered fastest first
+	size_t slowest_length;
+	size_t pages;
+	unsigned long long nanoseconds;
+	size_t output_bytes;
+	size_t buffer_growths;
+} __attribute__((aligned(64)));
+
+struct Profile {
+	struct ProfileWorker *workers;
+	unsigned int workers_length;
+	size_t top;		// how many of the slowest pages to report
+};
+
+// threads is the count later passed to the renderer; 0 uses every online
+// processor, as parallel_for does.
+struct Profile* profile_create(unsigned int threads, size_t top);
+
+// A monotonic timestamp in nanoseconds, cheap enough to take twice per page.
+unsigned long long profile_clock();
+
+void profile_record(struct Profile *profile, unsigned int worker, const char *path, unsigned long long nanoseconds, size_t output_bytes, size_t buffer_growths);
+
+// Writes totals, p50/p90/p99 latencies, a latency histogram and the slowest
+// pages to output.
+void profile_report(struct Profile *profile, FILE *output);
+
+void profile_destroy(struct Profile *profile);
+#endif
@@ -0,0 +1,349 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "wpgbuffer.h"
+#include "wpggraph.h"
+#include "wpglayout.h"
+#include "wpglib.h"
+#include "wpgminify.h"
+#include "wpgparallel.h"
+#include "wpgprofile.h"
+#include "wpgrender.h"
+#include "wpgsearch.h"
+
+// A hugepage-backed output buffer starts at one hugepage.
+#define RENDER_HUGEPAGE_BYTES (2 * 1024 * 1024)
+
+// Backlinks listed per article; heavily linked pages would otherwise list thousands.
+#define RENDER_BACKLINKS_MAX 20
+
+struct RenderJob {
+	struct Page **pages;
+	struct Layout *layout;
+	char *output_directory;
+	struct Profile *profile;	// NULL unless profiling
+	struct LinkGraph *graph;	// NULL unless rendering backlinks and related pages
+	struct SearchIndex *search;	// NULL unless building the search index
+	bool hugepages;
+	atomic_int error;	// first RenderError hit by any worker
+};
+
+// Markup goes straight into output, or through minifier on its way there when
+// minifying.
+static bool render_emit(struct Minifier *minifier, struct Buffer *output, const char *data, size_t length) {
+	if (minifier != NULL)
+		return minify_append(minifier, output, data, length) == BUFFER_ERROR_NONE;
+	return buffer_append(output, data, length) == BUFFER_ERROR_NONE;
+}
+
+static bool render_emit_cstring(struct Minifier *minifier, struct Buffer *output, const char *data) {
+	return render_emit(minifier, output, data, strlen(data));
+}
+
+static bool render_emit_escaped(struct Minifier *minifier, struct Buffer *output, const char *data, size_t length) {
+	if (minifier != NULL)
+		return minify_append_escaped(minifier, output, data, length) == BUFFER_ERROR_NONE;
+	return buffer_append_escaped(output, data, length) == BUFFER_ERROR_NONE;
+}
+
+static bool render_append_grid(struct GridPage *grid_page, struct Minifier *minifier, struct Buffer *output) {
+	if (!render_emit_cstring(minifier, output, "<ul class=\"grid\">\n"))
+		return false;
+
+	for (size_t i = 0; i < grid_page->grid_items_length; i++) {
+		struct AnchorTag *anchor_tag = &(grid_page->grid_items[i]);
+		if (!render_emit_cstring(minifier, output, "<li><a href=\"") ||
+		    !render_emit_escaped(minifier, output, anchor_tag->href->data, anchor_tag->href->length) ||
+		    !render_emit_cstring(minifier, output, "\">") ||
+		    !render_emit_escaped(minifier, output, anchor_tag->text->data, anchor_tag->text->length) ||
+		    !render_emit_cstring(minifier, output, "</a></li>\n"))
+			return false;
+	}
+
+	return render_emit_cstring(minifier, output, "</ul>\n");
+}
+
+enum RenderError render_page_content(struct Page *page, struct Buffer *output, size_t *body_offset, bool minify) {
+	if (page == NULL || output == NULL || body_offset == NULL) {
+		fprintf(stderr, "[render_page_content] Cannot render using pointers that point to NULL.\n");
+		return RENDER_ERROR_NULL_POINTER;
+	}
+
+	// The title and the body are minified separately since the layout goes between them
+	struct Minifier minifier_state;
+	struct Minifier *minifier = NULL;
+	if (minify) {
+		minifier = &minifier_state;
+		minifier_init(minifier);
+	}
+
+	size_t title_length = strlen(page->title);
+	bool success = render_emit_escaped(minifier, output, page->title, title_length) &&
+		(minifier == NULL || minify_finish(minifier, output) == BUFFER_ERROR_NONE);
+
+	*body_offset = output->length;
+	success = success &&
+		render_emit_cstring(minifier, output, "<h1>") &&
+		render_emit_escaped(minifier, output, page->title, title_length) &&
+		render_emit_cstring(minifier, output, "</h1>\n");
+
+	if (success) {
+		switch (page->page_type) {
+			case PAGETYPE_GRID_LANDING:
+				success = render_append_grid(page->page_data, minifier, output);
+				break;
+
+			case PAGETYPE_ARTICLE:
+				// Article bodies are authored HTML and are emitted as is
+				success = render_emit_cstring(minifier, output, "<article>\n") &&
+					render_emit(minifier, output, ((struct ArticlePage*) page->page_data)->body->data, ((struct ArticlePage*) page->page_data)->body->length) &&
+					render_emit_cstring(minifier, output, "\n</article>\n");
+				break;
+
+			default:
+				fprintf(stderr, "[render_page_content] PageType code %d of page \"%s\" is invalid or unimplemented.\n", page->page_type, page->path);
+				return RENDER_ERROR_BAD_PAGE_TYPE;
+		}
+	}
+
+	if (success && minifier != NULL)
+		success = minify_finish(minifier, output) == BUFFER_ERROR_NONE;
+
+	if (!success) {
+		fprintf(stderr, "[render_page_content] Failed to grow the output buffer while rendering \"%s\".\n", page->path);
+		return RENDER_ERROR_FAILED_REALLOC;
+	}
+
+	return RENDER_ERROR_NONE;
+}
+
+static bool render_append_page_list(struct Page **pages, const unsigned int *indices, size_t indices_length, const char *class_name, const char *heading,
+				    struct Minifier *minifier, struct Buffer *output) {
+	if (indices_length == 0)
+		return true;
+
+	if (!render_emit_cstring(minifier, output, "<aside class=\"") ||
+	    !render_emit_cstring(minifier, output, class_name) ||
+	    !render_emit_cstring(minifier, output, "\">\n<h2>") ||
+	    !render_emit_cstring(minifier, output, heading) ||
+	    !render_emit_cstring(minifier, output, "</h2>\n<ul>\n"))
+		return false;
+
+	for (size_t i = 0; i < indices_length; i++) {
+		// Skip repeats; backlinks from one grid sit next to each other
+		if (i > 0 && indices[i] == indices[i - 1])
+			continue;
+
+		struct Page *page = pages[indices[i]];
+		const char *path = page->path;
+		while (*path == '/')
+			path++;
+		if (!render_emit_cstring(minifier, output, "<li><a href=\"/") ||
+		    !render_emit_escaped(minifier, output, path, strlen(path)) ||
+		    !render_emit_cstring(minifier, output, "\">") ||
+		    !render_emit_escaped(minifier, output, page->title, strlen(page->title)) ||
+		    !render_emit_cstring(minifier, output, "</a></li>\n"))
+			return false;
+	}
+
+	return render_emit_cstring(minifier, output, "</ul>\n</aside>\n");
+}
+
+// Appends the backlink and related sections of an article from the link graph.
+static bool render_append_navigation(struct LinkGraph *graph, struct Page **pages, size_t page_index, bool minify, struct Buffer *output) {
+	if (pages[page_index]->page_type != PAGETYPE_ARTICLE)
+		return true;
+
+	struct Minifier minifier_state;
+	struct Minifier *minifier = NULL;
+	if (minify) {
+		minifier = &minifier_state;
+		minifier_init(minifier);
+	}
+
+	size_t backlinks_start = graph->in_offsets[page_index];
+	size_t backlinks_length = graph->in_offsets[page_index + 1] - backlinks_start;
+	if (backlinks_length > RENDER_BACKLINKS_MAX)
+		backlinks_length = RENDER_BACKLINKS_MAX;
+
+	return render_append_page_list(pages, graph->in_sources + backlinks_start, backlinks_length, "backlinks", "Linked from", minifier, output) &&
+		render_append_page_list(pages, graph->related + page_index * LINK_GRAPH_RELATED_MAX, graph->related_length[page_index], "related", "Related", minifier, output) &&
+		(minifier == NULL || minify_finish(minifier, output) == BUFFER_ERROR_NONE);
+}
+
+int render_open_file(char *output_directory, char *path) {
+	if (output_directory == NULL || path == NULL) {
+		fprintf(stderr, "[render_open_file] Cannot open a file using an output directory or path that points to NULL.\n");
+		return -1;
+	}
+
+	while (*path == '/')
+		path++;
+
+	char file_path[PATH_MAX];
+	int file_path_length = snprintf(file_path, sizeof(file_path), "%s/%s", output_directory, path);
+	if (file_path_length < 0 || (size_t) file_path_length >= sizeof(file_path)) {
+		fprintf(stderr, "[render_open_file] The output path for \"%s\" is too long.\n", path);
+		return -1;
+	}
+
+	// Create each missing parent directory in turn
+	for (char *slash = file_path + strlen(output_directory) + 1; (slash = strchr(slash, '/')) != NULL; slash++) {
+		*slash = '\0';
+		if (mkdir(file_path, 0755) != 0 && errno != EEXIST) {
+			fprintf(stderr, "[render_open_file] Failed to create the directory \"%s\".\n", file_path);
+			return -1;
+		}
+		*slash = '/';
+	}
+
+	int descriptor = open(file_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (descriptor < 0)
+		fprintf(stderr, "[render_open_file] Failed to open \"%s\" for writing.\n", file_path);
+	return descriptor;
+}
+
+// Writes every iovec in full, resuming after short writes.
+static bool render_write_vectors(int descriptor, struct iovec *vectors, int vectors_length) {
+	while (vectors_length > 0) {
+		ssize_t written = writev(descriptor, vectors, vectors_length);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		while (vectors_length > 0 && (size_t) written >= vectors->iov_len) {
+			written -= vectors->iov_len;
+			vectors++;
+			vectors_length--;
+		}
+		if (vectors_length > 0) {
+			vectors->iov_base = (char*) vectors->iov_base + written;
+			vectors->iov_len -= written;
+		}
+	}
+
+	return true;
+}
+
+enum RenderError render_write_page(char *output_directory, char *path, struct Layout *layout, struct Buffer *content, size_t body_offset) {
+	if (output_directory == NULL || path == NULL || layout == NULL || content == NULL) {
+		fprintf(stderr, "[render_write_page] Cannot write a page using pointers that point to NULL.\n");
+		return RENDER_ERROR_NULL_POINTER;
+	}
+
+	int descriptor = render_open_file(output_directory, path);
+	if (descriptor < 0)
+		return RENDER_ERROR_FAILED_OPEN;
+
+	struct iovec vectors[5] = {
+		{ (void*) layout->prefix, layout->prefix_length },
+		{ content->data, body_offset },
+		{ layout->head.data, layout->head.length },
+		{ content->data + body_offset, content->length - body_offset },
+		{ layout->tail.data, layout->tail.length }
+	};
+
+	enum RenderError error = RENDER_ERROR_NONE;
+	if (!render_write_vectors(descriptor, vectors, 5))
+		error = RENDER_ERROR_FAILED_WRITE;
+	if (close(descriptor) != 0)
+		error = RENDER_ERROR_FAILED_WRITE;
+	if (error != RENDER_ERROR_NONE)
+		fprintf(stderr, "[render_write_page] Failed to write page \"%s\".\n", path);
+
+	return error;
+}
+
+enum RenderError render_write_file(char *output_directory, char *path, const char *data, size_t length) {
+	if (output_directory == NULL || path == NULL || data == NULL) {
+		fprintf(stderr, "[render_write_file] Cannot write a file using pointers that point to NULL.\n");
+		return RENDER_ERROR_NULL_POINTER;
+	}
+
+	int descriptor = render_open_file(output_directory, path);
+	if (descriptor < 0)
+		return RENDER_ERROR_FAILED_OPEN;
+
+	struct iovec vector = { (void*) data, length };
+	enum RenderError error = RENDER_ERROR_NONE;
+	if (!render_write_vectors(descriptor, &vector, 1))
+		error = RENDER_ERROR_FAILED_WRITE;
+	if (close(descriptor) != 0)
+		error = RENDER_ERROR_FAILED_WRITE;
+	if (error != RENDER_ERROR_NONE)
+		fprintf(stderr, "[render_write_file] Failed to write %zu bytes to \"%s\".\n", length, path);
+
+	return error;
+}
+
+static void render_pages_range(size_t start, size_t end, unsigned int worker, void *context) {
+	struct RenderJob *job = context;
+
+	struct Buffer output;
+	enum BufferError buffer_error = job->hugepages ? buffer_init_mapped(&output, RENDER_HUGEPAGE_BYTES, true) : buffer_init(&output, 64 * 1024);
+	if (buffer_error != BUFFER_ERROR_NONE) {
+		atomic_store(&(job->error), RENDER_ERROR_FAILED_REALLOC);
+		return;
+	}
+
+	for (size_t i = start; i < end && atomic_load_explicit(&(job->error), memory_order_relaxed) == RENDER_ERROR_NONE; i++) {
+		unsigned long long started = 0;
+		size_t growths = 0;
+		if (job->profile != NULL) {
+			started = profile_clock();
+			growths = buffer_growths();
+		}
+
+		buffer_clear(&output);
+		size_t body_offset = 0;
+		enum RenderError error = render_page_content(job->pages[i], &output, &body_offset, job->layout->minified);
+		if (error == RENDER_ERROR_NONE && job->graph != NULL && !render_append_navigation(job->graph, job->pages, i, job->layout->minified, &output))
+			error = RENDER_ERROR_FAILED_REALLOC;
+		if (error == RENDER_ERROR_NONE)
+			error = render_write_page(job->output_directory, job->pages[i]->path, job->layout, &output, body_offset);
+		if (error == RENDER_ERROR_NONE && job->search != NULL && search_index_add(job->search, worker, job->pages[i], i) != SEARCH_ERROR_NONE)
+			error = RENDER_ERROR_FAILED_REALLOC;
+
+		if (job->profile != NULL && error == RENDER_ERROR_NONE) {
+			size_t written = job->layout->prefix_length + job->layout->head.length + output.length + job->layout->tail.length;
+			profile_record(job->profile, worker, job->pages[i]->path, profile_clock() - started, written, buffer_growths() - growths);
+		}
+
+		if (error != RENDER_ERROR_NONE) {
+			int expected = RENDER_ERROR_NONE;
+			atomic_compare_exchange_strong(&(job->error), &expected, error);
+		}
+	}
+
+	buffer_free(&output);
+}
+
+enum RenderError render_pages(struct Page **pages, size_t pages_length, struct Layout *layout, unsigned int threads, char *output_directory, struct Profile *profile, struct LinkGraph *graph, struct SearchIndex *search, bool hugepages) {
+	if (pages == NULL || layout == NULL || output_directory == NULL) {
+		fprintf(stderr, "[render_pages] Cannot render using a pages, layout or output directory pointer that points to NULL.\n");
+		return RENDER_ERROR_NULL_POINTER;
+	}
+
+	if (mkdir(output_directory, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "[render_pages] Failed to create the output directory \"%s\".\n", output_directory);
+		return RENDER_ERROR_FAILED_OPEN;
+	}
+
+	struct RenderJob job = { .pages = pages, .layout = layout, .output_directory = output_directory, .profile = profile, .graph = graph, .search = search, .hugepages = hugepages };
+	atomic_init(&(job.error), RENDER_ERROR_NONE);
+
+	if (!parallel_for(pages_length, threads, render_pages_range, &job))
+		return RENDER_ERROR_FAILED_REALLOC;
+
+	return atomic_load(&(job.error));
+}
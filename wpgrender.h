@@ -0,0 +1,50 @@
+#ifndef wpgrender_h
+#define wpgrender_h
+#include <stdbool.h>
+#include <stddef.h>
+#include "wpgbuffer.h"
+#include "wpggraph.h"
+#include "wpglayout.h"
+#include "wpglib.h"
+#include "wpgprofile.h"
+#include "wpgsearch.h"
+
+enum RenderError {
+	RENDER_ERROR_NONE,
+	RENDER_ERROR_NULL_POINTER,
+	RENDER_ERROR_BAD_PAGE_TYPE,
+	RENDER_ERROR_FAILED_REALLOC,
+	RENDER_ERROR_FAILED_OPEN,
+	RENDER_ERROR_FAILED_WRITE
+};
+
+// Appends only the page specific markup to output: the escaped title, then the
+// body. *body_offset is set to where the body starts within output. With minify
+// the markup is minified as it is appended.
+enum RenderError render_page_content(struct Page *page, struct Buffer *output, size_t *body_offset, bool minify);
+
+// Writes a page rendered by render_page_content to <output_directory>/<path>,
+// gathering the layout and the page content with a single writev.
+enum RenderError render_write_page(char *output_directory, char *path, struct Layout *layout, struct Buffer *content, size_t body_offset);
+
+// Opens <output_directory>/<path> for writing, creating any missing parent
+// directories. Returns a file descriptor, or -1 on failure.
+int render_open_file(char *output_directory, char *path);
+
+// Writes length bytes of data to <output_directory>/<path>, creating any
+// missing parent directories.
+enum RenderError render_write_file(char *output_directory, char *path, const char *data, size_t length);
+
+// Renders and writes every page. Worker w always renders the same contiguous
+// range of pages into its own reusable buffer, so no locks are taken and the
+// result of each page depends only on the page itself. If profile is not NULL
+// each page's render and write time, output size and Buffer growths are
+// recorded in it; profile must have been created for the same thread count.
+// Pages are minified if the layout is. If graph is not NULL it must have been
+// built from pages, and each article gets backlink and related page sections.
+// If search is not NULL each worker tokenizes the pages it renders into its own
+// posting lists; search must have been created for the same pages and thread
+// count. With hugepages set each worker maps its buffer itself, hinted for
+// transparent hugepages, so it sits on the worker's own NUMA node.
+enum RenderError render_pages(struct Page **pages, size_t pages_length, struct Layout *layout, unsigned int threads, char *output_directory, struct Profile *profile, struct LinkGraph *graph, struct SearchIndex *search, bool hugepages);
+#endif
@@ -0,0 +1,425 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "wpgbuffer.h"
+#include "wpglib.h"
+#include "wpgparallel.h"
+#include "wpgsearch.h"
+
+// A term in a document, kept once per document once the page is compacted. The
+// term points into the page text and is compared case-insensitively, so
+// tokenizing never copies.
+struct SearchPosting {
+	const char *term;
+	unsigned int term_length;
+	unsigned int document;
+};
+
+struct SearchPostingList {
+	struct SearchPosting *items;
+	size_t length;
+	size_t capacity;
+	size_t document_start;	// first posting of the page being tokenized
+};
+
+struct SearchIndex {
+	size_t pages_length;
+	unsigned int threads;
+	struct SearchPostingList *lists;	// threads * SEARCH_SHARDS, indexed [worker][shard]
+};
+
+struct SearchBuild {
+	struct SearchIndex *index;
+	char *directory;
+	atomic_bool failed;
+};
+
+static const char search_shard_names[SEARCH_SHARDS] = "abcdefghijklmnopqrstuvwxyz0_";
+
+static inline unsigned char search_lower(unsigned char byte) {
+	return (byte >= 'A' && byte <= 'Z') ? byte + ('a' - 'A') : byte;
+}
+
+static inline bool search_is_word(unsigned char byte) {
+	return (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || (byte >= '0' && byte <= '9') || byte >= 0x80;
+}
+
+static inline unsigned int search_shard(unsigned char first) {
+	first = search_lower(first);
+	if (first >= 'a' && first <= 'z')
+		return first - 'a';
+	if (first >= '0' && first <= '9')
+		return 26;
+	return 27;
+}
+
+static int search_term_compare(const struct SearchPosting *left, const struct SearchPosting *right) {
+	unsigned int length = left->term_length < right->term_length ? left->term_length : right->term_length;
+	for (unsigned int i = 0; i < length; i++) {
+		unsigned char a = search_lower(left->term[i]);
+		unsigned char b = search_lower(right->term[i]);
+		if (a != b)
+			return a < b ? -1 : 1;
+	}
+	if (left->term_length != right->term_length)
+		return left->term_length < right->term_length ? -1 : 1;
+	return 0;
+}
+
+static int search_posting_compare(const void *a, const void *b) {
+	const struct SearchPosting *left = a;
+	const struct SearchPosting *right = b;
+
+	int order = search_term_compare(left, right);
+	if (order != 0)
+		return order;
+	if (left->document != right->document)
+		return left->document < right->document ? -1 : 1;
+	return 0;
+}
+
+// Sorts the postings of the page being tokenized and keeps one per term, so a
+// page costs one posting per distinct term rather than one per occurrence.
+static void search_list_compact(struct SearchPostingList *list) {
+	struct SearchPosting *page_items = list->items + list->document_start;
+	size_t page_length = list->length - list->document_start;
+	if (page_length < 2)
+		return;
+
+	qsort(page_items, page_length, sizeof(struct SearchPosting), search_posting_compare);
+	size_t kept = 1;
+	for (size_t i = 1; i < page_length; i++) {
+		if (search_term_compare(&(page_items[i]), &(page_items[kept - 1])) != 0)
+			page_items[kept++] = page_items[i];
+	}
+	list->length = list->document_start + kept;
+}
+
+static bool search_list_add(struct SearchPostingList *list, const char *term, unsigned int term_length, unsigned int document) {
+	// A full list mostly holding the current page is compacted first, and only
+	// grows if that frees less than a quarter of it
+	if (list->length >= list->capacity) {
+		if (list->length - list->document_start >= list->capacity / 2)
+			search_list_compact(list);
+		if (list->length >= list->capacity * 3 / 4) {
+			size_t new_capacity = list->capacity ? list->capacity * 2 : 256;
+			struct SearchPosting *new_items = realloc(list->items, sizeof(struct SearchPosting) * new_capacity);
+			if (new_items == NULL) {
+				fprintf(stderr, "[search_list_add] Failed to reallocate memory for %zu postings.\n", new_capacity);
+				return false;
+			}
+			list->items = new_items;
+			list->capacity = new_capacity;
+		}
+	}
+
+	list->items[list->length].term = term;
+	list->items[list->length].term_length = term_length;
+	list->items[list->length].document = document;
+	list->length++;
+	return true;
+}
+
+// Splits text into runs of word characters, skipping markup tags and
+// character references, and files each run under its shard.
+static bool search_tokenize(struct SearchPostingList *lists, const char *text, size_t length, unsigned int document) {
+	size_t i = 0;
+	while (i < length) {
+		unsigned char byte = text[i];
+		if (byte == '<') {
+			const char *tag_end = memchr(text + i, '>', length - i);
+			i = tag_end == NULL ? length : (size_t) (tag_end - text) + 1;
+			continue;
+		}
+		if (byte == '&') {
+			size_t j = i + 1;
+			while (j < length && j - i < 12 && text[j] != ';' && search_is_word(text[j]) && (unsigned char) text[j] < 0x80)
+				j++;
+			if (j < length && text[j] == ';') {
+				i = j + 1;
+				continue;
+			}
+		}
+		if (!search_is_word(byte)) {
+			i++;
+			continue;
+		}
+
+		size_t start = i;
+		while (i < length && search_is_word(text[i]))
+			i++;
+
+		size_t term_length = i - start;
+		if (term_length < SEARCH_MIN_TERM_LENGTH || term_length > SEARCH_MAX_TERM_LENGTH)
+			continue;
+
+		if (!search_list_add(&(lists[search_shard(text[start])]), text + start, term_length, document))
+			return false;
+	}
+
+	return true;
+}
+
+static bool search_tokenize_page(struct SearchPostingList *lists, struct Page *page, unsigned int document) {
+	bool success = search_tokenize(lists, page->title, strlen(page->title), document);
+
+	if (success && page->page_type == PAGETYPE_ARTICLE && page->page_data != NULL) {
+		struct String *body = ((struct ArticlePage*) page->page_data)->body;
+		success = search_tokenize(lists, body->data, body->length, document);
+	} else if (success && page->page_type == PAGETYPE_GRID_LANDING && page->page_data != NULL) {
+		struct GridPage *grid_page = page->page_data;
+		for (size_t j = 0; j < grid_page->grid_items_length && success; j++)
+			success = search_tokenize(lists, grid_page->grid_items[j].text->data, grid_page->grid_items[j].text->length, document);
+	}
+
+	for (unsigned int shard = 0; shard < SEARCH_SHARDS; shard++) {
+		search_list_compact(&(lists[shard]));
+		lists[shard].document_start = lists[shard].length;
+	}
+	return success;
+}
+
+struct SearchIndex* search_index_create(size_t pages_length, unsigned int threads) {
+	if (pages_length > UINT_MAX) {
+		fprintf(stderr, "[search_index_create] A search index can hold at most %u documents, but %zu were given.\n", UINT_MAX, pages_length);
+		return NULL;
+	}
+
+	if (threads == 0)
+		threads = parallel_default_threads();
+
+	struct SearchIndex *new_index = calloc(1, sizeof(struct SearchIndex));
+	if (new_index == NULL) {
+		fprintf(stderr, "[search_index_create] Failed to allocate memory for a new SearchIndex on the heap.\n");
+		return NULL;
+	}
+
+	new_index->pages_length = pages_length;
+	new_index->threads = threads;
+	new_index->lists = calloc((size_t) threads * SEARCH_SHARDS, sizeof(struct SearchPostingList));
+	if (new_index->lists == NULL) {
+		fprintf(stderr, "[search_index_create] Failed to allocate posting lists for %u workers.\n", threads);
+		free(new_index);
+		return NULL;
+	}
+
+	return new_index;
+}
+
+enum SearchError search_index_add(struct SearchIndex *index, unsigned int worker, struct Page *page, size_t page_index) {
+	if (index == NULL || page == NULL) {
+		fprintf(stderr, "[search_index_add] Cannot add a page using an index or page pointer that points to NULL.\n");
+		return SEARCH_ERROR_NULL_POINTER;
+	}
+
+	if (worker >= index->threads || page_index >= index->pages_length) {
+		fprintf(stderr, "[search_index_add] Cannot add page %zu from worker %u to an index of %zu pages built for %u workers.\n",
+			page_index, worker, index->pages_length, index->threads);
+		return SEARCH_ERROR_NULL_POINTER;
+	}
+
+	if (!search_tokenize_page(&(index->lists[worker * SEARCH_SHARDS]), page, page_index))
+		return SEARCH_ERROR_FAILED_REALLOC;
+	return SEARCH_ERROR_NONE;
+}
+
+static bool search_append_varint(struct Buffer *buffer, unsigned long long value) {
+	unsigned char bytes[10];
+	size_t length = 0;
+	do {
+		bytes[length] = value & 0x7F;
+		value >>= 7;
+		if (value != 0)
+			bytes[length] |= 0x80;
+		length++;
+	} while (value != 0);
+
+	return buffer_append(buffer, (char*) bytes, length) == BUFFER_ERROR_NONE;
+}
+
+static bool search_write_shard(struct SearchBuild *build, unsigned int shard) {
+	char shard_path[PATH_MAX];
+	snprintf(shard_path, sizeof(shard_path), "%s/%c.idx", build->directory, search_shard_names[shard]);
+
+	// Gather the shard's postings from every worker
+	size_t total = 0;
+	for (unsigned int worker = 0; worker < build->index->threads; worker++)
+		total += build->index->lists[worker * SEARCH_SHARDS + shard].length;
+
+	// No file is written for a shard without terms; one left by an earlier build is removed
+	if (total == 0) {
+		if (unlink(shard_path) != 0 && errno != ENOENT) {
+			fprintf(stderr, "[search_write_shard] Failed to remove the stale search shard \"%s\".\n", shard_path);
+			return false;
+		}
+		return true;
+	}
+
+	struct SearchPosting *postings = malloc(sizeof(struct SearchPosting) * total);
+	if (postings == NULL) {
+		fprintf(stderr, "[search_write_shard] Failed to allocate memory for %zu postings of shard '%c'.\n", total, search_shard_names[shard]);
+		return false;
+	}
+
+	size_t length = 0;
+	for (unsigned int worker = 0; worker < build->index->threads; worker++) {
+		struct SearchPostingList *list = &(build->index->lists[worker * SEARCH_SHARDS + shard]);
+		if (list->length == 0)
+			continue;
+		memcpy(postings + length, list->items, sizeof(struct SearchPosting) * list->length);
+		length += list->length;
+	}
+
+	qsort(postings, length, sizeof(struct SearchPosting), search_posting_compare);
+
+	// Count distinct terms for the header
+	size_t terms = 0;
+	for (size_t i = 0; i < length; i++) {
+		if (i == 0 || search_term_compare(&(postings[i]), &(postings[i - 1])) != 0)
+			terms++;
+	}
+
+	struct Buffer buffer;
+	if (buffer_init(&buffer, 4096 + length * 2) != BUFFER_ERROR_NONE) {
+		free(postings);
+		return false;
+	}
+
+	bool success = buffer_append(&buffer, "WPGS\x01", 5) == BUFFER_ERROR_NONE && search_append_varint(&buffer, terms);
+
+	for (size_t i = 0; i < length && success; ) {
+		// Find the end of this term's run and its distinct document count
+		size_t run_end = i + 1;
+		size_t documents = 1;
+		for (; run_end < length && search_term_compare(&(postings[run_end]), &(postings[i])) == 0; run_end++) {
+			if (postings[run_end].document != postings[run_end - 1].document)
+				documents++;
+		}
+
+		char term[SEARCH_MAX_TERM_LENGTH];
+		for (unsigned int j = 0; j < postings[i].term_length; j++)
+			term[j] = search_lower(postings[i].term[j]);
+
+		success = search_append_varint(&buffer, postings[i].term_length) &&
+			buffer_append(&buffer, term, postings[i].term_length) == BUFFER_ERROR_NONE &&
+			search_append_varint(&buffer, documents);
+
+		unsigned int previous = 0;
+		for (size_t j = i; j < run_end && success; j++) {
+			if (j > i && postings[j].document == postings[j - 1].document)
+				continue;
+			success = search_append_varint(&buffer, postings[j].document - previous);
+			previous = postings[j].document;
+		}
+
+		i = run_end;
+	}
+
+	if (success) {
+		FILE *output = fopen(shard_path, "wb");
+		if (output == NULL) {
+			fprintf(stderr, "[search_write_shard] Failed to open search shard \"%s\" for writing.\n", shard_path);
+			success = false;
+		} else {
+			if (fwrite(buffer.data, 1, buffer.length, output) != buffer.length)
+				success = false;
+			if (fclose(output) != 0)
+				success = false;
+			if (!success)
+				fprintf(stderr, "[search_write_shard] Failed to write search shard \"%s\".\n", shard_path);
+		}
+	}
+
+	buffer_free(&buffer);
+	free(postings);
+	return success;
+}
+
+static void search_write_shard_range(size_t start, size_t end, unsigned int worker, void *context) {
+	(void) worker;
+	struct SearchBuild *build = context;
+
+	for (size_t shard = start; shard < end; shard++) {
+		if (!search_write_shard(build, shard))
+			atomic_store(&(build->failed), true);
+	}
+}
+
+static enum SearchError search_write_documents(struct Page **pages, size_t pages_length, char *directory) {
+	char documents_path[PATH_MAX];
+	snprintf(documents_path, sizeof(documents_path), "%s/documents.tsv", directory);
+
+	FILE *output = fopen(documents_path, "wb");
+	if (output == NULL) {
+		fprintf(stderr, "[search_write_documents] Failed to open \"%s\" for writing.\n", documents_path);
+		return SEARCH_ERROR_FAILED_OPEN;
+	}
+
+	bool success = true;
+	for (size_t i = 0; i < pages_length && success; i++) {
+		// Tabs and newlines would break the line format, so flatten them
+		fputs(pages[i]->path, output);
+		fputc('\t', output);
+		for (const char *character = pages[i]->title; *character != '\0'; character++)
+			fputc((*character == '\t' || *character == '\n' || *character == '\r') ? ' ' : *character, output);
+		success = fputc('\n', output) != EOF;
+	}
+
+	if (fclose(output) != 0 || !success) {
+		fprintf(stderr, "[search_write_documents] Failed to write \"%s\".\n", documents_path);
+		return SEARCH_ERROR_FAILED_WRITE;
+	}
+
+	return SEARCH_ERROR_NONE;
+}
+
+enum SearchError search_index_write(struct SearchIndex *index, struct Page **pages, size_t pages_length, char *output_directory) {
+	if (index == NULL || pages == NULL || output_directory == NULL) {
+		fprintf(stderr, "[search_index_write] Cannot write a search index using an index, pages or directory pointer that points to NULL.\n");
+		return SEARCH_ERROR_NULL_POINTER;
+	}
+
+	if (pages_length != index->pages_length) {
+		fprintf(stderr, "[search_index_write] Cannot write a search index built for %zu pages with %zu pages.\n", index->pages_length, pages_length);
+		return SEARCH_ERROR_NULL_POINTER;
+	}
+
+	char directory[PATH_MAX];
+	snprintf(directory, sizeof(directory), "%s/search", output_directory);
+	if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "[search_index_write] Failed to create the search index directory \"%s\".\n", directory);
+		return SEARCH_ERROR_FAILED_OPEN;
+	}
+
+	enum SearchError error = search_write_documents(pages, pages_length, directory);
+	if (error != SEARCH_ERROR_NONE)
+		return error;
+
+	// Postings were gathered by the render workers, so only the merge is left:
+	// each shard is sorted, encoded and written independently
+	struct SearchBuild build = { .index = index, .directory = directory };
+	atomic_init(&(build.failed), false);
+	unsigned int threads = index->threads < SEARCH_SHARDS ? index->threads : SEARCH_SHARDS;
+	if (!parallel_for(SEARCH_SHARDS, threads, search_write_shard_range, &build) || atomic_load(&(build.failed)))
+		return SEARCH_ERROR_FAILED_WRITE;
+
+	return SEARCH_ERROR_NONE;
+}
+
+void search_index_destroy(struct SearchIndex *index) {
+	if (index == NULL) {
+		fprintf(stderr, "[search_index_destroy] Cannot free the memory of a SearchIndex pointer that points to NULL.\n");
+		return;
+	}
+
+	for (size_t i = 0; i < (size_t) index->threads * SEARCH_SHARDS; i++)
+		free(index->lists[i].items);
+	free(index->lists);
+	free(index);
+}
@@ -0,0 +1,46 @@
+#ifndef wpgsearch_h
+#define wpgsearch_h
+#include <stddef.h>
+#include "wpglib.h"
+
+// The index is split into one shard per leading term character ('a'-'z', '0'
+// for digits, '_' for anything else) so a client only fetches the shard for
+// the term being looked up.
+#define SEARCH_SHARDS 28
+#define SEARCH_MIN_TERM_LENGTH 2
+#define SEARCH_MAX_TERM_LENGTH 48
+
+enum SearchError {
+	SEARCH_ERROR_NONE,
+	SEARCH_ERROR_NULL_POINTER,
+	SEARCH_ERROR_FAILED_OPEN,
+	SEARCH_ERROR_FAILED_WRITE,
+	SEARCH_ERROR_FAILED_REALLOC
+};
+
+// Per-worker posting lists for an inverted index over page titles, article
+// bodies and grid anchor text. The render workers fill it as they render
+// (see render_pages), and search_index_write merges and writes it.
+struct SearchIndex;
+
+// Creates an empty index for pages_length pages filled by up to threads
+// workers. Returns NULL on failure.
+struct SearchIndex* search_index_create(size_t pages_length, unsigned int threads);
+
+// Tokenizes page into worker's own posting lists under document id
+// page_index, so workers never share state. Each distinct term of a page is
+// kept once, however often it occurs. Postings point into the page text,
+// which must outlive the index.
+enum SearchError search_index_add(struct SearchIndex *index, unsigned int worker, struct Page *page, size_t page_index);
+
+// Writes the index to <output_directory>/search:
+//   documents.tsv  one "path\ttitle" line per page, line number = document id
+//   <shard>.idx    "WPGS" magic, version byte, varint term count, then for
+//                  every term in byte order: varint length, lowercased term
+//                  bytes, varint posting count, varint document id deltas
+// A shard without terms has no file. Each shard is merged, encoded and
+// written by its own worker. pages must be the pages the index was filled from.
+enum SearchError search_index_write(struct SearchIndex *index, struct Page **pages, size_t pages_length, char *output_directory);
+
+void search_index_destroy(struct SearchIndex *index);
+#endif
@@ -0,0 +1,534 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "wpgasset.h"
+#include "wpggraph.h"
+#include "wpglayout.h"
+#include "wpglib.h"
+#include "wpglinks.h"
+#include "wpgprofile.h"
+#include "wpgrender.h"
+#include "wpgsearch.h"
+#include "wpgsitemap.h"
+#include "wpgspill.h"
+#include "wpgsite.h"
+
+struct Site* site_create(char *output_directory, char *base_url) {
+	if (output_directory == NULL || base_url == NULL) {
+		fprintf(stderr, "[site_create] Cannot create a Site using an output directory or base URL that points to NULL.\n");
+		return NULL;
+	}
+
+	struct Site *new_site = calloc(1, sizeof(struct Site));
+	if (new_site == NULL) {
+		fprintf(stderr, "[site_create] Failed to allocate memory for a new Site on the heap.\n");
+		return NULL;
+	}
+
+	new_site->pages_capacity = 16;
+	new_site->pages = malloc(sizeof(struct Page*) * new_site->pages_capacity);
+	new_site->output_directory = strdup(output_directory);
+	new_site->base_url = strdup(base_url);
+	if (new_site->pages == NULL || new_site->output_directory == NULL || new_site->base_url == NULL) {
+		fprintf(stderr, "[site_create] Failed to allocate the page list and configuration of the new Site.\n");
+		site_destroy(new_site);
+		return NULL;
+	}
+
+	new_site->emit_sitemap = true;
+	new_site->emit_link_index = true;
+	return new_site;
+}
+
+enum SiteError site_add_page(struct Site *site, struct Page *page) {
+	if (site == NULL || page == NULL) {
+		fprintf(stderr, "[site_add_page] Cannot add a page using a site or page pointer that points to NULL.\n");
+		return SITE_ERROR_NULL_POINTER;
+	}
+
+	if (site->pages_length >= site->pages_capacity) {
+		size_t new_capacity = site->pages_capacity * 2;
+		struct Page **new_pages = realloc(site->pages, sizeof(struct Page*) * new_capacity);
+		if (new_pages == NULL) {
+			fprintf(stderr, "[site_add_page] Failed to reallocate the page list to hold %zu pages.\n", new_capacity);
+			return SITE_ERROR_FAILED_REALLOC;
+		}
+		site->pages = new_pages;
+		site->pages_capacity = new_capacity;
+	}
+
+	site->pages[site->pages_length] = page;
+	site->pages_length++;
+	return SITE_ERROR_NONE;
+}
+
+static int site_page_compare(const void *a, const void *b) {
+	const struct Page *left = *(struct Page* const*) a;
+	const struct Page *right = *(struct Page* const*) b;
+	return strcmp(left->path, right->path);
+}
+
+// Puts the pages in path order, so page indexes (and with them search document
+// ids, sitemap order and report order) do not depend on the order pages were
+// added in.
+static void site_canonicalize(struct Site *site) {
+	qsort(site->pages, site->pages_length, sizeof(struct Page*), site_page_compare);
+}
+
+// Two pages with one path would race to write the same file, so they are
+// rejected in every mode. The path set counts them as it is filled in parallel;
+// only when there are some is a serial pass made to name one.
+static enum SiteError site_check_duplicates(struct Page **pages, size_t pages_length, unsigned int threads) {
+	struct PathSet *set = path_set_create(pages, pages_length, threads);
+	if (set == NULL)
+		return SITE_ERROR_FAILED_REALLOC;
+
+	enum SiteError error = SITE_ERROR_NONE;
+	if (atomic_load(&(set->duplicates)) > 0) {
+		for (size_t i = 0; i < pages_length; i++) {
+			if (path_set_find(set, pages[i]->path, strlen(pages[i]->path)) != i) {
+				fprintf(stderr, "[site_check_duplicates] More than one page has the output path \"%s\".\n", pages[i]->path);
+				break;
+			}
+		}
+		error = SITE_ERROR_DUPLICATE_PATH;
+	}
+
+	path_set_destroy(set);
+	return error;
+}
+
+// Fills lastmod with the date stamped into the sitemap. Reproducible builds
+// take it from SOURCE_DATE_EPOCH, or leave it out when that is not set.
+static char* site_lastmod(struct Site *site, char *lastmod, size_t lastmod_size) {
+	time_t timestamp = time(NULL);
+	if (site->reproducible) {
+		char *source_date_epoch = getenv("SOURCE_DATE_EPOCH");
+		if (source_date_epoch == NULL || *source_date_epoch == '\0')
+			return NULL;
+		timestamp = (time_t) strtoll(source_date_epoch, NULL, 10);
+	}
+
+	struct tm date;
+	if (gmtime_r(&timestamp, &date) == NULL || strftime(lastmod, lastmod_size, "%Y-%m-%d", &date) == 0)
+		return NULL;
+	return lastmod;
+}
+
+static enum SiteError site_emit_sitemap(struct Site *site) {
+	char lastmod[32];
+	struct SitemapWriter *writer = sitemap_writer_create(site->output_directory, site->base_url, site_lastmod(site, lastmod, sizeof(lastmod)));
+	if (writer == NULL)
+		return SITE_ERROR_FAILED_SITEMAP;
+
+	enum SitemapError error = SITEMAP_ERROR_NONE;
+	for (size_t i = 0; i < site->pages_length && error == SITEMAP_ERROR_NONE; i++)
+		error = sitemap_writer_add(writer, site->pages[i]->path);
+
+	if (error == SITEMAP_ERROR_NONE)
+		error = sitemap_writer_finish(writer);
+
+	sitemap_writer_destroy(writer);
+	return error == SITEMAP_ERROR_NONE ? SITE_ERROR_NONE : SITE_ERROR_FAILED_SITEMAP;
+}
+
+static enum SiteError site_validate_links(struct Site *site) {
+	size_t problems_length = 0;
+	struct LinkProblem *problems = link_validate(site->pages, site->pages_length, site->threads, &problems_length);
+	if (problems == NULL)
+		return SITE_ERROR_FAILED_VALIDATION;
+
+	char resolved[PATH_MAX];
+	size_t dangling = 0;
+	for (size_t i = 0; i < problems_length; i++) {
+		struct Page *page = site->pages[problems[i].page_index];
+		struct GridPage *grid_page = page->page_data;
+		char *href = grid_page->grid_items[problems[i].anchor_index].href->data;
+
+		// Links to fingerprinted assets are not pages but are not dangling either
+		if (site->assets != NULL && link_resolve(page->path, href, resolved, sizeof(resolved)) && asset_set_contains(site->assets, resolved))
+			continue;
+
+		fprintf(stderr, "[site_validate_links] \"%s\" grid item %zu links to \"%s\", which is not a generated page.\n",
+		        page->path, problems[i].anchor_index, href);
+		dangling++;
+	}
+
+	free(problems);
+	return dangling == 0 ? SITE_ERROR_NONE : SITE_ERROR_DANGLING_LINKS;
+}
+
+enum SiteError site_build(struct Site *site) {
+	if (site == NULL) {
+		fprintf(stderr, "[site_build] Cannot build a Site pointer that points to NULL.\n");
+		return SITE_ERROR_NULL_POINTER;
+	}
+
+	if (site->reproducible)
+		site_canonicalize(site);
+
+	enum SiteError duplicate_error = site_check_duplicates(site->pages, site->pages_length, site->threads);
+	if (duplicate_error != SITE_ERROR_NONE)
+		return duplicate_error;
+
+	if (site->layout == NULL) {
+		site->layout = layout_create(NULL, NULL, NULL, NULL);
+		if (site->layout == NULL)
+			return SITE_ERROR_FAILED_RENDER;
+	}
+
+	// Assets go first so that pages and the layout render with fingerprinted names
+	if (site->assets != NULL) {
+		if (mkdir(site->output_directory, 0755) != 0 && errno != EEXIST) {
+			fprintf(stderr, "[site_build] Failed to create the output directory \"%s\".\n", site->output_directory);
+			return SITE_ERROR_FAILED_ASSETS;
+		}
+		if (asset_set_fingerprint(site->assets, site->threads) != ASSET_ERROR_NONE ||
+		    asset_set_copy(site->assets, site->output_directory, site->threads) != ASSET_ERROR_NONE ||
+		    asset_rewrite_pages(site->assets, site->pages, site->pages_length) != ASSET_ERROR_NONE ||
+		    asset_rewrite_layout(site->assets, site->layout) != ASSET_ERROR_NONE) {
+			fprintf(stderr, "[site_build] Failed to fingerprint the assets of \"%s\".\n", site->output_directory);
+			return SITE_ERROR_FAILED_ASSETS;
+		}
+	}
+
+	if (site->minify && !layout_minify(site->layout))
+		return SITE_ERROR_FAILED_RENDER;
+
+	if (site->validate_links) {
+		enum SiteError error = site_validate_links(site);
+		if (error != SITE_ERROR_NONE)
+			return error;
+	}
+
+	struct LinkGraph *graph = NULL;
+	if (site->navigation && (graph = link_graph_create(site->pages, site->pages_length, site->threads)) == NULL)
+		return SITE_ERROR_FAILED_REALLOC;
+
+	struct Profile *profile = NULL;
+	if (site->profile_pages > 0 && (profile = profile_create(site->threads, site->profile_pages)) == NULL) {
+		if (graph != NULL)
+			link_graph_destroy(graph);
+		return SITE_ERROR_FAILED_REALLOC;
+	}
+
+	// The render workers tokenize each page for the search index while its text is still in cache
+	struct SearchIndex *search = NULL;
+	if (site->emit_search_index && (search = search_index_create(site->pages_length, site->threads)) == NULL) {
+		if (graph != NULL)
+			link_graph_destroy(graph);
+		if (profile != NULL)
+			profile_destroy(profile);
+		return SITE_ERROR_FAILED_REALLOC;
+	}
+	enum RenderError render_error = render_pages(site->pages, site->pages_length, site->layout, site->threads, site->output_directory, profile, graph, search, site->hugepages);
+	if (graph != NULL)
+		link_graph_destroy(graph);
+	if (profile != NULL) {
+		if (render_error == RENDER_ERROR_NONE)
+			profile_report(profile, stderr);
+		profile_destroy(profile);
+	}
+	if (render_error != RENDER_ERROR_NONE) {
+		fprintf(stderr, "[site_build] Failed to render the pages into \"%s\".\n", site->output_directory);
+		if (search != NULL)
+			search_index_destroy(search);
+		return SITE_ERROR_FAILED_RENDER;
+	}
+
+	if (search != NULL) {
+		enum SearchError search_error = search_index_write(search, site->pages, site->pages_length, site->output_directory);
+		search_index_destroy(search);
+		if (search_error != SEARCH_ERROR_NONE) {
+			fprintf(stderr, "[site_build] Failed to emit the search index into \"%s/search\".\n", site->output_directory);
+			return SITE_ERROR_FAILED_SEARCH_INDEX;
+		}
+	}
+
+	if (site->emit_sitemap) {
+		enum SiteError error = site_emit_sitemap(site);
+		if (error != SITE_ERROR_NONE) {
+			fprintf(stderr, "[site_build] Failed to emit the sitemap into \"%s\".\n", site->output_directory);
+			return error;
+		}
+	}
+
+	if (site->emit_link_index) {
+		char link_index_path[PATH_MAX];
+		snprintf(link_index_path, sizeof(link_index_path), "%s/links.tsv", site->output_directory);
+		if (link_index_write(site->pages, site->pages_length, link_index_path) != LINK_ERROR_NONE) {
+			fprintf(stderr, "[site_build] Failed to emit the link index \"%s\".\n", link_index_path);
+			return SITE_ERROR_FAILED_LINK_INDEX;
+		}
+	}
+
+	return SITE_ERROR_NONE;
+}
+
+// Current resident set size, or 0 if it cannot be read.
+static size_t site_resident_bytes() {
+	FILE *statm = fopen("/proc/self/statm", "r");
+	if (statm == NULL)
+		return 0;
+
+	unsigned long long total_pages = 0;
+	unsigned long long resident_pages = 0;
+	int matched = fscanf(statm, "%llu %llu", &total_pages, &resident_pages);
+	fclose(statm);
+	if (matched != 2)
+		return 0;
+
+	return resident_pages * (size_t) sysconf(_SC_PAGESIZE);
+}
+
+// Walks every output path of a streaming build in order. Equal neighbours are
+// pages from different batches that were written to the same file.
+struct SitePathMerge {
+	struct SitemapWriter *writer;	// NULL when no sitemap is emitted
+	struct Buffer previous;
+	bool duplicate;
+};
+
+static bool site_path_emit(const char *key, const char *value, void *context) {
+	(void) value;
+	struct SitePathMerge *merge = context;
+
+	if (merge->previous.length > 0 && strcmp(merge->previous.data, key) == 0) {
+		fprintf(stderr, "[site_path_emit] More than one page has the output path \"%s\".\n", key);
+		merge->duplicate = true;
+		return false;
+	}
+
+	buffer_clear(&(merge->previous));
+	if (buffer_append(&(merge->previous), key, strlen(key) + 1) != BUFFER_ERROR_NONE)
+		return false;
+
+	return merge->writer == NULL || sitemap_writer_add(merge->writer, key) == SITEMAP_ERROR_NONE;
+}
+
+static bool site_link_index_emit(const char *key, const char *value, void *context) {
+	return link_index_writer_add(context, key, value) == LINK_ERROR_NONE;
+}
+
+// Records the cross-page data of one rendered batch before its pages are freed.
+static enum SiteError site_streaming_collect(struct Page **batch, size_t batch_length, struct Spill *paths, struct Spill *links) {
+	for (size_t i = 0; i < batch_length; i++) {
+		struct Page *page = batch[i];
+
+		// Leading slashes are dropped as render_open_file drops them, so "/a.html"
+		// and "a.html" meet as the duplicates they are
+		const char *path = page->path;
+		while (*path == '/')
+			path++;
+		if (spill_add(paths, path, "") != SPILL_ERROR_NONE)
+			return SITE_ERROR_FAILED_SPILL;
+
+		if (links == NULL || page->page_type != PAGETYPE_GRID_LANDING || page->page_data == NULL)
+			continue;
+
+		// Keyed by resolved site path like link_index_write, external links left out
+		struct GridPage *grid_page = page->page_data;
+		char resolved[PATH_MAX];
+		for (size_t j = 0; j < grid_page->grid_items_length; j++) {
+			if (!link_resolve(page->path, grid_page->grid_items[j].href->data, resolved, sizeof(resolved)) || resolved[0] == '\0')
+				continue;
+			if (spill_add(links, resolved, page->path) != SPILL_ERROR_NONE)
+				return SITE_ERROR_FAILED_SPILL;
+		}
+	}
+
+	return SITE_ERROR_NONE;
+}
+
+enum SiteError site_build_streaming(struct Site *site, struct PageSource *source) {
+	if (site == NULL || source == NULL || source->next == NULL) {
+		fprintf(stderr, "[site_build_streaming] Cannot build using a site or page source that points to NULL.\n");
+		return SITE_ERROR_NULL_POINTER;
+	}
+
+	if (site->validate_links || site->emit_search_index || site->navigation) {
+		fprintf(stderr, "[site_build_streaming] Link validation, navigation and the search index need every page in memory and cannot be used in a streaming build.\n");
+		return SITE_ERROR_NEEDS_ALL_PAGES;
+	}
+
+	size_t memory_budget = site->memory_budget ? site->memory_budget : (size_t) 256 * 1024 * 1024;
+	char *spill_directory = site->cache_directory != NULL ? site->cache_directory : site->output_directory;
+	if (mkdir(site->output_directory, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "[site_build_streaming] Failed to create the output directory \"%s\".\n", site->output_directory);
+		return SITE_ERROR_FAILED_RENDER;
+	}
+	if (mkdir(spill_directory, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "[site_build_streaming] Failed to create the cache directory \"%s\".\n", spill_directory);
+		return SITE_ERROR_FAILED_SPILL;
+	}
+
+	if (site->layout == NULL) {
+		site->layout = layout_create(NULL, NULL, NULL, NULL);
+		if (site->layout == NULL)
+			return SITE_ERROR_FAILED_RENDER;
+	}
+
+	if (site->assets != NULL) {
+		if (asset_set_fingerprint(site->assets, site->threads) != ASSET_ERROR_NONE ||
+		    asset_set_copy(site->assets, site->output_directory, site->threads) != ASSET_ERROR_NONE ||
+		    asset_rewrite_layout(site->assets, site->layout) != ASSET_ERROR_NONE) {
+			fprintf(stderr, "[site_build_streaming] Failed to fingerprint the assets of \"%s\".\n", site->output_directory);
+			return SITE_ERROR_FAILED_ASSETS;
+		}
+	}
+
+	if (site->minify && !layout_minify(site->layout))
+		return SITE_ERROR_FAILED_RENDER;
+
+	// Half of the budget goes to pages in flight, the rest to buffered spill records.
+	// Paths are always spilled: merging them in order is what catches two pages
+	// in different batches with one output path, and gives the sitemap its order.
+	enum SiteError error = SITE_ERROR_NONE;
+	char lastmod[32];
+	struct SitemapWriter *sitemap = NULL;
+	struct Spill *paths = NULL;
+	struct Spill *links = NULL;
+	struct Page **batch = NULL;
+	struct Profile *profile = NULL;
+	size_t batch_length = 0;
+	size_t batch_capacity = 1024;
+	size_t batch_budget = memory_budget / 2;
+
+	if (site->emit_sitemap) {
+		sitemap = sitemap_writer_create(site->output_directory, site->base_url, site_lastmod(site, lastmod, sizeof(lastmod)));
+		if (sitemap == NULL)
+			return SITE_ERROR_FAILED_SITEMAP;
+	}
+	if ((paths = spill_create(spill_directory, "paths", memory_budget / 8)) == NULL)
+		error = SITE_ERROR_FAILED_SPILL;
+	if (error == SITE_ERROR_NONE && site->emit_link_index && (links = spill_create(spill_directory, "links", memory_budget / 4)) == NULL)
+		error = SITE_ERROR_FAILED_SPILL;
+
+	batch = malloc(sizeof(struct Page*) * batch_capacity);
+	if (error == SITE_ERROR_NONE && batch == NULL) {
+		fprintf(stderr, "[site_build_streaming] Failed to allocate memory for a batch of %zu pages.\n", batch_capacity);
+		error = SITE_ERROR_FAILED_REALLOC;
+	}
+	if (error == SITE_ERROR_NONE && site->profile_pages > 0 && (profile = profile_create(site->threads, site->profile_pages)) == NULL)
+		error = SITE_ERROR_FAILED_REALLOC;
+
+	bool exhausted = false;
+	while (error == SITE_ERROR_NONE && !exhausted) {
+		// Read pages until the batch reaches its share of the budget, taking at
+		// least one however small the budget is
+		size_t batch_bytes = 0;
+		while (batch_length == 0 || batch_bytes < batch_budget) {
+			struct Page *page = NULL;
+			error = source->next(source->context, &page);
+			if (error != SITE_ERROR_NONE || page == NULL) {
+				exhausted = true;
+				break;
+			}
+
+			if (batch_length >= batch_capacity) {
+				struct Page **new_batch = realloc(batch, sizeof(struct Page*) * batch_capacity * 2);
+				if (new_batch == NULL) {
+					fprintf(stderr, "[site_build_streaming] Failed to grow the page batch past %zu pages.\n", batch_capacity);
+					page_destroy(page);
+					error = SITE_ERROR_FAILED_REALLOC;
+					break;
+				}
+				batch = new_batch;
+				batch_capacity *= 2;
+			}
+
+			batch[batch_length++] = page;
+			batch_bytes += page_memory_size(page);
+		}
+
+		// Pages within a batch are checked before any is written; pages in
+		// different batches only meet when the paths are merged
+		if (error == SITE_ERROR_NONE && batch_length > 0)
+			error = site_check_duplicates(batch, batch_length, site->threads);
+		if (error == SITE_ERROR_NONE && batch_length > 0) {
+			if (site->assets != NULL && asset_rewrite_pages(site->assets, batch, batch_length) != ASSET_ERROR_NONE)
+				error = SITE_ERROR_FAILED_ASSETS;
+			else if (render_pages(batch, batch_length, site->layout, site->threads, site->output_directory, profile, NULL, NULL, site->hugepages) != RENDER_ERROR_NONE)
+				error = SITE_ERROR_FAILED_RENDER;
+			else
+				error = site_streaming_collect(batch, batch_length, paths, links);
+		}
+
+		for (size_t i = 0; i < batch_length; i++)
+			page_destroy(batch[i]);
+		batch_length = 0;
+
+		// Allocator overhead is not in the estimates, so shrink batches while over budget
+		size_t resident = site_resident_bytes();
+		if (resident > memory_budget && batch_budget > 1024 * 1024)
+			batch_budget /= 2;
+	}
+
+	// Merge the spilled runs into their final outputs
+	if (error == SITE_ERROR_NONE) {
+		struct SitePathMerge merge = { .writer = sitemap };
+		if (buffer_init(&(merge.previous), 256) != BUFFER_ERROR_NONE)
+			error = SITE_ERROR_FAILED_REALLOC;
+		else if (spill_merge(paths, site_path_emit, &merge) != SPILL_ERROR_NONE)
+			error = merge.duplicate ? SITE_ERROR_DUPLICATE_PATH : SITE_ERROR_FAILED_SITEMAP;
+		buffer_free(&(merge.previous));
+	}
+	if (error == SITE_ERROR_NONE && sitemap != NULL && sitemap_writer_finish(sitemap) != SITEMAP_ERROR_NONE)
+		error = SITE_ERROR_FAILED_SITEMAP;
+
+	if (error == SITE_ERROR_NONE && links != NULL) {
+		char link_index_path[PATH_MAX];
+		snprintf(link_index_path, sizeof(link_index_path), "%s/links.tsv", site->output_directory);
+		struct LinkIndexWriter *writer = link_index_writer_create(link_index_path);
+		if (writer == NULL ||
+		    spill_merge(links, site_link_index_emit, writer) != SPILL_ERROR_NONE ||
+		    link_index_writer_finish(writer) != LINK_ERROR_NONE)
+			error = SITE_ERROR_FAILED_LINK_INDEX;
+		if (writer != NULL)
+			link_index_writer_destroy(writer);
+	}
+
+	if (profile != NULL) {
+		if (error == SITE_ERROR_NONE)
+			profile_report(profile, stderr);
+		profile_destroy(profile);
+	}
+	free(batch);
+	if (sitemap != NULL)
+		sitemap_writer_destroy(sitemap);
+	if (paths != NULL)
+		spill_destroy(paths);
+	if (links != NULL)
+		spill_destroy(links);
+	return error;
+}
+
+void site_destroy(struct Site *site) {
+	if (site == NULL) {
+		fprintf(stderr, "[site_destroy] Cannot free the memory of a Site pointer that points to NULL.\n");
+		return;
+	}
+
+	if (site->pages != NULL) {
+		for (size_t i = 0; i < site->pages_length; i++)
+			page_destroy(site->pages[i]);
+		free(site->pages);
+	}
+
+	if (site->layout != NULL)
+		layout_destroy(site->layout);
+	if (site->assets != NULL)
+		asset_set_destroy(site->assets);
+
+	free(site->output_directory);
+	free(site->base_url);
+	free(site->cache_directory);
+	free(site);
+}
@@ -0,0 +1,77 @@
+#ifndef wpgsite_h
+#define wpgsite_h
+#include <stdbool.h>
+#include <stddef.h>
+#include "wpgasset.h"
+#include "wpglayout.h"
+#include "wpglib.h"
+
+enum SiteError {
+	SITE_ERROR_NONE,
+	SITE_ERROR_NULL_POINTER,
+	SITE_ERROR_FAILED_REALLOC,
+	SITE_ERROR_FAILED_SITEMAP,
+	SITE_ERROR_FAILED_LINK_INDEX,
+	SITE_ERROR_FAILED_VALIDATION,
+	SITE_ERROR_DANGLING_LINKS,
+	SITE_ERROR_FAILED_SEARCH_INDEX,
+	SITE_ERROR_FAILED_RENDER,
+	SITE_ERROR_DUPLICATE_PATH,
+	SITE_ERROR_FAILED_ASSETS,
+	SITE_ERROR_FAILED_SOURCE,
+	SITE_ERROR_FAILED_SPILL,
+	SITE_ERROR_NEEDS_ALL_PAGES
+};
+
+// Everything a single build needs: the pages and what to emit alongside them.
+struct Site {
+	struct Page **pages;
+	size_t pages_length;
+	size_t pages_capacity;
+	char *output_directory;
+	char *base_url;
+	struct Layout *layout;		// shared markup; NULL renders bare pages. Owned by the Site
+	struct AssetSet *assets;	// assets to fingerprint, or NULL. Owned by the Site
+	bool emit_sitemap;
+	bool emit_link_index;
+	bool emit_search_index;
+	bool validate_links;		// fail the build on internal hrefs that match no page
+	unsigned int threads;		// 0 uses every online processor
+	bool reproducible;		// byte-identical output regardless of page order, thread count or build time
+	size_t memory_budget;		// resident bytes site_build_streaming aims to stay under; 0 uses 256 MiB
+	char *cache_directory;		// scratch space for spilled runs; NULL uses output_directory. Owned by the Site
+	bool hugepages;			// render into per-worker buffers mapped for transparent hugepages
+	bool navigation;		// list backlinks and related pages at the end of every article
+	bool minify;			// strip comments and insignificant whitespace from every page as it renders
+	size_t profile_pages;		// nonzero profiles rendering and reports this many of the slowest pages on stderr
+};
+
+// Supplies pages one at a time to site_build_streaming. next sets *page to the
+// next page, which the build then owns, or to NULL once the source is exhausted.
+struct PageSource {
+	enum SiteError (*next)(void *context, struct Page **page);
+	void *context;
+};
+
+struct Site* site_create(char *output_directory, char *base_url);
+
+// The Site takes ownership of page and destroys it in site_destroy.
+enum SiteError site_add_page(struct Site *site, struct Page *page);
+
+enum SiteError site_build(struct Site *site);
+
+// Builds the pages of source instead of site->pages while holding only a
+// bounded batch of them in memory: each batch is rendered, written and freed
+// before the next is read. Output paths and link pairs are spilled to sorted
+// runs in the cache directory and merged once all pages are done. Duplicate
+// paths within a batch fail the build before the batch is written; duplicates
+// across batches fail it at the merge, after both pages were written.
+// Link validation, navigation and the search index need every page at once,
+// so a site asking for any of them fails with SITE_ERROR_NEEDS_ALL_PAGES
+// before anything is written. The memory budget is a target rather than a limit: batches
+// are sized from estimates that leave out allocator overhead and render
+// buffers, and only shrink once resident memory has been seen above it.
+enum SiteError site_build_streaming(struct Site *site, struct PageSource *source);
+
+void site_destroy(struct Site *site);
+#endif
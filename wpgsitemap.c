@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "wpgbuffer.h"
+#include "wpgsitemap.h"
+
+#define SITEMAP_FLUSH_BYTES (64 * 1024)
+
+static const char sitemap_header[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<urlset xmlns=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n";
+static const char sitemap_footer[] = "</urlset>\n";
+
+struct SitemapWriter* sitemap_writer_create(char *directory, char *base_url, char *lastmod) {
+	if (directory == NULL || base_url == NULL) {
+		fprintf(stderr, "[sitemap_writer_create] Cannot create a SitemapWriter using a directory or base URL that points to NULL.\n");
+		return NULL;
+	}
+
+	struct SitemapWriter *new_writer = calloc(1, sizeof(struct SitemapWriter));
+	if (new_writer == NULL) {
+		fprintf(stderr, "[sitemap_writer_create] Failed to allocate memory for a new SitemapWriter on the heap.\n");
+		return NULL;
+	}
+
+	// Strip trailing slashes so that joining with a path never yields "//"
+	size_t base_url_length = strlen(base_url);
+	while (base_url_length > 0 && base_url[base_url_length - 1] == '/')
+		base_url_length--;
+
+	new_writer->directory = strdup(directory);
+	new_writer->base_url = strndup(base_url, base_url_length);
+	new_writer->lastmod = lastmod != NULL ? strdup(lastmod) : NULL;
+	if (new_writer->directory == NULL || new_writer->base_url == NULL || (lastmod != NULL && new_writer->lastmod == NULL)) {
+		fprintf(stderr, "[sitemap_writer_create] Failed to copy the configuration of the new SitemapWriter.\n");
+		sitemap_writer_destroy(new_writer);
+		return NULL;
+	}
+
+	if (buffer_init(&(new_writer->buffer), SITEMAP_FLUSH_BYTES + 1024) != BUFFER_ERROR_NONE) {
+		fprintf(stderr, "[sitemap_writer_create] Failed to allocate the output buffer of the new SitemapWriter.\n");
+		sitemap_writer_destroy(new_writer);
+		return NULL;
+	}
+
+	return new_writer;
+}
+
+static enum SitemapError sitemap_writer_flush(struct SitemapWriter *writer) {
+	if (writer->buffer.length == 0)
+		return SITEMAP_ERROR_NONE;
+
+	if (fwrite(writer->buffer.data, 1, writer->buffer.length, writer->shard) != writer->buffer.length) {
+		fprintf(stderr, "[sitemap_writer_flush] Failed to write %zu bytes to sitemap shard %zu.\n", writer->buffer.length, writer->shards_length);
+		return SITEMAP_ERROR_FAILED_WRITE;
+	}
+
+	buffer_clear(&(writer->buffer));
+	return SITEMAP_ERROR_NONE;
+}
+
+static enum SitemapError sitemap_writer_close_shard(struct SitemapWriter *writer) {
+	if (writer->shard == NULL)
+		return SITEMAP_ERROR_NONE;
+
+	enum SitemapError error = SITEMAP_ERROR_NONE;
+	if (buffer_append(&(writer->buffer), sitemap_footer, sizeof(sitemap_footer) - 1) != BUFFER_ERROR_NONE)
+		error = SITEMAP_ERROR_FAILED_REALLOC;
+	else
+		error = sitemap_writer_flush(writer);
+
+	if (fclose(writer->shard) != 0 && error == SITEMAP_ERROR_NONE) {
+		fprintf(stderr, "[sitemap_writer_close_shard] Failed to close sitemap shard %zu.\n", writer->shards_length);
+		error = SITEMAP_ERROR_FAILED_WRITE;
+	}
+
+	writer->shard = NULL;
+	return error;
+}
+
+static enum SitemapError sitemap_writer_open_shard(struct SitemapWriter *writer) {
+	char shard_path[PATH_MAX];
+	snprintf(shard_path, sizeof(shard_path), "%s/sitemap-%zu.xml", writer->directory, writer->shards_length + 1);
+
+	writer->shard = fopen(shard_path, "wb");
+	if (writer->shard == NULL) {
+		fprintf(stderr, "[sitemap_writer_open_shard] Failed to open sitemap shard \"%s\" for writing.\n", shard_path);
+		return SITEMAP_ERROR_FAILED_OPEN;
+	}
+
+	writer->shards_length++;
+	writer->shard_urls = 0;
+	writer->shard_bytes = sizeof(sitemap_header) - 1;
+	if (buffer_append(&(writer->buffer), sitemap_header, sizeof(sitemap_header) - 1) != BUFFER_ERROR_NONE)
+		return SITEMAP_ERROR_FAILED_REALLOC;
+
+	return SITEMAP_ERROR_NONE;
+}
+
+// Percent-encodes every byte of the path other than unreserved characters and
+// '/', which also leaves nothing that would need XML escaping.
+static enum BufferError sitemap_append_path(struct Buffer *buffer, const char *path) {
+	static const char hex[] = "0123456789ABCDEF";
+	const char *run_start = path;
+	const char *character = path;
+
+	for (; *character != '\0'; character++) {
+		unsigned char byte = *character;
+		if ((byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || (byte >= '0' && byte <= '9') ||
+		    byte == '-' || byte == '.' || byte == '_' || byte == '~' || byte == '/')
+			continue;
+
+		char encoded[3] = { '%', hex[byte >> 4], hex[byte & 0x0F] };
+		if (buffer_append(buffer, run_start, character - run_start) != BUFFER_ERROR_NONE ||
+		    buffer_append(buffer, encoded, 3) != BUFFER_ERROR_NONE)
+			return BUFFER_ERROR_FAILED_REALLOC;
+		run_start = character + 1;
+	}
+
+	return buffer_append(buffer, run_start, character - run_start);
+}
+
+enum SitemapError sitemap_writer_add(struct SitemapWriter *writer, const char *path) {
+	if (writer == NULL || path == NULL) {
+		fprintf(stderr, "[sitemap_writer_add] Cannot add a URL using a writer or path that points to NULL.\n");
+		return SITEMAP_ERROR_NULL_POINTER;
+	}
+
+	// Render the entry first so that its size is known before choosing a shard
+	size_t entry_start = writer->buffer.length;
+	while (*path == '/')
+		path++;
+
+	if (buffer_append_cstring(&(writer->buffer), "<url><loc>") != BUFFER_ERROR_NONE ||
+	    buffer_append_escaped(&(writer->buffer), writer->base_url, strlen(writer->base_url)) != BUFFER_ERROR_NONE ||
+	    buffer_append(&(writer->buffer), "/", 1) != BUFFER_ERROR_NONE ||
+	    sitemap_append_path(&(writer->buffer), path) != BUFFER_ERROR_NONE ||
+	    buffer_append_cstring(&(writer->buffer), "</loc>") != BUFFER_ERROR_NONE)
+		return SITEMAP_ERROR_FAILED_REALLOC;
+
+	if (writer->lastmod != NULL) {
+		if (buffer_append_cstring(&(writer->buffer), "<lastmod>") != BUFFER_ERROR_NONE ||
+		    buffer_append_escaped(&(writer->buffer), writer->lastmod, strlen(writer->lastmod)) != BUFFER_ERROR_NONE ||
+		    buffer_append_cstring(&(writer->buffer), "</lastmod>") != BUFFER_ERROR_NONE)
+			return SITEMAP_ERROR_FAILED_REALLOC;
+	}
+
+	if (buffer_append_cstring(&(writer->buffer), "</url>\n") != BUFFER_ERROR_NONE)
+		return SITEMAP_ERROR_FAILED_REALLOC;
+
+	size_t entry_length = writer->buffer.length - entry_start;
+
+	// Roll over to a new shard when this entry would break either limit
+	bool needs_new_shard = writer->shard == NULL ||
+		writer->shard_urls == SITEMAP_MAX_URLS ||
+		writer->shard_bytes + entry_length + sizeof(sitemap_footer) - 1 > SITEMAP_MAX_BYTES;
+
+	if (needs_new_shard) {
+		// Hold the pending entry aside while the previous shard is closed
+		char *entry = malloc(entry_length);
+		if (entry == NULL) {
+			fprintf(stderr, "[sitemap_writer_add] Failed to allocate %zu bytes to hold a pending sitemap entry.\n", entry_length);
+			return SITEMAP_ERROR_FAILED_REALLOC;
+		}
+		memcpy(entry, writer->buffer.data + entry_start, entry_length);
+		writer->buffer.length = entry_start;
+
+		enum SitemapError error = sitemap_writer_close_shard(writer);
+		if (error == SITEMAP_ERROR_NONE)
+			error = sitemap_writer_open_shard(writer);
+		if (error == SITEMAP_ERROR_NONE && buffer_append(&(writer->buffer), entry, entry_length) != BUFFER_ERROR_NONE)
+			error = SITEMAP_ERROR_FAILED_REALLOC;
+
+		free(entry);
+		if (error != SITEMAP_ERROR_NONE)
+			return error;
+	}
+
+	writer->shard_urls++;
+	writer->shard_bytes += entry_length;
+	writer->urls_length++;
+
+	if (writer->buffer.length >= SITEMAP_FLUSH_BYTES)
+		return sitemap_writer_flush(writer);
+
+	return SITEMAP_ERROR_NONE;
+}
+
+enum SitemapError sitemap_writer_finish(struct SitemapWriter *writer) {
+	if (writer == NULL) {
+		fprintf(stderr, "[sitemap_writer_finish] Cannot finish a SitemapWriter pointer that points to NULL.\n");
+		return SITEMAP_ERROR_NULL_POINTER;
+	}
+
+	enum SitemapError error = sitemap_writer_close_shard(writer);
+	if (error != SITEMAP_ERROR_NONE)
+		return error;
+
+	char index_path[PATH_MAX];
+	snprintf(index_path, sizeof(index_path), "%s/sitemap.xml", writer->directory);
+	FILE *index = fopen(index_path, "wb");
+	if (index == NULL) {
+		fprintf(stderr, "[sitemap_writer_finish] Failed to open sitemap index \"%s\" for writing.\n", index_path);
+		return SITEMAP_ERROR_FAILED_OPEN;
+	}
+
+	buffer_clear(&(writer->buffer));
+	if (buffer_append_cstring(&(writer->buffer),
+	                          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	                          "<sitemapindex xmlns=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n") != BUFFER_ERROR_NONE)
+		error = SITEMAP_ERROR_FAILED_REALLOC;
+
+	for (size_t i = 1; i <= writer->shards_length && error == SITEMAP_ERROR_NONE; i++) {
+		char shard_name[64];
+		snprintf(shard_name, sizeof(shard_name), "/sitemap-%zu.xml", i);
+		if (buffer_append_cstring(&(writer->buffer), "<sitemap><loc>") != BUFFER_ERROR_NONE ||
+		    buffer_append_escaped(&(writer->buffer), writer->base_url, strlen(writer->base_url)) != BUFFER_ERROR_NONE ||
+		    buffer_append_cstring(&(writer->buffer), shard_name) != BUFFER_ERROR_NONE ||
+		    buffer_append_cstring(&(writer->buffer), "</loc></sitemap>\n") != BUFFER_ERROR_NONE)
+			error = SITEMAP_ERROR_FAILED_REALLOC;
+	}
+
+	if (error == SITEMAP_ERROR_NONE && buffer_append_cstring(&(writer->buffer), "</sitemapindex>\n") != BUFFER_ERROR_NONE)
+		error = SITEMAP_ERROR_FAILED_REALLOC;
+
+	if (error == SITEMAP_ERROR_NONE && fwrite(writer->buffer.data, 1, writer->buffer.length, index) != writer->buffer.length) {
+		fprintf(stderr, "[sitemap_writer_finish] Failed to write the sitemap index \"%s\".\n", index_path);
+		error = SITEMAP_ERROR_FAILED_WRITE;
+	}
+
+	if (fclose(index) != 0 && error == SITEMAP_ERROR_NONE) {
+		fprintf(stderr, "[sitemap_writer_finish] Failed to close the sitemap index \"%s\".\n", index_path);
+		error = SITEMAP_ERROR_FAILED_WRITE;
+	}
+
+	buffer_clear(&(writer->buffer));
+	return error;
+}
+
+void sitemap_writer_destroy(struct SitemapWriter *writer) {
+	if (writer == NULL) {
+		fprintf(stderr, "[sitemap_writer_destroy] Cannot free the memory of a SitemapWriter pointer that points to NULL.\n");
+		return;
+	}
+
+	if (writer->shard != NULL)
+		fclose(writer->shard);
+
+	free(writer->directory);
+	free(writer->base_url);
+	free(writer->lastmod);
+	buffer_free(&(writer->buffer));
+	free(writer);
+}
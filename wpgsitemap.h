@@ -0,0 +1,40 @@
+#ifndef wpgsitemap_h
+#define wpgsitemap_h
+#include <stdio.h>
+#include <stddef.h>
+#include "wpgbuffer.h"
+
+// Limits from the sitemaps.org protocol. A shard is closed as soon as either
+// limit would be exceeded, and sitemap.xml becomes an index of all shards.
+#define SITEMAP_MAX_URLS 50000
+#define SITEMAP_MAX_BYTES (50 * 1024 * 1024)
+
+enum SitemapError {
+	SITEMAP_ERROR_NONE,
+	SITEMAP_ERROR_NULL_POINTER,
+	SITEMAP_ERROR_FAILED_OPEN,
+	SITEMAP_ERROR_FAILED_WRITE,
+	SITEMAP_ERROR_FAILED_REALLOC
+};
+
+struct SitemapWriter {
+	char *directory;
+	char *base_url;
+	char *lastmod;		// W3C datetime written for every url, or NULL to omit
+	FILE *shard;
+	size_t shard_urls;
+	size_t shard_bytes;
+	size_t shards_length;
+	size_t urls_length;
+	struct Buffer buffer;
+};
+
+struct SitemapWriter* sitemap_writer_create(char *directory, char *base_url, char *lastmod);
+
+enum SitemapError sitemap_writer_add(struct SitemapWriter *writer, const char *path);
+
+// Closes the open shard and writes sitemap.xml listing every shard.
+enum SitemapError sitemap_writer_finish(struct SitemapWriter *writer);
+
+void sitemap_writer_destroy(struct SitemapWriter *writer);
+#endif
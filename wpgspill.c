@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include "wpgbuffer.h"
+#include "wpgspill.h"
+
+// Most runs open at once during a merge.
+#define SPILL_MERGE_FAN_IN 64
+
+// One open run during a merge, positioned on its smallest unread record.
+struct SpillReader {
+	FILE *input;
+	char *key;
+	char *value;
+	size_t key_capacity;
+	size_t value_capacity;
+	bool exhausted;
+};
+
+struct Spill* spill_create(char *directory, char *name, size_t budget) {
+	if (directory == NULL || name == NULL) {
+		fprintf(stderr, "[spill_create] Cannot create a Spill using a directory or name that points to NULL.\n");
+		return NULL;
+	}
+
+	struct Spill *new_spill = calloc(1, sizeof(struct Spill));
+	if (new_spill == NULL) {
+		fprintf(stderr, "[spill_create] Failed to allocate memory for a new Spill on the heap.\n");
+		return NULL;
+	}
+
+	new_spill->directory = strdup(directory);
+	new_spill->name = strdup(name);
+	new_spill->budget = budget ? budget : 1024 * 1024;
+	new_spill->offsets_capacity = 1024;
+	new_spill->offsets = malloc(sizeof(size_t) * new_spill->offsets_capacity);
+	if (new_spill->directory == NULL || new_spill->name == NULL || new_spill->offsets == NULL ||
+	    buffer_init(&(new_spill->records), 64 * 1024) != BUFFER_ERROR_NONE) {
+		fprintf(stderr, "[spill_create] Failed to allocate the record storage of the new Spill.\n");
+		spill_destroy(new_spill);
+		return NULL;
+	}
+
+	return new_spill;
+}
+
+size_t spill_memory(struct Spill *spill) {
+	if (spill == NULL)
+		return 0;
+	return spill->records.length + spill->offsets_length * sizeof(size_t);
+}
+
+// qsort has no context argument, so the records being sorted are handed over here.
+static _Thread_local const char *spill_sort_records;
+
+static int spill_record_compare(const void *a, const void *b) {
+	const char *left = spill_sort_records + *(const size_t*) a;
+	const char *right = spill_sort_records + *(const size_t*) b;
+
+	int order = strcmp(left, right);
+	if (order != 0)
+		return order;
+	return strcmp(left + strlen(left) + 1, right + strlen(right) + 1);
+}
+
+static void spill_run_path(struct Spill *spill, size_t run, char *path, size_t path_size) {
+	snprintf(path, path_size, "%s/%s-%zu.run", spill->directory, spill->name, run);
+}
+
+// Sorts the buffered records and writes them out as the next run.
+static enum SpillError spill_write_run(struct Spill *spill) {
+	spill_sort_records = spill->records.data;
+	qsort(spill->offsets, spill->offsets_length, sizeof(size_t), spill_record_compare);
+	spill_sort_records = NULL;
+
+	char run_path[PATH_MAX];
+	spill_run_path(spill, spill->runs_length, run_path, sizeof(run_path));
+	FILE *output = fopen(run_path, "wb");
+	if (output == NULL) {
+		fprintf(stderr, "[spill_write_run] Failed to open the run \"%s\" for writing.\n", run_path);
+		return SPILL_ERROR_FAILED_OPEN;
+	}
+
+	bool success = true;
+	for (size_t i = 0; i < spill->offsets_length && success; i++) {
+		const char *key = spill->records.data + spill->offsets[i];
+		size_t key_size = strlen(key) + 1;
+		size_t value_size = strlen(key + key_size) + 1;
+		success = fwrite(key, 1, key_size + value_size, output) == key_size + value_size;
+	}
+
+	if (fclose(output) != 0 || !success) {
+		fprintf(stderr, "[spill_write_run] Failed to write the run \"%s\".\n", run_path);
+		unlink(run_path);
+		return SPILL_ERROR_FAILED_WRITE;
+	}
+
+	spill->runs_length++;
+	spill->offsets_length = 0;
+	buffer_clear(&(spill->records));
+	return SPILL_ERROR_NONE;
+}
+
+enum SpillError spill_add(struct Spill *spill, const char *key, const char *value) {
+	if (spill == NULL || key == NULL || value == NULL) {
+		fprintf(stderr, "[spill_add] Cannot add a record using pointers that point to NULL.\n");
+		return SPILL_ERROR_NULL_POINTER;
+	}
+
+	if (spill->offsets_length >= spill->offsets_capacity) {
+		size_t new_capacity = spill->offsets_capacity * 2;
+		size_t *new_offsets = realloc(spill->offsets, sizeof(size_t) * new_capacity);
+		if (new_offsets == NULL) {
+			fprintf(stderr, "[spill_add] Failed to reallocate memory for %zu record offsets.\n", new_capacity);
+			return SPILL_ERROR_FAILED_REALLOC;
+		}
+		spill->offsets = new_offsets;
+		spill->offsets_capacity = new_capacity;
+	}
+
+	size_t offset = spill->records.length;
+	if (buffer_append(&(spill->records), key, strlen(key) + 1) != BUFFER_ERROR_NONE ||
+	    buffer_append(&(spill->records), value, strlen(value) + 1) != BUFFER_ERROR_NONE) {
+		spill->records.length = offset;
+		return SPILL_ERROR_FAILED_REALLOC;
+	}
+
+	spill->offsets[spill->offsets_length] = offset;
+	spill->offsets_length++;
+
+	if (spill_memory(spill) >= spill->budget)
+		return spill_write_run(spill);
+	return SPILL_ERROR_NONE;
+}
+
+static bool spill_reader_advance(struct SpillReader *reader) {
+	if (getdelim(&(reader->key), &(reader->key_capacity), '\0', reader->input) < 0 ||
+	    getdelim(&(reader->value), &(reader->value_capacity), '\0', reader->input) < 0) {
+		reader->exhausted = true;
+		return !ferror(reader->input);
+	}
+	return true;
+}
+
+static int spill_reader_compare(const struct SpillReader *left, const struct SpillReader *right) {
+	int order = strcmp(left->key, right->key);
+	if (order != 0)
+		return order;
+	return strcmp(left->value, right->value);
+}
+
+// Restores the min-heap order of heap below position after its reader moved on.
+static void spill_heap_sift_down(struct SpillReader **heap, size_t heap_length, size_t position) {
+	while (true) {
+		size_t smallest = position;
+		size_t left = position * 2 + 1;
+		size_t right = left + 1;
+		if (left < heap_length && spill_reader_compare(heap[left], heap[smallest]) < 0)
+			smallest = left;
+		if (right < heap_length && spill_reader_compare(heap[right], heap[smallest]) < 0)
+			smallest = right;
+		if (smallest == position)
+			return;
+
+		struct SpillReader *swap = heap[position];
+		heap[position] = heap[smallest];
+		heap[smallest] = swap;
+		position = smallest;
+	}
+}
+
+// Merges runs [first, first + count) in (key, value) order into emit, with a
+// heap picking the smallest record. Every run is open at once, so callers keep
+// count at or below SPILL_MERGE_FAN_IN.
+static enum SpillError spill_merge_runs(struct Spill *spill, size_t first, size_t count, SpillEmitFunction emit, void *context) {
+	struct SpillReader *readers = calloc(count ? count : 1, sizeof(struct SpillReader));
+	struct SpillReader **heap = malloc(sizeof(struct SpillReader*) * (count ? count : 1));
+	if (readers == NULL || heap == NULL) {
+		fprintf(stderr, "[spill_merge_runs] Failed to allocate readers for %zu runs.\n", count);
+		free(readers);
+		free(heap);
+		return SPILL_ERROR_FAILED_REALLOC;
+	}
+
+	enum SpillError error = SPILL_ERROR_NONE;
+	size_t heap_length = 0;
+	for (size_t i = 0; i < count && error == SPILL_ERROR_NONE; i++) {
+		char run_path[PATH_MAX];
+		spill_run_path(spill, first + i, run_path, sizeof(run_path));
+		readers[i].input = fopen(run_path, "rb");
+		if (readers[i].input == NULL) {
+			fprintf(stderr, "[spill_merge_runs] Failed to open the run \"%s\".\n", run_path);
+			error = SPILL_ERROR_FAILED_OPEN;
+		} else if (!spill_reader_advance(&(readers[i]))) {
+			error = SPILL_ERROR_FAILED_READ;
+		} else if (!readers[i].exhausted) {
+			heap[heap_length++] = &(readers[i]);
+		}
+	}
+	for (size_t i = heap_length / 2; i-- > 0; )
+		spill_heap_sift_down(heap, heap_length, i);
+
+	while (error == SPILL_ERROR_NONE && heap_length > 0) {
+		struct SpillReader *smallest = heap[0];
+		if (!emit(smallest->key, smallest->value, context)) {
+			error = SPILL_ERROR_FAILED_WRITE;
+			break;
+		}
+		if (!spill_reader_advance(smallest)) {
+			error = SPILL_ERROR_FAILED_READ;
+			break;
+		}
+		if (smallest->exhausted)
+			heap[0] = heap[--heap_length];
+		spill_heap_sift_down(heap, heap_length, 0);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (readers[i].input != NULL)
+			fclose(readers[i].input);
+		free(readers[i].key);
+		free(readers[i].value);
+	}
+	free(readers);
+	free(heap);
+	return error;
+}
+
+static bool spill_run_emit(const char *key, const char *value, void *context) {
+	FILE *output = context;
+	size_t key_size = strlen(key) + 1;
+	size_t value_size = strlen(value) + 1;
+	return fwrite(key, 1, key_size, output) == key_size && fwrite(value, 1, value_size, output) == value_size;
+}
+
+enum SpillError spill_merge(struct Spill *spill, SpillEmitFunction emit, void *context) {
+	if (spill == NULL || emit == NULL) {
+		fprintf(stderr, "[spill_merge] Cannot merge using a spill or function pointer that points to NULL.\n");
+		return SPILL_ERROR_NULL_POINTER;
+	}
+
+	// Flush what is still buffered so that every record is in some run
+	if (spill->offsets_length > 0) {
+		enum SpillError error = spill_write_run(spill);
+		if (error != SPILL_ERROR_NONE)
+			return error;
+	}
+
+	// A small budget can leave any number of runs, more than there are file
+	// descriptors. Merge the oldest SPILL_MERGE_FAN_IN into a new run at the
+	// end until few enough are left, so each record is rewritten about
+	// log(runs) / log(SPILL_MERGE_FAN_IN) times.
+	while (spill->runs_length - spill->first_run > SPILL_MERGE_FAN_IN) {
+		char run_path[PATH_MAX];
+		spill_run_path(spill, spill->runs_length, run_path, sizeof(run_path));
+		FILE *output = fopen(run_path, "wb");
+		if (output == NULL) {
+			fprintf(stderr, "[spill_merge] Failed to open the run \"%s\" for writing.\n", run_path);
+			return SPILL_ERROR_FAILED_OPEN;
+		}
+
+		enum SpillError error = spill_merge_runs(spill, spill->first_run, SPILL_MERGE_FAN_IN, spill_run_emit, output);
+		if (error == SPILL_ERROR_FAILED_WRITE)
+			fprintf(stderr, "[spill_merge] Failed to write the run \"%s\".\n", run_path);
+		if (fclose(output) != 0 && error == SPILL_ERROR_NONE) {
+			fprintf(stderr, "[spill_merge] Failed to write the run \"%s\".\n", run_path);
+			error = SPILL_ERROR_FAILED_WRITE;
+		}
+		if (error != SPILL_ERROR_NONE) {
+			unlink(run_path);
+			return error;
+		}
+
+		for (size_t i = spill->first_run; i < spill->first_run + SPILL_MERGE_FAN_IN; i++) {
+			spill_run_path(spill, i, run_path, sizeof(run_path));
+			unlink(run_path);
+		}
+		spill->first_run += SPILL_MERGE_FAN_IN;
+		spill->runs_length++;
+	}
+
+	return spill_merge_runs(spill, spill->first_run, spill->runs_length - spill->first_run, emit, context);
+}
+
+void spill_destroy(struct Spill *spill) {
+	if (spill == NULL) {
+		fprintf(stderr, "[spill_destroy] Cannot free the memory of a Spill pointer that points to NULL.\n");
+		return;
+	}
+
+	if (spill->directory != NULL && spill->name != NULL) {
+		for (size_t i = spill->first_run; i < spill->runs_length; i++) {
+			char run_path[PATH_MAX];
+			spill_run_path(spill, i, run_path, sizeof(run_path));
+			unlink(run_path);
+		}
+	}
+
+	free(spill->directory);
+	free(spill->name);
+	free(spill->offsets);
+	buffer_free(&(spill->records));
+	free(spill);
+}
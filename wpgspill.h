@@ -0,0 +1,48 @@
+#ifndef wpgspill_h
+#define wpgspill_h
+#include <stdbool.h>
+#include <stddef.h>
+#include "wpgbuffer.h"
+
+// External sort for (key, value) string records. Records are held in memory
+// until they exceed the budget, then sorted and written out as a run file;
+// spill_merge streams every record back in (key, value) order.
+
+enum SpillError {
+	SPILL_ERROR_NONE,
+	SPILL_ERROR_NULL_POINTER,
+	SPILL_ERROR_FAILED_OPEN,
+	SPILL_ERROR_FAILED_READ,
+	SPILL_ERROR_FAILED_WRITE,
+	SPILL_ERROR_FAILED_REALLOC
+};
+
+// Receives each record during spill_merge. Returning false stops the merge.
+typedef bool (*SpillEmitFunction)(const char *key, const char *value, void *context);
+
+struct Spill {
+	char *directory;
+	char *name;		// runs are written to <directory>/<name>-<n>.run
+	size_t budget;		// bytes of records held before a run is written
+	struct Buffer records;	// NUL terminated key then value, back to back
+	size_t *offsets;	// start of each record within records
+	size_t offsets_length;
+	size_t offsets_capacity;
+	size_t runs_length;
+	size_t first_run;	// runs before this one were merged into later runs and removed
+};
+
+struct Spill* spill_create(char *directory, char *name, size_t budget);
+
+enum SpillError spill_add(struct Spill *spill, const char *key, const char *value);
+
+// Bytes of memory currently held by buffered records.
+size_t spill_memory(struct Spill *spill);
+
+// Emits every record added, duplicates included, in (key, value) order. Many
+// runs are first merged down in passes, so no more than 64 files are open.
+enum SpillError spill_merge(struct Spill *spill, SpillEmitFunction emit, void *context);
+
+// Frees the Spill and removes its run files.
+void spill_destroy(struct Spill *spill);
+#endif
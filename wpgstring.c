@@ -29,7 +29,7 @@ struct String* string_create(char *data) {
 		return NULL;
 	}
 
-	unsigned short length =	strlen(data);
+	size_t length = strlen(data);
 	if (length == 0) {
 		fprintf(stderr, "[string_create] Cannot create a new String of length 0.\n");
 		return NULL;
@@ -45,7 +45,7 @@ struct String* string_create(char *data) {
 	// Attempt to allocate data buffer.
 	new_string->data = malloc(sizeof(char) * (length + 1));
 	if (new_string->data == NULL) {
-		fprintf(stderr, "[string_create] Failed to allocate %hu bytes of memory for the provided string \"%s\".\n", length, data);
+		fprintf(stderr, "[string_create] Failed to allocate %zu bytes of memory for the provided string \"%s\".\n", length, data);
 		free(new_string);
 		return NULL;
 	}
@@ -55,13 +55,13 @@ struct String* string_create(char *data) {
 	new_string->capacity = length + 1;
 
 	// Copy string data
-	strcpy(new_string->data, data);
+	memcpy(new_string->data, data, length);
 	new_string->data[length] = '\0'; 
 
 	return new_string;
 }
 
-enum StringError string_set(struct String *string, char *data, unsigned short length) {
+enum StringError string_set(struct String *string, char *data, size_t length) {
 	if (string == NULL) {
 		fprintf(stderr, "[string_set] Cannot set data for a String pointer that points to NULL.\n");
 		return STRING_ERROR_NULL_POINTER;
@@ -78,17 +78,18 @@ enum StringError string_set(struct String *string, char *data, unsigned short le
 	}
 
 	if (length >= string->capacity) {
-		string->data = realloc(string->data, sizeof(char) * (length + 1));
-		if (string->data == NULL) {
+		char *new_data = realloc(string->data, sizeof(char) * (length + 1));
+		if (new_data == NULL) {
 			fprintf(stderr, "[string_set] Failed to reallocate the data buffer of the string to be set.\n");
-			free(string);
 			return STRING_ERROR_FAILED_REALLOC;
 		}
+		string->data = new_data;
+		string->capacity = length + 1;
 	}
 	
+	// Copy exactly length bytes; data may be longer than what is being set
 	string->length = length;
-	string->capacity = length + 1;
-	strcpy(string->data, data);
+	memcpy(string->data, data, length);
 	string->data[length] = '\0';
 
 	return STRING_ERROR_NONE;
@@ -110,7 +111,21 @@ enum StringError string_clear(struct String *string) {
 	return STRING_ERROR_NONE;
 }
 
-struct String* string_splice(struct String *string, unsigned short start, unsigned short end, unsigned short step) {
+struct String* string_splice(struct String *string, size_t start, size_t end, size_t step) {
+	if (string == NULL || string->data == NULL) {
+		fprintf(stderr, "[string_splice] Cannot splice a String pointer or data buffer that points to NULL.\n");
+		return NULL;
+	}
+
+	// Like Python slicing, an end past the string stops at its last character
+	if (end > string->length)
+		end = string->length;
+
+	if (start > end) {
+		fprintf(stderr, "[string_splice] Cannot splice a string using a start boundary (%zu) past the end boundary (%zu).\n", start, end);
+		return NULL;
+	}
+
 	if (start == end) {
 		fprintf(stderr, "[string_splice] Cannot splice a string using equal start and end boundaries.\n");
 		return NULL;
@@ -130,10 +145,10 @@ struct String* string_splice(struct String *string, unsigned short start, unsign
 
 	// Set default attributes
 	new_string->length = 0;
-	new_string->capacity = ((end - start) / step) + 2; 
+	new_string->capacity = ((end - start - 1) / step) + 2; 
 	new_string->data = malloc(sizeof(char) * new_string->capacity); 
 	if (new_string->data == NULL) {
-		fprintf(stderr, "[string_splice] Failed to allocate %hu bytes of memory for the substring.\n", new_string->capacity);
+		fprintf(stderr, "[string_splice] Failed to allocate %zu bytes of memory for the substring.\n", new_string->capacity);
 		free(new_string);
 		return NULL;
 	}
@@ -1,5 +1,6 @@
 #ifndef wpgstring_h
 #define wpgstring_h
+#include <stddef.h>
 
 enum StringError {
 	STRING_ERROR_NONE,
@@ -10,19 +11,19 @@ enum StringError {
 
 struct String {
 	char *data;
-	unsigned short length;
-	unsigned short capacity;
+	size_t length;
+	size_t capacity;
 };
 
 struct String* string_init();
 
 struct String* string_create(char *data);
 
-enum StringError string_set(struct String *string, char *data, unsigned short length);
+enum StringError string_set(struct String *string, char *data, size_t length);
 
 enum StringError string_clear(struct String *string);
 
-struct String* string_splice(struct String *string, unsigned short start, unsigned short end, unsigned short step);
+struct String* string_splice(struct String *string, size_t start, size_t end, size_t step);
 
 void string_destroy(struct String *string);
 #endif
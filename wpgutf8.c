@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "wpgbuffer.h"
+#include "wpgutf8.h"
+
+#define UTF8_HIGH_BITS 0x8080808080808080ULL
+
+// Length of the longest prefix of data that is pure ASCII. Four words are
+// OR-ed together per step so the check is one branch per 32 bytes, which
+// compilers turn into vector code where it is available.
+static size_t utf8_ascii_prefix(const unsigned char *data, size_t length) {
+	size_t i = 0;
+	for (; i + 32 <= length; i += 32) {
+		unsigned long long words[4];
+		memcpy(words, data + i, sizeof(words));
+		if ((words[0] | words[1] | words[2] | words[3]) & UTF8_HIGH_BITS)
+			break;
+	}
+	for (; i + 8 <= length; i += 8) {
+		unsigned long long word;
+		memcpy(&word, data + i, sizeof(word));
+		if (word & UTF8_HIGH_BITS)
+			break;
+	}
+	while (i < length && data[i] < 0x80)
+		i++;
+	return i;
+}
+
+// Length of the valid multi-byte sequence at data, or 0 if it is invalid.
+static size_t utf8_sequence_length(const unsigned char *data, size_t length) {
+	unsigned char lead = data[0];
+
+	// Ranges from the Unicode standard, table 3-7
+	if (lead >= 0xC2 && lead <= 0xDF) {
+		if (length >= 2 && (data[1] & 0xC0) == 0x80)
+			return 2;
+	} else if (lead >= 0xE0 && lead <= 0xEF) {
+		unsigned char low = lead == 0xE0 ? 0xA0 : 0x80;
+		unsigned char high = lead == 0xED ? 0x9F : 0xBF;
+		if (length >= 3 && data[1] >= low && data[1] <= high && (data[2] & 0xC0) == 0x80)
+			return 3;
+	} else if (lead >= 0xF0 && lead <= 0xF4) {
+		unsigned char low = lead == 0xF0 ? 0x90 : 0x80;
+		unsigned char high = lead == 0xF4 ? 0x8F : 0xBF;
+		if (length >= 4 && data[1] >= low && data[1] <= high && (data[2] & 0xC0) == 0x80 && (data[3] & 0xC0) == 0x80)
+			return 4;
+	}
+
+	return 0;
+}
+
+size_t utf8_validate(const char *data, size_t length) {
+	if (data == NULL) {
+		fprintf(stderr, "[utf8_validate] Cannot validate a char pointer that points to NULL.\n");
+		return 0;
+	}
+
+	const unsigned char *bytes = (const unsigned char*) data;
+	size_t i = 0;
+	while (i < length) {
+		i += utf8_ascii_prefix(bytes + i, length - i);
+		if (i == length)
+			break;
+
+		size_t sequence_length = utf8_sequence_length(bytes + i, length - i);
+		if (sequence_length == 0)
+			return i;
+		i += sequence_length;
+	}
+
+	return length;
+}
+
+size_t utf8_sanitize(const char *data, size_t length, struct Buffer *output) {
+	if (data == NULL || output == NULL) {
+		fprintf(stderr, "[utf8_sanitize] Cannot sanitize using a data or output pointer that points to NULL.\n");
+		return 0;
+	}
+
+	static const char replacement[] = "\xEF\xBF\xBD";
+	size_t replacements = 0;
+	size_t i = 0;
+	while (i < length) {
+		size_t valid_length = utf8_validate(data + i, length - i);
+		if (buffer_append(output, data + i, valid_length) != BUFFER_ERROR_NONE)
+			return replacements;
+		i += valid_length;
+		if (i == length)
+			break;
+
+		// Replace the maximal subpart: the lead byte plus the continuation bytes it accepted
+		unsigned char lead = data[i];
+		size_t needed = lead >= 0xF0 ? 4 : (lead >= 0xE0 ? 3 : 2);
+		unsigned char low = lead == 0xE0 ? 0xA0 : (lead == 0xF0 ? 0x90 : 0x80);
+		unsigned char high = lead == 0xED ? 0x9F : (lead == 0xF4 ? 0x8F : 0xBF);
+		size_t skip = 1;
+		if (lead >= 0xC2 && lead <= 0xF4) {
+			while (skip < needed && i + skip < length) {
+				unsigned char byte = data[i + skip];
+				if (skip == 1 ? (byte < low || byte > high) : (byte & 0xC0) != 0x80)
+					break;
+				skip++;
+			}
+		}
+		if (buffer_append(output, replacement, sizeof(replacement) - 1) != BUFFER_ERROR_NONE)
+			return replacements;
+		replacements++;
+		i += skip;
+	}
+
+	return replacements;
+}
@@ -0,0 +1,16 @@
+#ifndef wpgutf8_h
+#define wpgutf8_h
+#include <stdbool.h>
+#include <stddef.h>
+#include "wpgbuffer.h"
+
+// Returns the offset of the first byte of the first invalid UTF-8 sequence in
+// data (overlong forms, surrogates, code points past U+10FFFF and truncated
+// sequences are all invalid), or length if data is entirely valid. Runs of
+// ASCII are skipped 32 bytes at a time.
+size_t utf8_validate(const char *data, size_t length);
+
+// Appends data to output with every invalid sequence replaced by U+FFFD and
+// returns the number of replacements made.
+size_t utf8_sanitize(const char *data, size_t length, struct Buffer *output);
+#endif